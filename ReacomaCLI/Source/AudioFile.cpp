@@ -0,0 +1,186 @@
+#include "AudioFile.h"
+#include "VectorBufferAdaptor.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+constexpr uint16_t kFormatPCM = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+uint32_t ReadLE(const unsigned char *bytes, int count) {
+    uint32_t value = 0;
+    for (int i = count - 1; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+void WriteLE(std::ofstream &out, uint32_t value, int count) {
+    for (int i = 0; i < count; ++i) {
+        out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+float DecodeSample(const unsigned char *bytes, uint16_t format,
+                   int bytesPerSample) {
+    if (format == kFormatFloat) {
+        if (bytesPerSample == 4) {
+            float value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        double value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return static_cast<float>(value);
+    }
+
+    switch (bytesPerSample) {
+    case 2:
+        return static_cast<int16_t>(ReadLE(bytes, 2)) / 32768.0f;
+    case 3: {
+        int32_t value = static_cast<int32_t>(ReadLE(bytes, 3) << 8) >> 8;
+        return value / 8388608.0f;
+    }
+    default:
+        return static_cast<int32_t>(ReadLE(bytes, 4)) / 2147483648.0f;
+    }
+}
+} // namespace
+
+bool ReadWav(const std::filesystem::path &path, AudioFile &file,
+             std::string &error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open file";
+        return false;
+    }
+
+    unsigned char header[12];
+    if (!in.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+        std::memcmp(header, "RIFF", 4) || std::memcmp(header + 8, "WAVE", 4)) {
+        error = "not a WAV file";
+        return false;
+    }
+
+    uint16_t format = 0;
+    int numChannels = 0;
+    int bitsPerSample = 0;
+    std::vector<unsigned char> data;
+
+    unsigned char chunkHeader[8];
+    while (in.read(reinterpret_cast<char *>(chunkHeader), 8)) {
+        const uint32_t size = ReadLE(chunkHeader + 4, 4);
+        if (!std::memcmp(chunkHeader, "fmt ", 4)) {
+            std::vector<unsigned char> fmt(size);
+            if (size < 16 || !in.read(reinterpret_cast<char *>(fmt.data()),
+                                      size)) {
+                error = "malformed format chunk";
+                return false;
+            }
+            format = static_cast<uint16_t>(ReadLE(fmt.data(), 2));
+            numChannels = static_cast<int>(ReadLE(fmt.data() + 2, 2));
+            file.sampleRate = static_cast<int>(ReadLE(fmt.data() + 4, 4));
+            bitsPerSample = static_cast<int>(ReadLE(fmt.data() + 14, 2));
+            if (format == kFormatExtensible && size >= 26) {
+                format = static_cast<uint16_t>(ReadLE(fmt.data() + 24, 2));
+            }
+        } else if (!std::memcmp(chunkHeader, "data", 4)) {
+            data.resize(size);
+            in.read(reinterpret_cast<char *>(data.data()), size);
+            data.resize(static_cast<size_t>(in.gcount()));
+        } else {
+            in.seekg(size, std::ios::cur);
+        }
+        // Chunks are padded to an even size.
+        if (size & 1) {
+            in.seekg(1, std::ios::cur);
+        }
+    }
+
+    const int bytesPerSample = bitsPerSample / 8;
+    const bool supported =
+        (format == kFormatPCM &&
+         (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32)) ||
+        (format == kFormatFloat &&
+         (bitsPerSample == 32 || bitsPerSample == 64));
+    if (!supported || numChannels <= 0 || file.sampleRate <= 0) {
+        error = "unsupported WAV format";
+        return false;
+    }
+
+    const size_t frameBytes = static_cast<size_t>(bytesPerSample) * numChannels;
+    const size_t numFrames = data.size() / frameBytes;
+    if (numFrames == 0) {
+        error = "no audio";
+        return false;
+    }
+
+    std::vector<float> interleaved(numFrames * numChannels);
+    for (size_t i = 0; i < interleaved.size(); ++i) {
+        interleaved[i] =
+            DecodeSample(&data[i * bytesPerSample], format, bytesPerSample);
+    }
+
+    file.buffer = std::make_shared<fluid::VectorBufferAdaptor>(
+        std::move(interleaved), numChannels,
+        static_cast<fluid::index>(numFrames), file.sampleRate);
+    return true;
+}
+
+bool WriteWav(const std::filesystem::path &path,
+              const fluid::client::BufferAdaptor &buffer, int sampleRate,
+              std::string &error) {
+    fluid::client::BufferAdaptor::ReadAccess reader(&buffer);
+    if (!reader.exists() || !reader.valid()) {
+        error = "no output to write";
+        return false;
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        error = "cannot create " + path.string();
+        return false;
+    }
+
+    const auto numChannels = static_cast<uint32_t>(reader.numChans());
+    const auto numFrames = static_cast<uint32_t>(reader.numFrames());
+    const uint32_t dataBytes = numFrames * numChannels * 4;
+
+    out.write("RIFF", 4);
+    WriteLE(out, 36 + dataBytes, 4);
+    out.write("WAVE", 4);
+    out.write("fmt ", 4);
+    WriteLE(out, 16, 4);
+    WriteLE(out, kFormatFloat, 2);
+    WriteLE(out, numChannels, 2);
+    WriteLE(out, static_cast<uint32_t>(sampleRate), 4);
+    WriteLE(out, static_cast<uint32_t>(sampleRate) * numChannels * 4, 4);
+    WriteLE(out, numChannels * 4, 2);
+    WriteLE(out, 32, 2);
+    out.write("data", 4);
+    WriteLE(out, dataBytes, 4);
+
+    std::vector<fluid::FluidTensorView<const float, 1>> channels;
+    for (uint32_t c = 0; c < numChannels; ++c) {
+        channels.push_back(reader.samps(c));
+    }
+
+    std::vector<float> frame(numChannels);
+    for (uint32_t i = 0; i < numFrames; ++i) {
+        for (uint32_t c = 0; c < numChannels; ++c) {
+            frame[c] = channels[c](i);
+        }
+        out.write(reinterpret_cast<const char *>(frame.data()),
+                  frame.size() * sizeof(float));
+    }
+
+    if (!out) {
+        error = "failed writing " + path.string();
+        return false;
+    }
+    return true;
+}
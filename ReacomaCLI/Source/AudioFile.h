@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/clients/common/BufferAdaptor.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+// Minimal WAV support for the command-line tool: PCM at 16, 24 or 32 bits
+// and IEEE float at 32 or 64 bits are read; output is always 32-bit float.
+struct AudioFile {
+    std::shared_ptr<const fluid::client::BufferAdaptor> buffer;
+    int sampleRate = 0;
+};
+
+bool ReadWav(const std::filesystem::path &path, AudioFile &file,
+             std::string &error);
+bool WriteWav(const std::filesystem::path &path,
+              const fluid::client::BufferAdaptor &buffer, int sampleRate,
+              std::string &error);
@@ -0,0 +1,9 @@
+// The algorithm classes are compiled against the REAPER API. Defining the
+// function pointers here, all null, lets them link without REAPER; only the
+// project-facing paths use them and the command-line tool never takes those.
+#define REAPERAPI_IMPLEMENT
+
+#include "ReacomaExtension.h"
+
+#include "wdltypes.h"
+#include "reaper_plugin_functions.h"
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "IPlugParameter.h"
+
+#include "Algorithms/NMFBases.h"
+#include "Algorithms/SliceCache.h"
+#include "Algorithms/Spectrogram.h"
+
+#include <memory>
+#include <vector>
+
+using namespace iplug;
+
+// Stands in for the REAPER extension when the algorithm classes are built
+// into the command-line tool. It hosts their parameters and caches and
+// nothing else; the REAPER API is never called on this path.
+class ReacomaExtension {
+  public:
+    int NParams() const { return static_cast<int>(mParams.size()); }
+    void AddParam() { mParams.push_back(std::make_unique<IParam>()); }
+    IParam *GetParam(int idx) { return mParams[idx].get(); }
+
+    SliceCache &GetSliceCache() { return mSliceCache; }
+    SpectrogramCache &GetSpectrogramCache() { return mSpectrogramCache; }
+    NMFBases &GetNMFBases() { return mNMFBases; }
+
+  private:
+    std::vector<std::unique_ptr<IParam>> mParams;
+    SliceCache mSliceCache;
+    SpectrogramCache mSpectrogramCache;
+    NMFBases mNMFBases;
+};
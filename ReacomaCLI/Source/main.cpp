@@ -0,0 +1,525 @@
+#include "AudioFile.h"
+#include "ReacomaExtension.h"
+
+#include "Algorithms/AmpGateAlgorithm.h"
+#include "Algorithms/AmpSliceAlgorithm.h"
+#include "Algorithms/DescriptorAlgorithm.h"
+#include "Algorithms/HPSSAlgorithm.h"
+#include "Algorithms/NMFAlgorithm.h"
+#include "Algorithms/NoveltySliceAlgorithm.h"
+#include "Algorithms/OnsetSliceAlgorithm.h"
+#include "Algorithms/SinesAlgorithm.h"
+#include "Algorithms/SliceIndex.h"
+#include "Algorithms/SliceMapping.h"
+#include "Algorithms/TransientAlgorithm.h"
+#include "Algorithms/TransientSliceAlgorithm.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+struct AlgorithmEntry {
+    const char *name;
+    std::function<std::unique_ptr<IAlgorithm>(ReacomaExtension *)> create;
+    // Writes (start, end) pairs rather than single slices.
+    bool gates = false;
+    // Writes a descriptor table of the slices another algorithm finds.
+    bool describes = false;
+};
+
+template <typename T> std::unique_ptr<IAlgorithm> Make(ReacomaExtension *host) {
+    return std::make_unique<T>(host);
+}
+
+const AlgorithmEntry kAlgorithms[] = {
+    {"novelty-slice", Make<NoveltySliceAlgorithm>},
+    {"onset-slice", Make<OnsetSliceAlgorithm>},
+    {"transient-slice", Make<TransientSliceAlgorithm>},
+    {"amp-slice", Make<AmpSliceAlgorithm>},
+    {"amp-gate", Make<AmpGateAlgorithm>, true},
+    {"hpss", Make<HPSSAlgorithm>},
+    {"nmf", Make<NMFAlgorithm>},
+    {"transients", Make<TransientAlgorithm>},
+    {"sines", Make<SinesAlgorithm>},
+    {"describe", Make<DescriptorAlgorithm>, false, true},
+};
+
+struct Options {
+    const AlgorithmEntry *algorithm = nullptr;
+    std::vector<std::pair<std::string, double>> params;
+    std::string format = "csv";
+    std::filesystem::path outputDir;
+    unsigned int jobs = 0;
+    double curveRate = 0.0;
+    double minGap = 0.0;
+    const AlgorithmEntry *slicesFrom = nullptr;
+    bool listParams = false;
+    std::vector<std::filesystem::path> files;
+};
+
+void PrintUsage() {
+    std::fprintf(
+        stderr,
+        "usage: reacoma-cli <algorithm> [options] <file.wav>...\n"
+        "\n"
+        "algorithms: novelty-slice, onset-slice, transient-slice, amp-slice,\n"
+        "            amp-gate, hpss, nmf, transients, sines, describe\n"
+        "\n"
+        "options:\n"
+        "  --param NAME=VALUE  set a parameter, named as in the UI\n"
+        "  --list-params       print the algorithm's parameters and exit\n"
+        "  --format csv|json|rslc|rdsc\n"
+        "                      output format (default csv); rslc is the\n"
+        "                      binary slice index the extension writes as\n"
+        "                      sidecar and is only available for slicers,\n"
+        "                      rdsc the binary table written by describe\n"
+        "  --curve-rate N      keep the detection curve at N points per\n"
+        "                      second in rslc output\n"
+        "  --min-gap SECONDS   drop slices closer than this to the previous\n"
+        "                      one\n"
+        "  --slices-from NAME  slicer whose slices describe reduces over,\n"
+        "                      run with its default parameters (default:\n"
+        "                      the whole file is one slice)\n"
+        "  --output DIR        where results go (default: beside each input)\n"
+        "  --jobs N            files processed at once (default: one per "
+        "core)\n");
+}
+
+bool ParseOptions(int argc, char **argv, Options &options) {
+    if (argc < 2)
+        return false;
+
+    for (const AlgorithmEntry &entry : kAlgorithms) {
+        if (std::string(argv[1]) == entry.name) {
+            options.algorithm = &entry;
+        }
+    }
+    if (!options.algorithm)
+        return false;
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--param" && hasValue) {
+            const std::string param = argv[++i];
+            const size_t equals = param.find('=');
+            if (equals == std::string::npos)
+                return false;
+            options.params.emplace_back(
+                param.substr(0, equals),
+                std::atof(param.c_str() + equals + 1));
+        } else if (arg == "--format" && hasValue) {
+            options.format = argv[++i];
+            if (options.format != "csv" && options.format != "json" &&
+                options.format != "rslc" && options.format != "rdsc")
+                return false;
+        } else if (arg == "--output" && hasValue) {
+            options.outputDir = argv[++i];
+        } else if (arg == "--curve-rate" && hasValue) {
+            options.curveRate = std::atof(argv[++i]);
+        } else if (arg == "--min-gap" && hasValue) {
+            options.minGap = std::atof(argv[++i]);
+        } else if (arg == "--slices-from" && hasValue) {
+            const std::string name = argv[++i];
+            for (const AlgorithmEntry &entry : kAlgorithms) {
+                if (name == entry.name) {
+                    options.slicesFrom = &entry;
+                }
+            }
+            if (!options.slicesFrom)
+                return false;
+        } else if (arg == "--jobs" && hasValue) {
+            options.jobs = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (arg == "--list-params") {
+            options.listParams = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            options.files.emplace_back(arg);
+        }
+    }
+    return options.listParams || !options.files.empty();
+}
+
+// Each file gets its own host, so workers never share parameters or caches.
+std::unique_ptr<IAlgorithm> CreateAlgorithm(const Options &options,
+                                            ReacomaExtension &host,
+                                            std::string &error) {
+    auto algorithm = options.algorithm->create(&host);
+    algorithm->RegisterParameters();
+    algorithm->SnapshotParams();
+    SliceOutput sliceOutput;
+    sliceOutput.curveRate = options.curveRate;
+    algorithm->SetSliceOutput(sliceOutput);
+    for (const auto &[name, value] : options.params) {
+        if (!algorithm->SetParamValue(name, value)) {
+            error = "unknown parameter \"" + name + "\"";
+            return nullptr;
+        }
+    }
+    return algorithm;
+}
+
+void ListParams(const Options &options) {
+    ReacomaExtension host;
+    auto algorithm = options.algorithm->create(&host);
+    algorithm->RegisterParameters();
+    for (int i = 0; i < algorithm->GetNumAlgorithmParams(); ++i) {
+        const IParam *param = host.GetParam(algorithm->GetGlobalParamIdx(i));
+        std::printf("%s = %g (%g to %g)\n", param->GetName(),
+                    param->GetDefault(), param->GetMin(), param->GetMax());
+    }
+}
+
+// A JSON string literal, escaped.
+std::string JsonString(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        switch (c) {
+        case '"':
+            quoted += "\\\"";
+            break;
+        case '\\':
+            quoted += "\\\\";
+            break;
+        case '\n':
+            quoted += "\\n";
+            break;
+        case '\r':
+            quoted += "\\r";
+            break;
+        case '\t':
+            quoted += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                quoted += escaped;
+            } else {
+                quoted += c;
+            }
+        }
+    }
+    return quoted + "\"";
+}
+
+// JSON has no NaN or infinity, so those are written as null.
+std::string JsonNumber(double value) {
+    if (!std::isfinite(value))
+        return "null";
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+// Strengths are written when the slicer reports them.
+bool WriteSlices(const std::filesystem::path &path, SliceIndex index,
+                 const std::string &format, const std::string &source) {
+    if (format == "rslc")
+        return index.Write(path, false);
+
+    const std::vector<fluid::index> &slices = index.frames;
+    const int sampleRate = index.sampleRate;
+    const bool hasStrengths = index.strengths.size() == slices.size() &&
+                              !slices.empty();
+    std::ofstream out(path);
+    if (format == "json") {
+        out << "{\"file\": " << JsonString(source)
+            << ", \"sampleRate\": " << sampleRate << ", \"slices\": [";
+        for (size_t i = 0; i < slices.size(); ++i) {
+            out << (i ? ", " : "") << "{\"frame\": " << slices[i]
+                << ", \"seconds\": "
+                << static_cast<double>(slices[i]) / sampleRate;
+            if (hasStrengths) {
+                out << ", \"strength\": " << JsonNumber(index.strengths[i]);
+            }
+            out << "}";
+        }
+        out << "]}\n";
+    } else {
+        out << (hasStrengths ? "frame,seconds,strength\n" : "frame,seconds\n");
+        for (size_t i = 0; i < slices.size(); ++i) {
+            out << slices[i] << ","
+                << static_cast<double>(slices[i]) / sampleRate;
+            if (hasStrengths) {
+                out << "," << index.strengths[i];
+            }
+            out << "\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+bool WriteGates(const std::filesystem::path &path,
+                const std::vector<std::pair<fluid::index, fluid::index>> &gates,
+                int sampleRate, const std::string &format,
+                const std::string &source) {
+    std::ofstream out(path);
+    if (format == "json") {
+        out << "{\"file\": " << JsonString(source)
+            << ", \"sampleRate\": " << sampleRate << ", \"gates\": [";
+        for (size_t i = 0; i < gates.size(); ++i) {
+            out << (i ? ", " : "") << "{\"start\": " << gates[i].first
+                << ", \"end\": " << gates[i].second << "}";
+        }
+        out << "]}\n";
+    } else {
+        out << "start,end,startSeconds,endSeconds\n";
+        for (const auto &[start, end] : gates) {
+            out << start << "," << end << ","
+                << static_cast<double>(start) / sampleRate << ","
+                << static_cast<double>(end) / sampleRate << "\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+bool WriteDescriptors(const std::filesystem::path &path,
+                      const DescriptorTable &table, const std::string &format,
+                      const std::string &source) {
+    if (format == "rdsc")
+        return table.Write(path, false);
+
+    std::ofstream out(path);
+    if (format == "json") {
+        out << "{\"file\": " << JsonString(source)
+            << ", \"sampleRate\": " << table.sampleRate << ", \"slices\": [";
+        for (size_t row = 0; row < table.NumRows(); ++row) {
+            out << (row ? ", " : "") << "{\"start\": " << table.starts[row]
+                << ", \"end\": " << table.ends[row];
+            for (size_t i = 0; i < table.columns.size(); ++i) {
+                out << ", " << JsonString(table.columnNames[i]) << ": "
+                    << JsonNumber(table.columns[i][row]);
+            }
+            out << "}";
+        }
+        out << "]}\n";
+    } else {
+        out << "start,end";
+        for (const std::string &name : table.columnNames) {
+            out << "," << name;
+        }
+        out << "\n";
+        for (size_t row = 0; row < table.NumRows(); ++row) {
+            out << table.starts[row] << "," << table.ends[row];
+            for (const std::vector<float> &column : table.columns) {
+                out << "," << column[row];
+            }
+            out << "\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+// Runs the slicer named by --slices-from over the same audio, on its default
+// parameters, and returns the slices with the start and end of the file.
+bool FindSliceBoundaries(const Options &options, const AudioFile &audio,
+                         std::vector<fluid::index> &boundaries,
+                         std::string &error) {
+    const fluid::index endFrame = audio.buffer->numFrames();
+    boundaries = {0};
+    if (options.slicesFrom) {
+        ReacomaExtension host;
+        auto slicer = options.slicesFrom->create(&host);
+        slicer->RegisterParameters();
+        slicer->SnapshotParams();
+        if (options.slicesFrom->gates || options.slicesFrom->describes ||
+            !slicer->GetAudioOutputNames().empty()) {
+            error = std::string(options.slicesFrom->name) + " is not a slicer";
+            return false;
+        }
+        if (!slicer->StartProcessAudioAsync(audio.buffer, audio.sampleRate)) {
+            error = "could not start slicing";
+            return false;
+        }
+        while (!slicer->IsFinished()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        if (!slicer->Succeeded()) {
+            error = "slicing failed";
+            return false;
+        }
+        std::vector<fluid::index> slices = slicer->GetSliceFrames();
+        SliceMapping::EnforceMinGap(
+            slices, std::llround(options.minGap * audio.sampleRate), nullptr);
+        for (fluid::index slice : slices) {
+            if (slice > boundaries.back() && slice < endFrame) {
+                boundaries.push_back(slice);
+            }
+        }
+    }
+    boundaries.push_back(endFrame);
+    return true;
+}
+
+bool ProcessFile(const Options &options, const std::filesystem::path &input,
+                 std::string &summary, std::string &error) {
+    AudioFile audio;
+    if (!ReadWav(input, audio, error))
+        return false;
+
+    ReacomaExtension host;
+    auto algorithm = CreateAlgorithm(options, host, error);
+    if (!algorithm)
+        return false;
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!algorithm->StartProcessAudioAsync(audio.buffer, audio.sampleRate)) {
+        error = "could not start processing";
+        return false;
+    }
+    while (!algorithm->IsFinished()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    if (!algorithm->Succeeded()) {
+        error = "processing failed";
+        return false;
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+
+    const std::filesystem::path outputDir =
+        options.outputDir.empty() ? input.parent_path() : options.outputDir;
+    const std::string stem =
+        input.stem().string() + "_" + options.algorithm->name;
+
+    const std::vector<std::string> outputs = algorithm->GetAudioOutputNames();
+    if (options.format == "rdsc" && !options.algorithm->describes) {
+        error = "only describe writes rdsc";
+        return false;
+    }
+    if (options.algorithm->describes) {
+        if (options.format == "rslc") {
+            error = "descriptors cannot be written as rslc";
+            return false;
+        }
+        std::vector<fluid::index> boundaries;
+        if (!FindSliceBoundaries(options, audio, boundaries, error))
+            return false;
+        const DescriptorTable table = algorithm->DescribeSlices(boundaries);
+        const auto path = outputDir / (stem + "." + options.format);
+        if (!WriteDescriptors(path, table, options.format, input.string())) {
+            error = "failed writing " + path.string();
+            return false;
+        }
+        summary = std::to_string(table.NumRows()) + " slices described";
+    } else if (options.algorithm->gates) {
+        const auto gates = algorithm->GetGateFrames();
+        const auto path = outputDir / (stem + "." + options.format);
+        if (options.format == "rslc") {
+            error = "gates cannot be written as rslc";
+            return false;
+        }
+        if (!WriteGates(path, gates, audio.sampleRate, options.format,
+                        input.string())) {
+            error = "failed writing " + path.string();
+            return false;
+        }
+        summary = std::to_string(gates.size()) + " gates";
+    } else if (outputs.empty()) {
+        SliceIndex index;
+        index.sampleRate = audio.sampleRate;
+        index.endFrame = audio.buffer->numFrames();
+        index.frames = algorithm->GetSliceFrames();
+        index.strengths = algorithm->GetSliceStrengths();
+        index.curve = algorithm->GetDetectionCurve();
+        SliceMapping::EnforceMinGap(
+            index.frames, std::llround(options.minGap * audio.sampleRate),
+            &index.strengths);
+        const auto path = outputDir / (stem + "." + options.format);
+        if (!WriteSlices(path, index, options.format, input.string())) {
+            error = "failed writing " + path.string();
+            return false;
+        }
+        summary = std::to_string(index.frames.size()) + " slices";
+    } else {
+        for (const std::string &name : outputs) {
+            const StageAudio output = algorithm->GetAudioOutput(name);
+            if (!output.buffer ||
+                !WriteWav(outputDir / (stem + "_" + name + ".wav"),
+                          *output.buffer, audio.sampleRate, error))
+                return false;
+        }
+        summary = std::to_string(outputs.size()) + " stems";
+    }
+
+    const double duration =
+        static_cast<double>(audio.buffer->numFrames()) / audio.sampleRate;
+    char timing[96];
+    std::snprintf(timing, sizeof(timing), " in %.3f s (%.1fx realtime)",
+                  seconds, seconds > 0.0 ? duration / seconds : 0.0);
+    summary += timing;
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    if (options.listParams) {
+        ListParams(options);
+        return 0;
+    }
+
+    if (!options.outputDir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(options.outputDir, error);
+    }
+
+    unsigned int jobs = options.jobs ? options.jobs
+                                     : std::thread::hardware_concurrency();
+    jobs = std::max(1U, std::min<unsigned int>(jobs, options.files.size()));
+
+    std::atomic<size_t> nextFile{0};
+    std::atomic<int> failures{0};
+    std::mutex outputMutex;
+
+    auto worker = [&]() {
+        for (size_t i = nextFile++; i < options.files.size(); i = nextFile++) {
+            const std::filesystem::path &file = options.files[i];
+            std::string summary;
+            std::string error;
+            const bool ok = ProcessFile(options, file, summary, error);
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            if (ok) {
+                std::printf("%s: %s\n", file.string().c_str(),
+                            summary.c_str());
+            } else {
+                std::fprintf(stderr, "%s: %s\n", file.string().c_str(),
+                             error.c_str());
+                ++failures;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < jobs; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+// Cancels NMF part way through a long item and checks that the job stops
+// promptly and gives back the memory it was using.
+
+#include "ReacomaExtension.h"
+
+#include "Algorithms/NMFAlgorithm.h"
+#include "VectorBufferAdaptor.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+constexpr int kSampleRate = 44100;
+constexpr fluid::index kNumChannels = 2;
+constexpr double kSeconds = 180.0;
+constexpr auto kMaxCancelTime = std::chrono::milliseconds(100);
+
+size_t ResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages = 0;
+    size_t residentPages = 0;
+    statm >> totalPages >> residentPages;
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Two partials that swap levels every second, so there is something to
+// factorise.
+InputBufferT::type MakeLongItem() {
+    const auto numFrames = static_cast<fluid::index>(kSeconds * kSampleRate);
+    std::vector<float> data(numFrames * kNumChannels);
+    for (fluid::index i = 0; i < numFrames; ++i) {
+        const double time = i / static_cast<double>(kSampleRate);
+        const double swap = (static_cast<fluid::index>(time) % 2) ? 1.0 : 0.2;
+        const double sample = swap * std::sin(2 * M_PI * 220 * time) +
+                              (1.2 - swap) * std::sin(2 * M_PI * 1375 * time);
+        for (fluid::index c = 0; c < kNumChannels; ++c) {
+            data[i * kNumChannels + c] = static_cast<float>(0.4 * sample);
+        }
+    }
+    return InputBufferT::type(std::make_shared<fluid::VectorBufferAdaptor>(
+        std::move(data), kNumChannels, numFrames, kSampleRate));
+}
+} // namespace
+
+int main() {
+    const size_t baseline = ResidentBytes();
+
+    ReacomaExtension host;
+    NMFAlgorithm nmf(&host);
+    nmf.RegisterParameters();
+    nmf.SnapshotParams();
+    nmf.SetParamValue("Number of Components", 3);
+    nmf.SetParamValue("Number of Iterations", 1000);
+
+    auto audio = MakeLongItem();
+    if (!nmf.StartProcessAudioAsync(audio, kSampleRate)) {
+        std::fprintf(stderr, "NMF did not start\n");
+        return 1;
+    }
+    audio = nullptr;
+
+    // Far enough in that the factorisation itself is running.
+    while (!nmf.IsFinished() && nmf.GetProgress() < 0.05) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    if (nmf.IsFinished()) {
+        std::fprintf(stderr, "NMF finished before it could be cancelled\n");
+        return 1;
+    }
+    const size_t running = ResidentBytes();
+
+    const auto cancelled = std::chrono::steady_clock::now();
+    nmf.Cancel();
+    while (!nmf.IsFinished()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto cancelTime = std::chrono::steady_clock::now() - cancelled;
+    const size_t after = ResidentBytes();
+
+    const auto cancelMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(cancelTime);
+    std::printf("cancelled in %lld ms; resident %zu MB before the job, %zu MB "
+                "while running, %zu MB after cancelling\n",
+                static_cast<long long>(cancelMs.count()), baseline >> 20,
+                running >> 20, after >> 20);
+
+    bool passed = true;
+    if (cancelTime >= kMaxCancelTime) {
+        std::fprintf(stderr, "cancelling took longer than %lld ms\n",
+                     static_cast<long long>(kMaxCancelTime.count()));
+        passed = false;
+    }
+    // The source and the outputs make up most of what the job holds, and
+    // both are gone once it is cancelled.
+    if (after >= baseline + (running - baseline) / 2) {
+        std::fprintf(stderr, "cancelling did not release the job's memory\n");
+        passed = false;
+    }
+    return passed ? 0 : 1;
+}
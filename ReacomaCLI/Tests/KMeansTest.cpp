@@ -0,0 +1,79 @@
+// Checks that the columnar k-means finds well separated groups, whatever
+// the number of threads.
+
+#include "Algorithms/ColumnarKMeans.h"
+
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+constexpr size_t kNumGroups = 4;
+constexpr size_t kRowsPerGroup = 3000;
+constexpr size_t kNumDims = 5;
+
+bool Check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "failed: %s\n", what);
+    }
+    return condition;
+}
+
+// Groups of rows scattered tightly around centres far apart, interleaved
+// so that every part of the rows holds all of them.
+ColumnarKMeans::Columns MakeGroups() {
+    std::mt19937 random(7);
+    std::normal_distribution<float> scatter(0.0f, 0.1f);
+    ColumnarKMeans::Columns columns(kNumDims);
+    for (size_t row = 0; row < kNumGroups * kRowsPerGroup; ++row) {
+        const size_t group = row % kNumGroups;
+        for (size_t d = 0; d < kNumDims; ++d) {
+            const float centre = (d % kNumGroups == group) ? 10.0f : 0.0f;
+            columns[d].push_back(centre + scatter(random));
+        }
+    }
+    return columns;
+}
+
+bool TestFindsGroups() {
+    const ColumnarKMeans::Columns columns = MakeGroups();
+    const std::vector<int> clusters = ColumnarKMeans::Cluster(
+        columns, static_cast<int>(kNumGroups), 100, 1);
+    bool sameGroupSameCluster = true;
+    std::set<int> groupClusters;
+    for (size_t row = 0; row < clusters.size(); ++row) {
+        sameGroupSameCluster = sameGroupSameCluster &&
+                               clusters[row] == clusters[row % kNumGroups];
+        groupClusters.insert(clusters[row]);
+    }
+    return Check(clusters.size() == columns[0].size(), "a cluster per row") &&
+           Check(sameGroupSameCluster, "each group in one cluster") &&
+           Check(groupClusters.size() == kNumGroups,
+                 "each group in its own cluster");
+}
+
+bool TestThreadsAgree() {
+    const ColumnarKMeans::Columns columns = MakeGroups();
+    return Check(ColumnarKMeans::Cluster(columns, 6, 100, 1) ==
+                     ColumnarKMeans::Cluster(columns, 6, 100, 4),
+                 "same clusters on one thread and four");
+}
+
+bool TestTooFewRows() {
+    const ColumnarKMeans::Columns columns = {{1.0f, 2.0f}, {3.0f, 4.0f}};
+    return Check(ColumnarKMeans::Cluster(columns, 1, 100) ==
+                     std::vector<int>{0, 0},
+                 "a single cluster") &&
+           Check(ColumnarKMeans::Cluster(columns, 8, 100).size() == 2,
+                 "more clusters than rows");
+}
+} // namespace
+
+int main() {
+    bool passed = true;
+    passed = TestFindsGroups() && passed;
+    passed = TestThreadsAgree() && passed;
+    passed = TestTooFewRows() && passed;
+    return passed ? 0 : 1;
+}
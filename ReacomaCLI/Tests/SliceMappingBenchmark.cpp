@@ -0,0 +1,76 @@
+// Times slice mapping over a million slices, the scale of a long file cut
+// finely, to keep it well clear of the main thread's budget.
+
+#include "Algorithms/SliceMapping.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+constexpr int kSampleRate = 48000;
+constexpr size_t kNumSlices = 1000000;
+constexpr int kRepeats = 20;
+
+// Median of the repeats, in milliseconds.
+template <typename Work> double Time(Work work) {
+    std::vector<double> times;
+    for (int i = 0; i < kRepeats; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        work();
+        times.push_back(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+} // namespace
+
+int main() {
+    // Slices every 97 frames or so, unevenly, over about 34 minutes.
+    std::vector<fluid::index> slices(kNumSlices);
+    fluid::index frame = 0;
+    for (size_t i = 0; i < kNumSlices; ++i) {
+        frame += 60 + static_cast<fluid::index>((i * 7919) % 75);
+        slices[i] = frame;
+    }
+    std::vector<float> strengths(kNumSlices, 1.0f);
+
+    SliceMapping whole;
+    whole.sampleRate = kSampleRate;
+    whole.itemLength = static_cast<double>(frame + 1) / kSampleRate;
+
+    SliceMapping spaced = whole;
+    spaced.playrate = 1.5;
+    spaced.itemLength /= spaced.playrate;
+    spaced.minGap = 0.005;
+
+    SliceMapping section = whole;
+    section.takeStartFrame = frame / 4;
+    section.itemLength /= 2;
+
+    size_t kept = 0;
+    const double wholeMs =
+        Time([&]() { kept = whole.Map(slices).itemTimes.size(); });
+    std::printf("map, whole item:           %8.2f ms, %zu slices\n", wholeMs,
+                kept);
+    const double spacedMs =
+        Time([&]() { kept = spaced.Map(slices).itemTimes.size(); });
+    std::printf("map, playrate and min gap: %8.2f ms, %zu slices\n", spacedMs,
+                kept);
+    const double sectionMs =
+        Time([&]() { kept = section.Map(slices).itemTimes.size(); });
+    std::printf("map, half the source:      %8.2f ms, %zu slices\n",
+                sectionMs, kept);
+    const double gapMs = Time([&]() {
+        std::vector<fluid::index> copy = slices;
+        std::vector<float> copyStrengths = strengths;
+        SliceMapping::EnforceMinGap(copy, 240, &copyStrengths);
+        kept = copy.size();
+    });
+    std::printf("min gap with strengths:    %8.2f ms, %zu slices\n", gapMs,
+                kept);
+    return 0;
+}
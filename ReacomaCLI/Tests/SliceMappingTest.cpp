@@ -0,0 +1,146 @@
+// Checks how slices in source frames become marker positions on an item.
+
+#include "Algorithms/SliceMapping.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+constexpr int kSampleRate = 1000;
+
+bool Check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "failed: %s\n", what);
+    }
+    return condition;
+}
+
+bool Near(const std::vector<double> &values,
+          const std::vector<double> &expected) {
+    if (values.size() != expected.size())
+        return false;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (std::abs(values[i] - expected[i]) > 1e-9)
+            return false;
+    }
+    return true;
+}
+
+SliceMapping MakeMapping(fluid::index takeStartFrame, double itemLength,
+                         double playrate = 1.0, double minGap = 0.0) {
+    SliceMapping mapping;
+    mapping.takeStartFrame = takeStartFrame;
+    mapping.itemLength = itemLength;
+    mapping.playrate = playrate;
+    mapping.sampleRate = kSampleRate;
+    mapping.minGap = minGap;
+    return mapping;
+}
+
+// Only slices strictly inside the item are kept: one at the item's start
+// would duplicate its edge, and the item ends where its length runs out.
+bool TestClipsToItem() {
+    const auto positions =
+        MakeMapping(1000, 1.0).Map({500, 1000, 1200, 1999, 2000, 2500});
+    return Check(Near(positions.sourceTimes, {1.2, 1.999}),
+                 "clipped source times") &&
+           Check(Near(positions.itemTimes, {0.2, 0.999}),
+                 "clipped item times");
+}
+
+// The item's length is in project time, so at twice the speed it covers
+// twice as many source frames, and each of them half as much item time.
+bool TestPlayrate() {
+    const auto faster = MakeMapping(0, 1.0, 2.0).Map({500, 1500, 2000});
+    const auto slower = MakeMapping(0, 1.0, 0.5).Map({250, 499, 500, 1500});
+    return Check(Near(faster.sourceTimes, {0.5, 1.5}),
+                 "source times at playrate 2") &&
+           Check(Near(faster.itemTimes, {0.25, 0.75}),
+                 "item times at playrate 2") &&
+           Check(Near(slower.sourceTimes, {0.25, 0.499}),
+                 "source times at playrate 0.5") &&
+           Check(Near(slower.itemTimes, {0.5, 0.998}),
+                 "item times at playrate 0.5");
+}
+
+// The minimum gap is in item time and measured from the last slice kept.
+bool TestMinGap() {
+    const auto positions = MakeMapping(1000, 1.0, 1.0, 0.1)
+                               .Map({1100, 1150, 1199, 1200, 1350, 1449});
+    const auto faster =
+        MakeMapping(0, 1.0, 2.0, 0.1).Map({100, 250, 299, 300, 500});
+    return Check(Near(positions.sourceTimes, {1.1, 1.2, 1.35}),
+                 "minimum gap at playrate 1") &&
+           Check(Near(faster.sourceTimes, {0.1, 0.3, 0.5}),
+                 "minimum gap at playrate 2");
+}
+
+bool TestMinGapKeepsStrengths() {
+    std::vector<fluid::index> slices = {0, 5, 10, 12, 30};
+    std::vector<float> strengths = {1, 2, 3, 4, 5};
+    SliceMapping::EnforceMinGap(slices, 10, &strengths);
+    return Check(slices == std::vector<fluid::index>{0, 10, 30},
+                 "minimum gap slices") &&
+           Check(strengths == std::vector<float>{1, 3, 5},
+                 "minimum gap strengths");
+}
+
+// A section, and the reversed source REAPER makes by wrapping one, is
+// ingested through the take's own source, so its slices arrive in the
+// section's frames, counted from the start of the section and in the order
+// the take plays it. A take starting part way into it maps like any other.
+bool TestSectionedAndReversedTakes() {
+    // The section's first frame is the item's start, so a slice there is
+    // the item's edge rather than a slice.
+    const auto fromStart = MakeMapping(0, 2.0).Map({0, 10, 1999, 2000});
+    const auto intoSection = MakeMapping(300, 0.5).Map({250, 300, 301, 799});
+    return Check(Near(fromStart.itemTimes, {0.01, 1.999}),
+                 "take at the start of its section") &&
+           Check(Near(intoSection.sourceTimes, {0.301, 0.799}),
+                 "take part way into its section") &&
+           Check(Near(intoSection.itemTimes, {0.001, 0.499}),
+                 "item times part way into a section");
+}
+
+bool TestInvalidTake() {
+    SliceMapping noRate = MakeMapping(0, 1.0);
+    noRate.sampleRate = 0;
+    return Check(noRate.Map({100}).sourceTimes.empty(), "no sample rate") &&
+           Check(MakeMapping(0, 1.0, 0.0).Map({100}).sourceTimes.empty(),
+                 "no playrate");
+}
+
+// Stands in for a buffer channel of an analysis output.
+struct Channel {
+    std::vector<float> values;
+    fluid::index size() const {
+        return static_cast<fluid::index>(values.size());
+    }
+    float operator()(fluid::index i) const { return values[i]; }
+};
+
+bool TestCollectPositive() {
+    const Channel slices{{-1, 0, 512, 1024, 0, -1}};
+    const Channel strengths{{0, 0, 0.5f, 0.75f, 0, 0}};
+    std::vector<fluid::index> found;
+    std::vector<float> foundStrengths;
+    SliceMapping::CollectPositive(slices, found, &strengths, &foundStrengths);
+    return Check(found == std::vector<fluid::index>{512, 1024},
+                 "collected slices") &&
+           Check(foundStrengths == std::vector<float>{0.5f, 0.75f},
+                 "collected strengths");
+}
+} // namespace
+
+int main() {
+    bool passed = true;
+    passed = TestClipsToItem() && passed;
+    passed = TestPlayrate() && passed;
+    passed = TestMinGap() && passed;
+    passed = TestMinGapKeepsStrengths() && passed;
+    passed = TestSectionedAndReversedTakes() && passed;
+    passed = TestInvalidTake() && passed;
+    passed = TestCollectPositive() && passed;
+    return passed ? 0 : 1;
+}
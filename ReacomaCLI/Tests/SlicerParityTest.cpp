@@ -0,0 +1,167 @@
+// Checks that the slicers which run their own detection in a task find the
+// slices their FluCoMa clients find, on mono and on stereo material.
+
+#include "ReacomaExtension.h"
+
+#include "Algorithms/NoveltySliceAlgorithm.h"
+#include "Algorithms/OnsetSliceAlgorithm.h"
+#include "VectorBufferAdaptor.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr int kSampleRate = 44100;
+constexpr fluid::index kHopSize = 512;
+
+// Bursts of decaying noise, off the hop grid, over a quiet noise floor. The
+// second channel carries the same bursts at half level.
+InputBufferT::type MakeBursts(fluid::index numChannels) {
+    const fluid::index numFrames = 4 * kSampleRate;
+    const double burstTimes[] = {0.5, 1.31, 2.07, 2.93, 3.6};
+    std::vector<float> data(numFrames * numChannels);
+    unsigned int seed = 1;
+    auto noise = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / static_cast<double>(1 << 24) * 2.0 - 1.0;
+    };
+    for (fluid::index i = 0; i < numFrames; ++i) {
+        double level = 0.001;
+        for (double time : burstTimes) {
+            const double since = i / static_cast<double>(kSampleRate) - time;
+            if (since >= 0) {
+                level += std::exp(-since * 30.0);
+            }
+        }
+        const double sample = level * noise();
+        for (fluid::index c = 0; c < numChannels; ++c) {
+            data[i * numChannels + c] =
+                static_cast<float>(c == 0 ? sample : sample / 2);
+        }
+    }
+    return InputBufferT::type(std::make_shared<fluid::VectorBufferAdaptor>(
+        std::move(data), numChannels, numFrames, kSampleRate));
+}
+
+std::vector<fluid::index> RunSlicer(IAlgorithm &slicer,
+                                    InputBufferT::type audio) {
+    if (!slicer.StartProcessAudioAsync(audio, kSampleRate))
+        return {};
+    while (!slicer.IsFinished()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return slicer.GetSliceFrames();
+}
+
+// Runs a client the way the algorithms do, leaving its parameters to set.
+template <typename Client, typename SetParams>
+std::vector<fluid::index> RunClient(InputBufferT::type audio,
+                                    SetParams setParams) {
+    FluidContext context;
+    typename Client::ParamSetType params{Client::getParameterDescriptors(),
+                                         FluidDefaultAllocator()};
+    auto output = std::make_shared<MemoryBufferAdaptor>(1, 1, kSampleRate);
+    params.template set<0>(std::move(audio), nullptr);
+    params.template set<1>(LongT::type(0), nullptr);
+    params.template set<2>(LongT::type(-1), nullptr);
+    params.template set<3>(LongT::type(0), nullptr);
+    params.template set<4>(LongT::type(-1), nullptr);
+    params.template set<5>(BufferT::type(output), nullptr);
+    setParams(params);
+
+    Client client{params, context};
+    client.setSynchronous(true);
+    client.enqueue(params);
+    if (!client.process().ok())
+        return {};
+
+    std::vector<fluid::index> slices;
+    BufferAdaptor::ReadAccess reader(output.get());
+    SliceMapping::CollectPositive(reader.samps(0), slices);
+    return slices;
+}
+
+// Same slices, each within one hop of the client's.
+bool Matches(const char *name, const std::vector<fluid::index> &slices,
+             const std::vector<fluid::index> &expected) {
+    bool matches = !expected.empty() && slices.size() == expected.size();
+    for (size_t i = 0; matches && i < slices.size(); ++i) {
+        matches = std::abs(slices[i] - expected[i]) <= kHopSize;
+    }
+    if (!matches) {
+        std::fprintf(stderr, "%s: %zu slices, client found %zu\n", name,
+                     slices.size(), expected.size());
+        for (size_t i = 0; i < std::max(slices.size(), expected.size());
+             ++i) {
+            std::fprintf(stderr, "  %lld %lld\n",
+                         i < slices.size() ? (long long)slices[i] : -1LL,
+                         i < expected.size() ? (long long)expected[i] : -1LL);
+        }
+    }
+    return matches;
+}
+
+bool CheckOnsetSlice(fluid::index numChannels) {
+    ReacomaExtension host;
+    OnsetSliceAlgorithm slicer(&host);
+    slicer.RegisterParameters();
+    slicer.SnapshotParams();
+    slicer.SetParamValue("Metric", 0);
+    slicer.SetParamValue("Threshold", 0.2);
+
+    auto audio = MakeBursts(numChannels);
+    const auto slices = RunSlicer(slicer, audio);
+    const auto expected = RunClient<NRTThreadingOnsetSliceClient>(
+        audio, [](auto &params) {
+            params.template set<6>(LongT::type(0), nullptr);
+            params.template set<7>(FloatT::type(0.2), nullptr);
+            params.template set<8>(LongT::type(2), nullptr);
+            params.template set<9>(LongRuntimeMaxParam(5, 5), nullptr);
+            params.template set<10>(LongT::type(0), nullptr);
+            params.template set<11>(FFTParams(1024, kHopSize, 1024),
+                                    nullptr);
+        });
+    return Matches(numChannels > 1 ? "onset slice, stereo" : "onset slice",
+                   slices, expected);
+}
+
+bool CheckNoveltySlice(fluid::index numChannels) {
+    ReacomaExtension host;
+    NoveltySliceAlgorithm slicer(&host);
+    slicer.RegisterParameters();
+    slicer.SnapshotParams();
+    slicer.SetParamValue("Algorithm", NoveltySliceAlgorithm::kSpectrum);
+    slicer.SetParamValue("Threshold", 0.3);
+
+    auto audio = MakeBursts(numChannels);
+    const auto slices = RunSlicer(slicer, audio);
+    const auto expected = RunClient<NRTThreadingNoveltySliceClient>(
+        audio, [](auto &params) {
+            params.template set<6>(
+                LongT::type(NoveltySliceAlgorithm::kSpectrum), nullptr);
+            params.template set<7>(LongRuntimeMaxParam(3, 3), nullptr);
+            params.template set<8>(FloatT::type(0.3), nullptr);
+            params.template set<9>(LongRuntimeMaxParam(1, 1), nullptr);
+            params.template set<10>(LongT::type(2), nullptr);
+            params.template set<11>(FFTParams(1024, kHopSize, 1024),
+                                    nullptr);
+        });
+    return Matches(numChannels > 1 ? "novelty slice, stereo"
+                                   : "novelty slice",
+                   slices, expected);
+}
+} // namespace
+
+int main() {
+    bool passed = true;
+    for (fluid::index numChannels : {1, 2}) {
+        passed = CheckOnsetSlice(numChannels) && passed;
+        passed = CheckNoveltySlice(numChannels) && passed;
+    }
+    return passed ? 0 : 1;
+}
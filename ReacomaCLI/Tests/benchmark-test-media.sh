@@ -0,0 +1,34 @@
+#!/bin/sh
+# Times reacoma-cli algorithms on the WavPack files of the test project,
+# with the peak memory of each run when GNU time is installed. reacoma-cli
+# only reads WAV, so the files are unpacked with wvunpack first.
+#
+# usage: benchmark-test-media.sh <reacoma-cli> [algorithm...]
+# default algorithms: amp-slice onset-slice sines hpss
+
+set -e
+
+cli=$1
+[ -x "$cli" ] || { echo "usage: $0 <reacoma-cli> [algorithm...]" >&2; exit 2; }
+shift
+[ $# -gt 0 ] || set -- amp-slice onset-slice sines hpss
+
+media=$(dirname "$0")/../../ReacomaExtension/TestProject/media
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+for file in "$media"/*.wv; do
+    wvunpack -q -y "$file" -o "$work/$(basename "$file" .wv).wav"
+done
+
+for algorithm in "$@"; do
+    echo "== $algorithm"
+    for file in "$work"/*.wav; do
+        if [ -x /usr/bin/time ]; then
+            /usr/bin/time -f "  peak memory %M KB" \
+                "$cli" "$algorithm" --output "$work/out" "$file"
+        else
+            "$cli" "$algorithm" --output "$work/out" "$file"
+        fi
+    done
+done
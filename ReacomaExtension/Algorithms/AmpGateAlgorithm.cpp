@@ -0,0 +1,202 @@
+#include "AmpGateAlgorithm.h"
+#include "IPlugParameter.h"
+#include "ReacomaExtension.h"
+
+AmpGateAlgorithm::AmpGateAlgorithm(ReacomaExtension *apiProvider)
+    : FlucomaAlgorithm<NRTThreadedAmpGateClient>(apiProvider) {}
+
+AmpGateAlgorithm::~AmpGateAlgorithm() { Shutdown(); }
+
+void AmpGateAlgorithm::RegisterParameters() {
+    mBaseParamIdx = mApiProvider->NParams();
+    for (int i = 0; i < kNumParams; ++i) {
+        mApiProvider->AddParam();
+    }
+    mApiProvider->GetParam(mBaseParamIdx + kRampUp)
+        ->InitInt("Ramp Up", 10, 1, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kRampDown)
+        ->InitInt("Ramp Down", 10, 1, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kOnThreshold)
+        ->InitDouble("On Threshold", -30, -144, 144, 0.1);
+    mApiProvider->GetParam(mBaseParamIdx + kOffThreshold)
+        ->InitDouble("Off Threshold", -40, -144, 144, 0.1);
+    mApiProvider->GetParam(mBaseParamIdx + kMinSliceLength)
+        ->InitInt("Minimum Slice Length", 4410, 1, 441000);
+    mApiProvider->GetParam(mBaseParamIdx + kMinSilenceLength)
+        ->InitInt("Minimum Silence Length", 4410, 1, 441000);
+    mApiProvider->GetParam(mBaseParamIdx + kMinLengthAbove)
+        ->InitInt("Minimum Length Above", 1, 1, 441000);
+    mApiProvider->GetParam(mBaseParamIdx + kMinLengthBelow)
+        ->InitInt("Minimum Length Below", 1, 1, 441000);
+    mApiProvider->GetParam(mBaseParamIdx + kLookBack)
+        ->InitInt("Look Back", 441, 0, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kLookAhead)
+        ->InitInt("Look Ahead", 441, 0, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kHighPassFreq)
+        ->InitDouble("High Pass Frequency", 85, 0, 20000, 1);
+
+    IParam *outputParam = mApiProvider->GetParam(mBaseParamIdx + kOutput);
+    outputParam->InitEnum("Output", kRegions, kNumOutputOptions);
+    outputParam->SetDisplayText(kRegions, "Regions");
+    outputParam->SetDisplayText(kSplitItems, "Split Items");
+}
+
+bool AmpGateAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
+                                 int numChannels, int frameCount,
+                                 int sampleRate) {
+    auto outBuffer = std::make_shared<MemoryBufferAdaptor>(2, 1, sampleRate);
+    auto gatesOutputBuffer = fluid::client::BufferT::type(outBuffer);
+
+    auto rampUp = GetParamValue(kRampUp);
+    auto rampDown = GetParamValue(kRampDown);
+    auto onThreshold = GetParamValue(kOnThreshold);
+    auto offThreshold = GetParamValue(kOffThreshold);
+    auto minSliceLength = GetParamValue(kMinSliceLength);
+    auto minSilenceLength = GetParamValue(kMinSilenceLength);
+    auto minLengthAbove = GetParamValue(kMinLengthAbove);
+    auto minLengthBelow = GetParamValue(kMinLengthBelow);
+    auto lookBack = GetParamValue(kLookBack);
+    auto lookAhead = GetParamValue(kLookAhead);
+    auto highPassFreq = GetParamValue(kHighPassFreq);
+
+    mParams.template set<0>(std::move(sourceBuffer), nullptr);
+    mParams.template set<1>(LongT::type(0), nullptr);
+    mParams.template set<2>(LongT::type(-1), nullptr);
+    mParams.template set<3>(LongT::type(0), nullptr);
+    mParams.template set<4>(LongT::type(-1), nullptr);
+    mParams.template set<5>(std::move(gatesOutputBuffer), nullptr);
+    mParams.template set<6>(LongT::type(rampUp), nullptr);
+    mParams.template set<7>(LongT::type(rampDown), nullptr);
+    mParams.template set<8>(FloatT::type(onThreshold), nullptr);
+    mParams.template set<9>(FloatT::type(offThreshold), nullptr);
+    mParams.template set<10>(LongT::type(minSliceLength), nullptr);
+    mParams.template set<11>(LongT::type(minSilenceLength), nullptr);
+    mParams.template set<12>(LongT::type(minLengthAbove), nullptr);
+    mParams.template set<13>(LongT::type(minLengthBelow), nullptr);
+    mParams.template set<14>(LongT::type(lookBack), nullptr);
+    mParams.template set<15>(LongT::type(lookAhead), nullptr);
+    mParams.template set<16>(FloatT::type(highPassFreq), nullptr);
+
+    mClient = NRTThreadedAmpGateClient(mParams, mContext);
+    mClient.setSynchronous(false);
+    mClient.enqueue(mParams);
+    Result result = mClient.process();
+    return result.ok();
+}
+
+std::vector<std::pair<fluid::index, fluid::index>>
+AmpGateAlgorithm::GetGateFrames() {
+    std::vector<std::pair<fluid::index, fluid::index>> gates;
+    auto gatesBuffer = mParams.template get<5>();
+    BufferAdaptor::ReadAccess reader(gatesBuffer.get());
+    if (!reader.exists() || !reader.valid() || reader.numChans() < 2)
+        return gates;
+
+    auto onsets = reader.samps(0);
+    auto offsets = reader.samps(1);
+    for (fluid::index i = 0; i < reader.numFrames(); ++i) {
+        const auto start = static_cast<fluid::index>(onsets(i));
+        const auto end = static_cast<fluid::index>(offsets(i));
+        if (start >= 0 && end > start) {
+            gates.emplace_back(start, end);
+        }
+    }
+    return gates;
+}
+
+std::vector<std::pair<double, double>>
+AmpGateAlgorithm::GatesForItem(MediaItem *item, MediaItem_Take *take,
+                               int sampleRate) {
+    const double playrate = GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+    const double itemLength = GetMediaItemInfo_Value(item, "D_LENGTH");
+    const double framesPerItemSecond = sampleRate * playrate;
+    const fluid::index itemEnd =
+        mTakeStartFrame +
+        static_cast<fluid::index>(std::ceil(itemLength * framesPerItemSecond));
+
+    std::vector<std::pair<double, double>> gates;
+    for (const auto &[start, end] : GetGateFrames()) {
+        const fluid::index from =
+            std::max(mIngestStartFrame + start, mTakeStartFrame);
+        const fluid::index to = std::min(mIngestStartFrame + end, itemEnd);
+        if (to > from) {
+            gates.emplace_back((from - mTakeStartFrame) / framesPerItemSecond,
+                               (to - mTakeStartFrame) / framesPerItemSecond);
+        }
+    }
+    return gates;
+}
+
+bool AmpGateAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
+                                     int numChannels, int sampleRate) {
+    const auto gates = GatesForItem(item, take, sampleRate);
+    if (mSliceSink) {
+        std::vector<double> times;
+        for (const auto &[start, end] : gates) {
+            times.push_back(start);
+            times.push_back(end);
+        }
+        mSliceSink(item, times);
+        return true;
+    }
+
+    // An item with nothing above the gate is left alone rather than removed.
+    if (gates.empty())
+        return true;
+
+    PreventUIRefresh(1);
+    if (static_cast<int>(GetParamValue(kOutput)) == kSplitItems) {
+        SplitItem(item, gates);
+    } else {
+        AddRegions(item, take, gates);
+    }
+    PreventUIRefresh(-1);
+    return true;
+}
+
+void AmpGateAlgorithm::AddRegions(
+    MediaItem *item, MediaItem_Take *take,
+    const std::vector<std::pair<double, double>> &gates) {
+    const double position = GetMediaItemInfo_Value(item, "D_POSITION");
+    const char *takeName =
+        static_cast<const char *>(GetSetMediaItemTakeInfo(take, "P_NAME",
+                                                          nullptr));
+    for (const auto &[start, end] : gates) {
+        AddProjectMarker2(nullptr, true, position + start, position + end,
+                          takeName ? takeName : "", -1, 0);
+    }
+}
+
+// Works left to right, cutting away the gap before each gate and keeping
+// the gate itself. Whatever follows the last gate is removed too.
+void AmpGateAlgorithm::SplitItem(
+    MediaItem *item, const std::vector<std::pair<double, double>> &gates) {
+    MediaTrack *track = GetMediaItem_Track(item);
+    const double position = GetMediaItemInfo_Value(item, "D_POSITION");
+    const double itemEnd =
+        position + GetMediaItemInfo_Value(item, "D_LENGTH");
+
+    // Locked items cannot be split.
+    SetMediaItemInfo_Value(item, "C_LOCK", false);
+
+    MediaItem *rest = item;
+    for (const auto &[start, end] : gates) {
+        if (position + start > GetMediaItemInfo_Value(rest, "D_POSITION")) {
+            MediaItem *right = SplitMediaItem(rest, position + start);
+            if (!right)
+                return;
+            DeleteTrackMediaItem(track, rest);
+            rest = right;
+        }
+        if (position + end >= itemEnd)
+            return;
+        rest = SplitMediaItem(rest, position + end);
+        if (!rest)
+            return;
+    }
+    DeleteTrackMediaItem(track, rest);
+}
+
+const char *AmpGateAlgorithm::GetName() const { return "Amp Gate"; }
+
+int AmpGateAlgorithm::GetNumAlgorithmParams() const { return kNumParams; }
@@ -0,0 +1,64 @@
+#pragma once
+#include "../../dependencies/flucoma-core/include/flucoma/clients/rt/AmpGateClient.hpp"
+#include "FlucomaAlgorithmBase.h"
+
+#include <utility>
+
+// Finds the stretches of audio above an amplitude gate, with separate on
+// and off thresholds and lookback/lookahead around each opening. Each
+// stretch becomes a region, or the items are split so that only the gated
+// stretches remain.
+class AmpGateAlgorithm
+    : public FlucomaAlgorithm<fluid::client::NRTThreadedAmpGateClient> {
+  public:
+    enum Params {
+        kRampUp = 0,
+        kRampDown,
+        kOnThreshold,
+        kOffThreshold,
+        kMinSliceLength,
+        kMinSilenceLength,
+        kMinLengthAbove,
+        kMinLengthBelow,
+        kLookBack,
+        kLookAhead,
+        kHighPassFreq,
+        kOutput,
+        kNumParams
+    };
+
+    enum EOutputOptions { kRegions = 0, kSplitItems, kNumOutputOptions };
+
+    AmpGateAlgorithm(ReacomaExtension *apiProvider);
+    ~AmpGateAlgorithm() override;
+
+    const char *GetName() const override;
+    void RegisterParameters() override;
+    int GetNumAlgorithmParams() const override;
+
+    // Gated stretches of the last run as (start, end) frames from the start
+    // of the audio it was given.
+    std::vector<std::pair<fluid::index, fluid::index>> GetGateFrames() override;
+
+    // The output parameter decides between regions and splits, from a button
+    // of its own. Gates are not slices, so they cannot be compared with the
+    // slicers either.
+    bool SupportsRegions() override { return false; }
+    bool SupportsSegmentation() override { return false; }
+    bool SupportsSliceSink() override { return true; }
+
+  protected:
+    bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
+                   int frameCount, int sampleRate) override;
+    bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
+                       int sampleRate) override;
+
+  private:
+    // Gated stretches of one item, in seconds from its start.
+    std::vector<std::pair<double, double>>
+    GatesForItem(MediaItem *item, MediaItem_Take *take, int sampleRate);
+    void AddRegions(MediaItem *item, MediaItem_Take *take,
+                    const std::vector<std::pair<double, double>> &gates);
+    void SplitItem(MediaItem *item,
+                   const std::vector<std::pair<double, double>> &gates);
+};
@@ -0,0 +1,88 @@
+#include "AmpSliceAlgorithm.h"
+#include "IPlugParameter.h"
+#include "ReacomaExtension.h"
+
+AmpSliceAlgorithm::AmpSliceAlgorithm(ReacomaExtension *apiProvider)
+    : SlicerAlgorithm<NRTThreadingAmpSliceClient>(apiProvider) {}
+
+AmpSliceAlgorithm::~AmpSliceAlgorithm() { Shutdown(); }
+
+void AmpSliceAlgorithm::RegisterParameters() {
+    mBaseParamIdx = mApiProvider->NParams();
+    for (int i = 0; i < kNumParams; ++i) {
+        mApiProvider->AddParam();
+    }
+    mApiProvider->GetParam(mBaseParamIdx + kFastRampUp)
+        ->InitInt("Fast Ramp Up", 3, 1, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kFastRampDown)
+        ->InitInt("Fast Ramp Down", 383, 1, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kSlowRampUp)
+        ->InitInt("Slow Ramp Up", 2205, 1, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kSlowRampDown)
+        ->InitInt("Slow Ramp Down", 2205, 1, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kOnThreshold)
+        ->InitDouble("On Threshold", 19, -144, 144, 0.1);
+    mApiProvider->GetParam(mBaseParamIdx + kOffThreshold)
+        ->InitDouble("Off Threshold", 8, -144, 144, 0.1);
+    mApiProvider->GetParam(mBaseParamIdx + kFloor)
+        ->InitDouble("Floor", -40, -144, 144, 0.1);
+    mApiProvider->GetParam(mBaseParamIdx + kMinSliceLength)
+        ->InitInt("Minimum Slice Length", 2, 0, 44100);
+    mApiProvider->GetParam(mBaseParamIdx + kHighPassFreq)
+        ->InitDouble("High Pass Frequency", 85, 0, 20000, 1);
+}
+
+bool AmpSliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
+                                  int numChannels, int frameCount,
+                                  int sampleRate) {
+    int estimatedSlices = std::max(1, static_cast<int>(frameCount / 1024.0));
+    auto outBuffer =
+        std::make_shared<MemoryBufferAdaptor>(1, estimatedSlices, sampleRate);
+    auto slicesOutputBuffer = fluid::client::BufferT::type(outBuffer);
+
+    auto fastRampUp = GetParamValue(kFastRampUp);
+    auto fastRampDown = GetParamValue(kFastRampDown);
+    auto slowRampUp = GetParamValue(kSlowRampUp);
+    auto slowRampDown = GetParamValue(kSlowRampDown);
+    auto onThreshold = GetParamValue(kOnThreshold);
+    auto offThreshold = GetParamValue(kOffThreshold);
+    auto floor = GetParamValue(kFloor);
+    auto minSliceLength = GetParamValue(kMinSliceLength);
+    auto highPassFreq = GetParamValue(kHighPassFreq);
+
+    mParams.template set<0>(std::move(sourceBuffer), nullptr);
+    mParams.template set<1>(LongT::type(0), nullptr);
+    mParams.template set<2>(LongT::type(-1), nullptr);
+    mParams.template set<3>(LongT::type(0), nullptr);
+    mParams.template set<4>(LongT::type(-1), nullptr);
+    mParams.template set<5>(std::move(slicesOutputBuffer), nullptr);
+    mParams.template set<6>(LongT::type(fastRampUp), nullptr);
+    mParams.template set<7>(LongT::type(fastRampDown), nullptr);
+    mParams.template set<8>(LongT::type(slowRampUp), nullptr);
+    mParams.template set<9>(LongT::type(slowRampDown), nullptr);
+    mParams.template set<10>(FloatT::type(onThreshold), nullptr);
+    mParams.template set<11>(FloatT::type(offThreshold), nullptr);
+    mParams.template set<12>(FloatT::type(floor), nullptr);
+    mParams.template set<13>(LongT::type(minSliceLength), nullptr);
+    mParams.template set<14>(FloatT::type(highPassFreq), nullptr);
+
+    mClient = NRTThreadingAmpSliceClient(mParams, mContext);
+    mClient.setSynchronous(false);
+    mClient.enqueue(mParams);
+    Result result = mClient.process();
+    return result.ok();
+}
+
+// The envelopes settle within a few of their ramp lengths; the slow one is
+// by far the longest.
+fluid::index AmpSliceAlgorithm::GetContextFrames() const {
+    auto param = [this](int idx) {
+        return static_cast<fluid::index>(GetParamValue(idx));
+    };
+    return 4 * std::max(param(kSlowRampUp), param(kSlowRampDown)) +
+           param(kFastRampDown) + param(kMinSliceLength);
+}
+
+const char *AmpSliceAlgorithm::GetName() const { return "Amp Slice"; }
+
+int AmpSliceAlgorithm::GetNumAlgorithmParams() const { return kNumParams; }
@@ -0,0 +1,35 @@
+#pragma once
+#include "../../dependencies/flucoma-core/include/flucoma/clients/rt/AmpSliceClient.hpp"
+#include "FlucomaAlgorithmBase.h"
+
+// Slices where a fast amplitude envelope rises above a slow one, entirely
+// in the time domain. Much cheaper than the spectral slicers, which makes
+// it the one to use on long dialogue or drum stems.
+class AmpSliceAlgorithm
+    : public SlicerAlgorithm<fluid::client::NRTThreadingAmpSliceClient> {
+  public:
+    enum Params {
+        kFastRampUp = 0,
+        kFastRampDown,
+        kSlowRampUp,
+        kSlowRampDown,
+        kOnThreshold,
+        kOffThreshold,
+        kFloor,
+        kMinSliceLength,
+        kHighPassFreq,
+        kNumParams
+    };
+
+    AmpSliceAlgorithm(ReacomaExtension *apiProvider);
+    ~AmpSliceAlgorithm() override;
+
+    const char *GetName() const override;
+    void RegisterParameters() override;
+    int GetNumAlgorithmParams() const override;
+
+  protected:
+    bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
+                   int frameCount, int sampleRate) override;
+    fluid::index GetContextFrames() const override;
+};
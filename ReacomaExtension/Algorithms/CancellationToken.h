@@ -0,0 +1,20 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+// Shared flag that long-running work polls between chunks. Copies refer to
+// the same flag, so a worker can keep its copy alive after the algorithm
+// that started it has moved on.
+class CancellationToken {
+  public:
+    CancellationToken() : mFlag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void Cancel() { mFlag->store(true, std::memory_order_relaxed); }
+    bool IsCancelled() const {
+        return mFlag->load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::shared_ptr<std::atomic<bool>> mFlag;
+};
@@ -0,0 +1,320 @@
+#include "ColumnarKMeans.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace {
+// Rows measured together; their distances stay in L1 while every centre
+// is tried against them.
+constexpr size_t kRowsPerPart = 1024;
+constexpr unsigned kSeed = 1;
+
+// Threads that live for one clustering, so that each iteration hands them
+// work instead of starting threads of its own. The calling thread works
+// too.
+class WorkerPool {
+  public:
+    explicit WorkerPool(int numThreads) {
+        for (int i = 1; i < numThreads; ++i) {
+            mThreads.emplace_back([this]() { Work(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mWake.notify_all();
+        for (std::thread &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    // Calls task once for each part, returning when all have finished.
+    void Run(size_t numParts, std::function<void(size_t)> task) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTask = std::move(task);
+            mNumParts = numParts;
+            mNextPart = 0;
+            mBusy = mThreads.size();
+            ++mGeneration;
+        }
+        mWake.notify_all();
+        RunParts();
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this]() { return mBusy == 0; });
+    }
+
+  private:
+    void RunParts() {
+        for (size_t part = mNextPart++; part < mNumParts;
+             part = mNextPart++) {
+            mTask(part);
+        }
+    }
+
+    void Work() {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWake.wait(lock, [this, seen]() {
+                    return mStopping || mGeneration != seen;
+                });
+                if (mStopping)
+                    return;
+                seen = mGeneration;
+            }
+            RunParts();
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                --mBusy;
+            }
+            mDone.notify_one();
+        }
+    }
+
+    std::vector<std::thread> mThreads;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    std::function<void(size_t)> mTask;
+    size_t mNumParts = 0;
+    std::atomic<size_t> mNextPart{0};
+    size_t mBusy = 0;
+    size_t mGeneration = 0;
+    bool mStopping = false;
+};
+
+// What one part of the rows adds to the next centres, and the room it
+// gathers the rows it measures into.
+struct Part {
+    std::vector<double> sums;
+    std::vector<size_t> counts;
+    size_t changed = 0;
+    std::vector<float> gathered;
+    std::vector<const float *> dims;
+};
+
+// Squared distances from count rows to one centre, added a dimension at a
+// time. Each of dims points at the rows' values in one dimension.
+void MeasureRows(const std::vector<const float *> &dims, const float *centre,
+                 size_t count, float *distances) {
+    std::fill(distances, distances + count, 0.0f);
+    for (size_t d = 0; d < dims.size(); ++d) {
+        const float *values = dims[d];
+        const float coordinate = centre[d];
+        for (size_t r = 0; r < count; ++r) {
+            const float difference = values[r] - coordinate;
+            distances[r] += difference * difference;
+        }
+    }
+}
+
+// k-means++: each further centre is a row drawn with probability in
+// proportion to its squared distance from the nearest centre so far.
+std::vector<float> SeedCentres(const ColumnarKMeans::Columns &columns,
+                               size_t numClusters, size_t numParts,
+                               WorkerPool &pool) {
+    const size_t numRows = columns[0].size();
+    const size_t numDims = columns.size();
+    std::vector<float> centres(numClusters * numDims);
+    std::vector<float> nearest(numRows, std::numeric_limits<float>::max());
+    std::mt19937 random(kSeed);
+
+    size_t row = random() % numRows;
+    for (size_t c = 0; c < numClusters; ++c) {
+        float *centre = centres.data() + c * numDims;
+        for (size_t d = 0; d < numDims; ++d) {
+            centre[d] = columns[d][row];
+        }
+        if (c + 1 == numClusters)
+            break;
+
+        pool.Run(numParts, [&](size_t part) {
+            const size_t first = part * kRowsPerPart;
+            const size_t count = std::min(kRowsPerPart, numRows - first);
+            std::vector<const float *> dims(numDims);
+            for (size_t d = 0; d < numDims; ++d) {
+                dims[d] = columns[d].data() + first;
+            }
+            float distances[kRowsPerPart];
+            MeasureRows(dims, centre, count, distances);
+            for (size_t r = 0; r < count; ++r) {
+                nearest[first + r] =
+                    std::min(nearest[first + r], distances[r]);
+            }
+        });
+        double total = 0.0;
+        for (float distance : nearest) {
+            total += distance;
+        }
+        // Every row sits on a centre already, so any will do.
+        if (total <= 0.0) {
+            row = random() % numRows;
+            continue;
+        }
+        double target =
+            std::uniform_real_distribution<double>(0.0, total)(random);
+        row = numRows - 1;
+        for (size_t r = 0; r < numRows; ++r) {
+            target -= nearest[r];
+            if (target < 0.0) {
+                row = r;
+                break;
+            }
+        }
+    }
+    return centres;
+}
+} // namespace
+
+std::vector<int> ColumnarKMeans::Cluster(const Columns &columns,
+                                         int numClusters, int maxIterations,
+                                         int numThreads) {
+    const size_t numRows = columns.empty() ? 0 : columns[0].size();
+    std::vector<int> clusters(numRows, 0);
+    const size_t numDims = columns.size();
+    const size_t k =
+        std::min(numRows, static_cast<size_t>(std::max(numClusters, 0)));
+    if (k < 2 || !numDims)
+        return clusters;
+
+    const size_t numParts = (numRows + kRowsPerPart - 1) / kRowsPerPart;
+    if (numThreads <= 0)
+        numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    WorkerPool pool(static_cast<int>(std::clamp<size_t>(
+        static_cast<size_t>(numThreads), 1, numParts)));
+
+    std::vector<float> centres = SeedCentres(columns, k, numParts, pool);
+    std::vector<Part> parts(numParts);
+    for (Part &part : parts) {
+        part.gathered.resize(numDims * kRowsPerPart);
+        part.dims.resize(numDims);
+        for (size_t d = 0; d < numDims; ++d) {
+            part.dims[d] = part.gathered.data() + d * kRowsPerPart;
+        }
+    }
+
+    // Hamerly's bounds: each row's distance to its own centre is at most
+    // upper, and to any other at least lower. A row whose upper bound is
+    // within its lower cannot change cluster, so only the rest are measured.
+    // Moving the centres loosens both by how far the centres moved.
+    std::vector<float> upper(numRows, std::numeric_limits<float>::max());
+    std::vector<float> lower(numRows, 0.0f);
+    std::vector<float> moved(k, 0.0f);
+    float maxMoved = 0.0f;
+
+    for (int iteration = 0; iteration < maxIterations; ++iteration) {
+        pool.Run(numParts, [&](size_t part) {
+            const size_t first = part * kRowsPerPart;
+            const size_t count = std::min(kRowsPerPart, numRows - first);
+            Part &state = parts[part];
+            size_t rows[kRowsPerPart];
+            size_t numRowsToMeasure = 0;
+            for (size_t r = first; r < first + count; ++r) {
+                upper[r] += moved[clusters[r]];
+                lower[r] -= maxMoved;
+                if (!(upper[r] <= lower[r]))
+                    rows[numRowsToMeasure++] = r;
+            }
+
+            // Gathered into columns of their own, so that measuring them
+            // stays a contiguous loop.
+            for (size_t d = 0; d < numDims; ++d) {
+                const float *values = columns[d].data();
+                float *gathered = state.gathered.data() + d * kRowsPerPart;
+                for (size_t i = 0; i < numRowsToMeasure; ++i) {
+                    gathered[i] = values[rows[i]];
+                }
+            }
+            float distances[kRowsPerPart];
+            float best[kRowsPerPart];
+            float second[kRowsPerPart];
+            int bestCluster[kRowsPerPart];
+            std::fill(best, best + numRowsToMeasure,
+                      std::numeric_limits<float>::max());
+            std::fill(second, second + numRowsToMeasure,
+                      std::numeric_limits<float>::max());
+            std::fill(bestCluster, bestCluster + numRowsToMeasure, 0);
+            for (size_t c = 0; c < k; ++c) {
+                MeasureRows(state.dims, centres.data() + c * numDims,
+                            numRowsToMeasure, distances);
+                // Without branches, so that it vectorises like the
+                // measuring.
+                for (size_t i = 0; i < numRowsToMeasure; ++i) {
+                    const bool closer = distances[i] < best[i];
+                    second[i] = closer ? best[i]
+                                       : std::min(second[i], distances[i]);
+                    best[i] = closer ? distances[i] : best[i];
+                    bestCluster[i] = closer ? static_cast<int>(c)
+                                            : bestCluster[i];
+                }
+            }
+
+            state.changed = 0;
+            for (size_t i = 0; i < numRowsToMeasure; ++i) {
+                const size_t r = rows[i];
+                if (iteration == 0 || clusters[r] != bestCluster[i])
+                    ++state.changed;
+                clusters[r] = bestCluster[i];
+                upper[r] = std::sqrt(best[i]);
+                lower[r] = std::sqrt(second[i]);
+            }
+            state.sums.assign(k * numDims, 0.0);
+            state.counts.assign(k, 0);
+            for (size_t r = first; r < first + count; ++r) {
+                ++state.counts[clusters[r]];
+            }
+            for (size_t d = 0; d < numDims; ++d) {
+                const float *values = columns[d].data();
+                for (size_t r = first; r < first + count; ++r) {
+                    state.sums[clusters[r] * numDims + d] += values[r];
+                }
+            }
+        });
+
+        size_t changed = 0;
+        std::vector<double> sums(k * numDims, 0.0);
+        std::vector<size_t> counts(k, 0);
+        for (const Part &part : parts) {
+            changed += part.changed;
+            for (size_t i = 0; i < sums.size(); ++i) {
+                sums[i] += part.sums[i];
+            }
+            for (size_t c = 0; c < k; ++c) {
+                counts[c] += part.counts[c];
+            }
+        }
+        if (!changed)
+            break;
+
+        // A centre left without rows stays where it was.
+        maxMoved = 0.0f;
+        for (size_t c = 0; c < k; ++c) {
+            moved[c] = 0.0f;
+            if (!counts[c])
+                continue;
+            float distance = 0.0f;
+            for (size_t d = 0; d < numDims; ++d) {
+                const float centre =
+                    static_cast<float>(sums[c * numDims + d] / counts[c]);
+                const float difference = centre - centres[c * numDims + d];
+                distance += difference * difference;
+                centres[c * numDims + d] = centre;
+            }
+            moved[c] = std::sqrt(distance);
+            maxMoved = std::max(maxMoved, moved[c]);
+        }
+    }
+    return clusters;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+// k-means over points stored a column per dimension, so that measuring every
+// point against a centre is a contiguous loop the compiler can vectorise.
+// Rows are split into fixed parts that a pool of threads shares, and the
+// parts' sums are combined in order, so the clusters found do not depend on
+// the number of threads. Makes no REAPER or FluCoMa calls.
+struct ColumnarKMeans {
+    // One vector of values per dimension, all the same length.
+    using Columns = std::vector<std::vector<float>>;
+
+    // The cluster of each row. Starts from k-means++ centres with a fixed
+    // seed and stops once no row changes cluster, or after maxIterations.
+    // A numThreads of 0 uses every core.
+    static std::vector<int> Cluster(const Columns &columns, int numClusters,
+                                    int maxIterations, int numThreads = 0);
+};
@@ -0,0 +1,129 @@
+#include "CompareAlgorithm.h"
+#include "Ingest.h"
+
+#include <chrono>
+
+CompareAlgorithm::CompareAlgorithm(
+    ReacomaExtension *apiProvider,
+    std::vector<std::unique_ptr<IAlgorithm>> slicers)
+    : IAlgorithm(apiProvider), mSlicers(std::move(slicers)) {}
+
+CompareAlgorithm::~CompareAlgorithm() { Shutdown(); }
+
+bool CompareAlgorithm::StartProcessItemsAsync(
+    const std::vector<MediaItem *> &items) {
+    mItems = items;
+    mFailed = true;
+
+    IngestPlan plan = IngestPlan::ForItems(items);
+    if (plan.spans.empty() || plan.numChannels <= 0)
+        return false;
+
+    PCM_source *reader = plan.source->Duplicate();
+    if (!reader)
+        return false;
+
+    for (MediaItem *item : mItems) {
+        SetMediaItemInfo_Value(item, "C_LOCK", true);
+    }
+
+    mFailed = false;
+    mIngestStartFrame = plan.startFrame;
+    mIngestProgress.BeginPhase(JobProgress::kIngest);
+    mIngest = std::async(std::launch::async, [this, plan, reader,
+                                              token = mCancelToken]() {
+        auto buffer = plan.Read(reader, plan.startFrame,
+                                plan.endFrame - plan.startFrame, token,
+                                &mIngestProgress);
+        delete reader;
+        return buffer;
+    });
+    return true;
+}
+
+bool CompareAlgorithm::IsFinished() {
+    if (mIngest.valid()) {
+        if (mIngest.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+            return false;
+
+        StageAudio audio;
+        audio.buffer = mIngest.get();
+        audio.startFrame = mIngestStartFrame;
+        mFailed = !audio.buffer;
+        if (!mFailed) {
+            for (auto &slicer : mSlicers) {
+                slicer->StartProcessBufferAsync(mItems, audio);
+            }
+        }
+    }
+
+    bool finished = true;
+    for (auto &slicer : mSlicers) {
+        finished = slicer->IsFinished() && finished;
+    }
+    return finished;
+}
+
+bool CompareAlgorithm::Succeeded() {
+    if (mFailed)
+        return false;
+    for (auto &slicer : mSlicers) {
+        if (!slicer->Succeeded())
+            return false;
+    }
+    return true;
+}
+
+bool CompareAlgorithm::FinalizeProcess() {
+    if (mFailed) {
+        for (MediaItem *item : mItems) {
+            SetMediaItemInfo_Value(item, "C_LOCK", false);
+        }
+        return false;
+    }
+
+    bool success = true;
+    for (auto &slicer : mSlicers) {
+        success = slicer->FinalizeProcess() && success;
+    }
+    return success;
+}
+
+double CompareAlgorithm::GetProgress() {
+    if (mSlicers.empty())
+        return 1.0;
+    // Until the shared ingest is done it stands in for the ingest phase of
+    // every slicer, which count it as complete once they start.
+    if (mIngest.valid())
+        return mIngestProgress.Get();
+
+    double progress = 0.0;
+    for (auto &slicer : mSlicers) {
+        progress += slicer->GetProgress();
+    }
+    return progress / mSlicers.size();
+}
+
+void CompareAlgorithm::Cancel() {
+    mCancelToken.Cancel();
+    for (auto &slicer : mSlicers) {
+        slicer->Cancel();
+    }
+}
+
+void CompareAlgorithm::Shutdown() {
+    Cancel();
+    if (mIngest.valid()) {
+        mIngest.wait();
+    }
+    for (auto &slicer : mSlicers) {
+        slicer->Shutdown();
+    }
+}
+
+const char *CompareAlgorithm::GetName() const { return "Compare Slicers"; }
+
+void CompareAlgorithm::RegisterParameters() {}
+
+int CompareAlgorithm::GetNumAlgorithmParams() const { return 0; }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "IAlgorithm.h"
+#include "JobProgress.h"
+
+#include <future>
+#include <memory>
+#include <vector>
+
+// Runs several slicers at once over a single ingest of the items. The
+// ingested audio is shared read-only between them, and each slicer writes
+// its markers under its own name and colour.
+class CompareAlgorithm : public IAlgorithm {
+  public:
+    CompareAlgorithm(ReacomaExtension *apiProvider,
+                     std::vector<std::unique_ptr<IAlgorithm>> slicers);
+    ~CompareAlgorithm() override;
+
+    bool StartProcessItemsAsync(const std::vector<MediaItem *> &items) override;
+    bool IsFinished() override;
+    bool Succeeded() override;
+    bool FinalizeProcess() override;
+
+    double GetProgress() override;
+    void Cancel() override;
+    void Shutdown() override;
+
+    const char *GetName() const override;
+    void RegisterParameters() override;
+    int GetNumAlgorithmParams() const override;
+
+    bool SupportsSegmentation() override { return true; }
+    bool SupportsRegions() override { return false; }
+    bool CreatesTakes() override { return false; }
+
+  private:
+    using IngestResult = std::shared_ptr<const fluid::client::BufferAdaptor>;
+
+    std::vector<std::unique_ptr<IAlgorithm>> mSlicers;
+    std::vector<MediaItem *> mItems;
+    JobProgress mIngestProgress;
+    std::future<IngestResult> mIngest;
+    fluid::index mIngestStartFrame = 0;
+    bool mFailed = false;
+};
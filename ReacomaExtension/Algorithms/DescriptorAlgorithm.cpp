@@ -0,0 +1,470 @@
+#include "DescriptorAlgorithm.h"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/DCT.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/Loudness.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/MelBands.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/SpectralShape.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/YINFFT.hpp"
+#include "IPlugParameter.h"
+#include "ReacomaExtension.h"
+
+#include <future>
+#include <numeric>
+
+namespace {
+const char *const kFrameDescriptors[] = {
+    "loudness", "peak",     "centroid", "spread",
+    "skewness", "kurtosis", "rolloff",  "flatness",
+    "crest",    "pitch",    "pitchConfidence",
+};
+constexpr fluid::index kNumFrameDescriptors =
+    sizeof(kFrameDescriptors) / sizeof(kFrameDescriptors[0]);
+
+constexpr int kMaxCoeffs = 40;
+
+// Below this many frames per thread, starting threads costs more than it
+// saves.
+constexpr fluid::index kMinFramesPerThread = 1024;
+} // namespace
+
+DescriptorAlgorithm::DescriptorAlgorithm(ReacomaExtension *apiProvider)
+    : FlucomaAlgorithm<NRTThreadedSpectralShapeClient>(apiProvider) {}
+
+DescriptorAlgorithm::~DescriptorAlgorithm() { Shutdown(); }
+
+void DescriptorAlgorithm::RegisterParameters() {
+    mBaseParamIdx = mApiProvider->NParams();
+
+    for (int i = 0; i < DescriptorAlgorithm::kNumParams; ++i) {
+        mApiProvider->AddParam();
+    }
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kWindowSize)
+        ->InitInt("Window Size", 1024, 2, 65536);
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kHopSize)
+        ->InitInt("Hop Size", 512, 2, 65536);
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kFFTSize)
+        ->InitInt("FFT Size", 1024, 2, 65536);
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kNumBands)
+        ->InitInt("Mel Bands", 40, 2, 128);
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kNumCoeffs)
+        ->InitInt("MFCC Coefficients", 13, 2, kMaxCoeffs);
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kMinFreq)
+        ->InitDouble("Pitch Min Frequency", 20, 20, 10000, 1);
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kMaxFreq)
+        ->InitDouble("Pitch Max Frequency", 10000, 20, 20000, 1);
+
+    // Used when selecting similar slices and clustering them rather than
+    // when describing.
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kNumNeighbours)
+        ->InitInt("Neighbours", 8, 1, 1000);
+
+    mApiProvider->GetParam(mBaseParamIdx + DescriptorAlgorithm::kNumClusters)
+        ->InitInt("Clusters", 8, 2, 64);
+
+    IParam *outputParam = mApiProvider->GetParam(mBaseParamIdx + kOutput);
+    outputParam->InitEnum("Output", kTable, kNumOutputOptions);
+    outputParam->SetDisplayText(kTable, "Table");
+    outputParam->SetDisplayText(kSortItems, "Sort Items");
+
+    // Every coefficient the analysis can produce is offered; choosing one
+    // beyond those computed sorts by the last.
+    const std::vector<std::string> sortNames = DescriptorNames(kMaxCoeffs);
+    IParam *sortByParam = mApiProvider->GetParam(mBaseParamIdx + kSortBy);
+    sortByParam->InitEnum("Sort By", 0, static_cast<int>(sortNames.size()));
+    for (int i = 0; i < static_cast<int>(sortNames.size()); ++i) {
+        sortByParam->SetDisplayText(i, sortNames[i].c_str());
+    }
+
+    IParam *sortOrderParam = mApiProvider->GetParam(mBaseParamIdx + kSortOrder);
+    sortOrderParam->InitEnum("Sort Order", kAscending, kNumSortOrders);
+    sortOrderParam->SetDisplayText(kAscending, "Ascending");
+    sortOrderParam->SetDisplayText(kDescending, "Descending");
+}
+
+std::vector<std::string>
+DescriptorAlgorithm::DescriptorNames(fluid::index numCoeffs) {
+    std::vector<std::string> names(std::begin(kFrameDescriptors),
+                                   std::end(kFrameDescriptors));
+    for (fluid::index i = 0; i < numCoeffs; ++i) {
+        names.push_back("mfcc" + std::to_string(i));
+    }
+    return names;
+}
+
+bool DescriptorAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
+                                    int numChannels, int frameCount,
+                                    int sampleRate) {
+    auto windowSize = GetParamValue(DescriptorAlgorithm::kWindowSize);
+    auto hopSize = GetParamValue(DescriptorAlgorithm::kHopSize);
+    auto fftSize = GetParamValue(DescriptorAlgorithm::kFFTSize);
+
+    Settings settings;
+    settings.numBands = static_cast<fluid::index>(
+        GetParamValue(DescriptorAlgorithm::kNumBands));
+    settings.numCoeffs = std::min(
+        settings.numBands, static_cast<fluid::index>(GetParamValue(
+                               DescriptorAlgorithm::kNumCoeffs)));
+    settings.minFreq = GetParamValue(DescriptorAlgorithm::kMinFreq);
+    settings.maxFreq = std::max(
+        settings.minFreq, GetParamValue(DescriptorAlgorithm::kMaxFreq));
+
+    mFrameSums = FrameSums{};
+    mDescriptorNames = DescriptorNames(settings.numCoeffs);
+    mTable = DescriptorTable{};
+    mSampleRate = sampleRate;
+
+    // Markers are read here, on the main thread, so that describing and
+    // sorting the slices can happen in the task.
+    mItemSlices.clear();
+    for (const IngestPlan::ItemSpan &span : GetIngestPlan().spans) {
+        ItemSlices slices;
+        slices.item = span.item;
+        slices.takeStartFrame = span.startFrame;
+        slices.boundaries = ReadSliceBoundaries(span.item, span.take,
+                                                span.startFrame, sampleRate);
+        mItemSlices.push_back(std::move(slices));
+    }
+    const bool sorting =
+        static_cast<int>(GetParamValue(kOutput)) == kSortItems;
+    const int sortDescriptor =
+        std::min(static_cast<int>(GetParamValue(kSortBy)),
+                 static_cast<int>(mDescriptorNames.size()) - 1);
+    const int sortColumn = sorting ? 2 * sortDescriptor : -1;
+    const bool descending =
+        static_cast<int>(GetParamValue(kSortOrder)) == kDescending;
+
+    auto key = MakeSpectrogramKey(
+        frameCount, static_cast<fluid::index>(windowSize),
+        static_cast<fluid::index>(hopSize),
+        Spectrogram::EffectiveFFTSize(static_cast<fluid::index>(windowSize),
+                                      static_cast<fluid::index>(fftSize)));
+    RunTask([this, key, sourceBuffer, settings, sampleRate, sortColumn,
+             descending]() {
+        auto spectrogram = GetSpectrogram(key, sourceBuffer.get());
+        if (!spectrogram ||
+            !Analyse(sourceBuffer.get(), *spectrogram, key, settings,
+                     sampleRate))
+            return false;
+        DescribeItems(sortColumn, descending);
+        return true;
+    });
+    return true;
+}
+
+// Frames do not depend on each other, so the span is split into contiguous
+// runs of frames, each described by its own thread.
+bool DescriptorAlgorithm::Analyse(const BufferAdaptor *source,
+                                  const Spectrogram &spectrogram,
+                                  const SpectrogramKey &key,
+                                  const Settings &settings, int sampleRate) {
+    BufferAdaptor::ReadAccess reader(source);
+    if (!reader.exists() || !reader.valid() || !reader.numChans())
+        return false;
+
+    std::vector<fluid::FluidTensorView<const float, 1>> channels;
+    for (fluid::index c = 0; c < reader.numChans(); ++c) {
+        channels.push_back(reader.samps(c));
+    }
+
+    const fluid::index numFrames = spectrogram.NumFrames();
+    const fluid::index numColumns =
+        kNumFrameDescriptors + settings.numCoeffs;
+    std::vector<std::vector<double>> values(numColumns,
+                                            std::vector<double>(numFrames));
+
+    const fluid::index numThreads = std::max<fluid::index>(
+        1, std::min<fluid::index>(std::thread::hardware_concurrency(),
+                                  numFrames / kMinFramesPerThread));
+    const fluid::index framesPerThread =
+        (numFrames + numThreads - 1) / numThreads;
+    std::atomic<fluid::index> framesDone{0};
+    std::vector<std::future<bool>> runs;
+    for (fluid::index t = 1; t < numThreads; ++t) {
+        const fluid::index first = t * framesPerThread;
+        const fluid::index end = std::min(numFrames, first + framesPerThread);
+        runs.push_back(std::async(std::launch::async, [&, first, end]() {
+            return AnalyseFrames(channels, spectrogram, key, settings,
+                                 sampleRate, first, end, values, framesDone);
+        }));
+    }
+    bool succeeded =
+        AnalyseFrames(channels, spectrogram, key, settings, sampleRate, 0,
+                      std::min(numFrames, framesPerThread), values,
+                      framesDone);
+    for (auto &run : runs) {
+        succeeded = run.get() && succeeded;
+    }
+    if (!succeeded)
+        return false;
+
+    FrameSums frameSums;
+    frameSums.numFrames = numFrames;
+    frameSums.hopSize = key.hopSize;
+    frameSums.firstCentre =
+        STFTFraming{key.windowSize, key.hopSize, key.fftSize}.FrameCentre(0);
+    frameSums.sums.assign(numColumns, std::vector<double>(numFrames + 1));
+    frameSums.squares.assign(numColumns, std::vector<double>(numFrames + 1));
+    for (fluid::index column = 0; column < numColumns; ++column) {
+        std::vector<double> &sums = frameSums.sums[column];
+        std::vector<double> &squares = frameSums.squares[column];
+        for (fluid::index frame = 0; frame < numFrames; ++frame) {
+            // Silent frames can leave some descriptors undefined.
+            const double value = std::isfinite(values[column][frame])
+                                     ? values[column][frame]
+                                     : 0.0;
+            sums[frame + 1] = sums[frame] + value;
+            squares[frame + 1] = squares[frame] + value * value;
+        }
+    }
+    mFrameSums = std::move(frameSums);
+    return true;
+}
+
+bool DescriptorAlgorithm::AnalyseFrames(
+    const std::vector<fluid::FluidTensorView<const float, 1>> &channels,
+    const Spectrogram &spectrogram,
+    const SpectrogramKey &key, const Settings &settings, int sampleRate,
+    fluid::index firstFrame, fluid::index endFrame,
+    std::vector<std::vector<double>> &values,
+    std::atomic<fluid::index> &framesDone) {
+    const fluid::index numChannels = spectrogram.NumChannels();
+    const fluid::index numBins = spectrogram.NumBins();
+    const double totalFrames = static_cast<double>(spectrogram.NumFrames());
+
+    fluid::algorithm::Loudness loudness(key.windowSize);
+    fluid::algorithm::SpectralShape shape(numBins);
+    fluid::algorithm::YINFFT yin(numBins);
+    fluid::algorithm::MelBands melBands(settings.numBands, key.fftSize);
+    fluid::algorithm::DCT dct(settings.numBands, settings.numCoeffs);
+    loudness.init(key.windowSize, sampleRate);
+    melBands.init(20, std::min(20000.0, sampleRate / 2.0), settings.numBands,
+                  numBins, sampleRate, key.windowSize);
+    dct.init(settings.numBands, settings.numCoeffs);
+
+    const STFTFraming framing{key.windowSize, key.hopSize, key.fftSize};
+    RealVector window(key.windowSize);
+    RealVector channelWindow(key.windowSize);
+    RealVector magnitudes(numBins);
+    RealVector loudnessOut(2);
+    RealVector shapeOut(7);
+    RealVector pitchOut(2);
+    RealVector bands(settings.numBands);
+    RealVector coefficients(settings.numCoeffs);
+
+    for (fluid::index frame = firstFrame; frame < endFrame; ++frame) {
+        if (mCancelToken.IsCancelled())
+            return false;
+
+        // Loudness is measured on the channels' average, read straight
+        // from the source a frame at a time.
+        framing.ReadFrame(channels[0], frame, window);
+        for (size_t c = 1; c < channels.size(); ++c) {
+            framing.ReadFrame(channels[c], frame, channelWindow);
+            for (fluid::index i = 0; i < key.windowSize; ++i) {
+                window(i) += channelWindow(i);
+            }
+        }
+        for (fluid::index i = 0; i < key.windowSize; ++i) {
+            window(i) /= static_cast<double>(channels.size());
+        }
+        for (fluid::index bin = 0; bin < numBins; ++bin) {
+            double magnitude = 0.0;
+            for (fluid::index c = 0; c < numChannels; ++c) {
+                magnitude += spectrogram.Channel(c)(frame, bin);
+            }
+            magnitudes(bin) = magnitude / numChannels;
+        }
+
+        loudness.processFrame(window, loudnessOut, true, true);
+        shape.processFrame(magnitudes, shapeOut, sampleRate, 0, -1, 0.95,
+                           false, false);
+        yin.processFrame(magnitudes, pitchOut, settings.minFreq,
+                         settings.maxFreq, sampleRate);
+        melBands.processFrame(magnitudes, bands, false, false, true);
+        dct.processFrame(bands, coefficients);
+
+        fluid::index column = 0;
+        for (fluid::index i = 0; i < 2; ++i) {
+            values[column++][frame] = loudnessOut(i);
+        }
+        for (fluid::index i = 0; i < 7; ++i) {
+            values[column++][frame] = shapeOut(i);
+        }
+        for (fluid::index i = 0; i < 2; ++i) {
+            values[column++][frame] = pitchOut(i);
+        }
+        for (fluid::index i = 0; i < settings.numCoeffs; ++i) {
+            values[column++][frame] = coefficients(i);
+        }
+        mJobProgress.Report((framesDone.fetch_add(1) + 1) / totalFrames);
+    }
+    return true;
+}
+
+DescriptorTable DescriptorAlgorithm::DescribeSlices(
+    const std::vector<fluid::index> &boundaries) {
+    DescriptorTable table;
+    table.sampleRate = mSampleRate;
+    for (const std::string &name : mDescriptorNames) {
+        table.columnNames.push_back(name + "Mean");
+        table.columnNames.push_back(name + "StdDev");
+    }
+    table.columns.resize(table.columnNames.size());
+
+    const FrameSums &frameSums = mFrameSums;
+    if (!frameSums.numFrames ||
+        frameSums.sums.size() != mDescriptorNames.size())
+        return table;
+
+    for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+        const fluid::index start = boundaries[i];
+        const fluid::index end = boundaries[i + 1];
+        // Frames whose centre lies within the slice; a slice shorter than
+        // a hop, even an empty one, takes the frame nearest its start, so
+        // there is a row for every slice.
+        const fluid::index hop = frameSums.hopSize;
+        auto firstCentredFrom = [&frameSums, hop](fluid::index frame) {
+            const fluid::index offset = frame - frameSums.firstCentre;
+            return offset <= 0 ? 0 : (offset + hop - 1) / hop;
+        };
+        fluid::index first = std::min(firstCentredFrom(start),
+                                      frameSums.numFrames - 1);
+        fluid::index last =
+            std::min(firstCentredFrom(end), frameSums.numFrames);
+        if (last <= first) {
+            first = std::clamp<fluid::index>(
+                (start - frameSums.firstCentre) / hop, 0,
+                frameSums.numFrames - 1);
+            last = first + 1;
+        }
+        const double count = static_cast<double>(last - first);
+
+        table.starts.push_back(mIngestStartFrame + start);
+        table.ends.push_back(mIngestStartFrame + end);
+        for (size_t d = 0; d < frameSums.sums.size(); ++d) {
+            const double mean =
+                (frameSums.sums[d][last] - frameSums.sums[d][first]) / count;
+            const double meanSquare =
+                (frameSums.squares[d][last] - frameSums.squares[d][first]) /
+                count;
+            table.columns[2 * d].push_back(static_cast<float>(mean));
+            table.columns[2 * d + 1].push_back(static_cast<float>(
+                std::sqrt(std::max(0.0, meanSquare - mean * mean))));
+        }
+    }
+    return table;
+}
+
+// Slices run from marker to marker, taking in the start and end of the item.
+std::vector<fluid::index> DescriptorAlgorithm::ReadSliceBoundaries(
+    MediaItem *item, MediaItem_Take *take, fluid::index takeStartFrame,
+    int sampleRate) const {
+    const double sourceLength = GetMediaItemInfo_Value(item, "D_LENGTH") *
+                                GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+    const fluid::index endFrame =
+        takeStartFrame + std::llround(sourceLength * sampleRate);
+
+    std::vector<fluid::index> markers;
+    for (int i = 0; i < GetNumTakeMarkers(take); ++i) {
+        const double position = GetTakeMarker(take, i, nullptr, 0, nullptr);
+        const fluid::index frame = std::llround(position * sampleRate);
+        if (frame > takeStartFrame && frame < endFrame) {
+            markers.push_back(frame);
+        }
+    }
+    std::sort(markers.begin(), markers.end());
+    markers.erase(std::unique(markers.begin(), markers.end()), markers.end());
+
+    std::vector<fluid::index> boundaries{takeStartFrame - mIngestStartFrame};
+    for (fluid::index frame : markers) {
+        boundaries.push_back(frame - mIngestStartFrame);
+    }
+    boundaries.push_back(endFrame - mIngestStartFrame);
+    return boundaries;
+}
+
+// A negative sort column leaves every item's slices where they are.
+void DescriptorAlgorithm::DescribeItems(int sortColumn, bool descending) {
+    for (ItemSlices &slices : mItemSlices) {
+        const DescriptorTable table = DescribeSlices(slices.boundaries);
+        mTable.Append(table);
+        if (sortColumn < 0 ||
+            sortColumn >= static_cast<int>(table.columns.size()))
+            continue;
+
+        const std::vector<float> &values = table.columns[sortColumn];
+        slices.order.resize(values.size());
+        std::iota(slices.order.begin(), slices.order.end(), 0);
+        std::stable_sort(slices.order.begin(), slices.order.end(),
+                         [&values, descending](size_t a, size_t b) {
+                             return descending ? values[a] > values[b]
+                                               : values[a] < values[b];
+                         });
+    }
+}
+
+bool DescriptorAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
+                                        int numChannels, int sampleRate) {
+    for (const ItemSlices &slices : mItemSlices) {
+        if (slices.item == item && slices.order.size() > 1) {
+            PreventUIRefresh(1);
+            ReorderItem(slices, take, sampleRate);
+            PreventUIRefresh(-1);
+        }
+    }
+    return true;
+}
+
+// Splits the item at each of its slices, then lays the pieces end to end
+// from where the item started, in sorted order.
+void DescriptorAlgorithm::ReorderItem(const ItemSlices &slices,
+                                      MediaItem_Take *take, int sampleRate) {
+    MediaItem *item = slices.item;
+    const double position = GetMediaItemInfo_Value(item, "D_POSITION");
+    const double playrate = GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+
+    if (slices.order.size() + 1 != slices.boundaries.size())
+        return;
+
+    // Locked items cannot be split.
+    SetMediaItemInfo_Value(item, "C_LOCK", false);
+
+    std::vector<MediaItem *> pieces{item};
+    for (size_t i = 1; i + 1 < slices.boundaries.size(); ++i) {
+        const fluid::index frame =
+            slices.boundaries[i] + mIngestStartFrame - slices.takeStartFrame;
+        MediaItem *right = SplitMediaItem(
+            pieces.back(), position + frame / (sampleRate * playrate));
+        if (!right)
+            return;
+        pieces.push_back(right);
+    }
+    if (pieces.size() != slices.order.size())
+        return;
+
+    double next = position;
+    for (size_t piece : slices.order) {
+        SetMediaItemInfo_Value(pieces[piece], "D_POSITION", next);
+        next += GetMediaItemInfo_Value(pieces[piece], "D_LENGTH");
+    }
+}
+
+// Sections of a file have no stable frame positions, so only items playing
+// a whole file get a table.
+bool DescriptorAlgorithm::FinishResults(int sampleRate) {
+    if (!mTable.NumRows() || this->mSourcePath.empty())
+        return true;
+
+    return mTable.Write(DescriptorTable::PathFor(this->mOutputSourcePath),
+                        mSliceOutput.sidecarJson);
+}
+
+const char *DescriptorAlgorithm::GetName() const { return "Describe"; }
+
+int DescriptorAlgorithm::GetNumAlgorithmParams() const { return kNumParams; }
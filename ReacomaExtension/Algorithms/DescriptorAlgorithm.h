@@ -0,0 +1,104 @@
+#pragma once
+#include "../../dependencies/flucoma-core/include/flucoma/clients/rt/SpectralShapeClient.hpp"
+#include "FlucomaAlgorithmBase.h"
+
+// Describes the slices marked on each item: loudness, spectral shape, pitch
+// and MFCCs are computed once per analysis frame over the whole span, then
+// reduced to a mean and standard deviation per slice. The table of every
+// item of a job goes to one sidecar next to the source file. Items can also
+// be split at their slices and the pieces laid out in order of a descriptor.
+class DescriptorAlgorithm
+    : public FlucomaAlgorithm<fluid::client::NRTThreadedSpectralShapeClient> {
+  public:
+    enum Params {
+        kWindowSize = 0,
+        kHopSize,
+        kFFTSize,
+        kNumBands,
+        kNumCoeffs,
+        kMinFreq,
+        kMaxFreq,
+        kNumNeighbours,
+        kNumClusters,
+        kOutput,
+        kSortBy,
+        kSortOrder,
+        kNumParams
+    };
+
+    enum EOutputOptions { kTable = 0, kSortItems, kNumOutputOptions };
+    enum ESortOrders { kAscending = 0, kDescending, kNumSortOrders };
+
+    DescriptorAlgorithm(ReacomaExtension *apiProvider);
+    ~DescriptorAlgorithm() override;
+
+    const char *GetName() const override;
+    void RegisterParameters() override;
+    int GetNumAlgorithmParams() const override;
+
+    DescriptorTable
+    DescribeSlices(const std::vector<fluid::index> &boundaries) override;
+
+    bool SupportsSegmentation() override { return false; }
+    bool SupportsRegions() override { return false; }
+
+  protected:
+    bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
+                   int frameCount, int sampleRate) override;
+    bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
+                       int sampleRate) override;
+    bool FinishResults(int sampleRate) override;
+
+  private:
+    struct Settings {
+        fluid::index numBands;
+        fluid::index numCoeffs;
+        double minFreq;
+        double maxFreq;
+    };
+
+    // Slice boundaries of one item in frames from the start of the ingested
+    // audio, and the order its slices are laid out in when sorting.
+    struct ItemSlices {
+        MediaItem *item = nullptr;
+        fluid::index takeStartFrame = 0;
+        std::vector<fluid::index> boundaries;
+        std::vector<size_t> order;
+    };
+
+    // Running sums of every frame descriptor and of its square, so that any
+    // range of frames reduces in constant time.
+    struct FrameSums {
+        fluid::index numFrames = 0;
+        fluid::index hopSize = 0;
+        // Where the first frame is centred, in frames of the ingested audio.
+        fluid::index firstCentre = 0;
+        std::vector<std::vector<double>> sums;
+        std::vector<std::vector<double>> squares;
+    };
+
+    static std::vector<std::string> DescriptorNames(fluid::index numCoeffs);
+    std::vector<fluid::index> ReadSliceBoundaries(MediaItem *item,
+                                                  MediaItem_Take *take,
+                                                  fluid::index takeStartFrame,
+                                                  int sampleRate) const;
+    void DescribeItems(int sortColumn, bool descending);
+    void ReorderItem(const ItemSlices &slices, MediaItem_Take *take,
+                     int sampleRate);
+
+    bool Analyse(const BufferAdaptor *source, const Spectrogram &spectrogram,
+                 const SpectrogramKey &key, const Settings &settings,
+                 int sampleRate);
+    bool AnalyseFrames(
+        const std::vector<fluid::FluidTensorView<const float, 1>> &channels,
+        const Spectrogram &spectrogram, const SpectrogramKey &key,
+        const Settings &settings, int sampleRate, fluid::index firstFrame,
+        fluid::index endFrame, std::vector<std::vector<double>> &values,
+        std::atomic<fluid::index> &framesDone);
+
+    FrameSums mFrameSums;
+    std::vector<ItemSlices> mItemSlices;
+    std::vector<std::string> mDescriptorNames;
+    DescriptorTable mTable;
+    int mSampleRate = 0;
+};
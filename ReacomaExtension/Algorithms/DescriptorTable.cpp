@@ -0,0 +1,209 @@
+#include "DescriptorTable.h"
+
+#include <cmath>
+#include <fstream>
+
+namespace {
+template <typename T> void WriteValue(std::ofstream &out, T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// JSON has no NaN or infinity, so those are written as null.
+void WriteJsonNumber(std::ofstream &out, float value) {
+    if (std::isfinite(value)) {
+        out << value;
+    } else {
+        out << "null";
+    }
+}
+
+template <typename T> T ReadValue(std::ifstream &in) {
+    T value{};
+    in.read(reinterpret_cast<char *>(&value), sizeof(value));
+    return value;
+}
+
+bool ReplaceFile(const std::filesystem::path &temporary,
+                 const std::filesystem::path &path) {
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int DescriptorTable::FindColumn(const std::string &name) const {
+    for (size_t i = 0; i < columnNames.size(); ++i) {
+        if (columnNames[i] == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+std::vector<size_t> DescriptorTable::MeanColumns() const {
+    std::vector<size_t> indices;
+    const std::string suffix = "Mean";
+    for (size_t i = 0; i < columnNames.size(); ++i) {
+        const std::string &name = columnNames[i];
+        if (name.size() > suffix.size() &&
+            name.compare(name.size() - suffix.size(), suffix.size(),
+                         suffix) == 0) {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+void DescriptorTable::Append(const DescriptorTable &other) {
+    if (columnNames.empty()) {
+        columnNames = other.columnNames;
+        columns.resize(columnNames.size());
+    }
+    starts.insert(starts.end(), other.starts.begin(), other.starts.end());
+    ends.insert(ends.end(), other.ends.begin(), other.ends.end());
+    for (size_t i = 0; i < columns.size() && i < other.columns.size(); ++i) {
+        columns[i].insert(columns[i].end(), other.columns[i].begin(),
+                          other.columns[i].end());
+    }
+}
+
+void DescriptorTable::AppendRow(const DescriptorTable &other, size_t row) {
+    if (columnNames.empty()) {
+        columnNames = other.columnNames;
+        columns.resize(columnNames.size());
+    }
+    starts.push_back(other.starts[row]);
+    ends.push_back(other.ends[row]);
+    for (size_t i = 0; i < columns.size() && i < other.columns.size(); ++i) {
+        columns[i].push_back(other.columns[i][row]);
+    }
+}
+
+std::filesystem::path
+DescriptorTable::PathFor(const std::string &sourcePath) {
+    return std::filesystem::path(sourcePath + ".rdsc");
+}
+
+bool DescriptorTable::Write(const std::filesystem::path &path,
+                            bool withJson) const {
+    const size_t numRows = NumRows();
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        out.write("RDSC", 4);
+        WriteValue<uint32_t>(out, kVersion);
+        WriteValue<uint32_t>(out, static_cast<uint32_t>(sampleRate));
+        WriteValue<uint32_t>(out, static_cast<uint32_t>(columnNames.size()));
+        WriteValue<uint64_t>(out, numRows);
+        for (fluid::index start : starts) {
+            WriteValue<int64_t>(out, start);
+        }
+        for (fluid::index end : ends) {
+            WriteValue<int64_t>(out, end);
+        }
+        size_t namesSize = 0;
+        for (const std::string &name : columnNames) {
+            WriteValue<uint32_t>(out, static_cast<uint32_t>(name.size()));
+            out.write(name.data(), name.size());
+            namesSize += sizeof(uint32_t) + name.size();
+        }
+        for (; namesSize % 8; ++namesSize) {
+            out.put(0);
+        }
+        for (const std::vector<float> &column : columns) {
+            out.write(reinterpret_cast<const char *>(column.data()),
+                      numRows * sizeof(float));
+        }
+        if (!out)
+            return false;
+    }
+    if (!ReplaceFile(temporary, path))
+        return false;
+
+    if (!withJson)
+        return true;
+
+    std::filesystem::path jsonPath = path;
+    jsonPath += ".json";
+    temporary = jsonPath;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out)
+            return false;
+
+        out << "{\"version\": " << kVersion << ", \"sampleRate\": "
+            << sampleRate << ", \"columns\": [";
+        for (size_t i = 0; i < columnNames.size(); ++i) {
+            out << (i ? ", " : "") << "\"" << columnNames[i] << "\"";
+        }
+        out << "], \"slices\": [";
+        for (size_t row = 0; row < numRows; ++row) {
+            out << (row ? ", " : "") << "{\"start\": " << starts[row]
+                << ", \"end\": " << ends[row] << ", \"values\": [";
+            for (size_t i = 0; i < columns.size(); ++i) {
+                out << (i ? ", " : "");
+                WriteJsonNumber(out, columns[i][row]);
+            }
+            out << "]}";
+        }
+        out << "]}\n";
+        if (!out)
+            return false;
+    }
+    return ReplaceFile(temporary, jsonPath);
+}
+
+bool DescriptorTable::Read(const std::filesystem::path &path,
+                           DescriptorTable &table) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    if (!in.read(magic, 4) || std::string(magic, 4) != "RDSC" ||
+        ReadValue<uint32_t>(in) != kVersion)
+        return false;
+
+    table = DescriptorTable{};
+    table.sampleRate = static_cast<int>(ReadValue<uint32_t>(in));
+    const uint32_t numColumns = ReadValue<uint32_t>(in);
+    const uint64_t numRows = ReadValue<uint64_t>(in);
+    // Counts that the file cannot hold mean it is damaged.
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (!in || error || numRows > fileSize / (2 * sizeof(int64_t)) ||
+        numColumns > fileSize / sizeof(uint32_t))
+        return false;
+
+    table.starts.resize(numRows);
+    table.ends.resize(numRows);
+    for (fluid::index &start : table.starts) {
+        start = ReadValue<int64_t>(in);
+    }
+    for (fluid::index &end : table.ends) {
+        end = ReadValue<int64_t>(in);
+    }
+    size_t namesSize = 0;
+    for (uint32_t i = 0; i < numColumns && in; ++i) {
+        const uint32_t length = ReadValue<uint32_t>(in);
+        if (length > fileSize)
+            return false;
+        std::string name(length, '\0');
+        in.read(name.data(), name.size());
+        namesSize += sizeof(uint32_t) + name.size();
+        table.columnNames.push_back(std::move(name));
+    }
+    in.ignore((8 - namesSize % 8) % 8);
+    table.columns.assign(numColumns, std::vector<float>(numRows));
+    for (std::vector<float> &column : table.columns) {
+        in.read(reinterpret_cast<char *>(column.data()),
+                numRows * sizeof(float));
+    }
+    return static_cast<bool>(in);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Per-slice descriptor statistics of a source file, one row per slice and
+// one column per statistic, written next to the file.
+//
+// The binary table is little-endian and stores each column contiguously so
+// that a tool reading one statistic touches nothing else:
+//
+//   offset  type      field
+//   0       char[4]   "RDSC"
+//   4       uint32    version (1)
+//   8       uint32    sample rate
+//   12      uint32    number of columns, m
+//   16      uint64    number of rows, n
+//   24      int64[n]  slice start positions in source frames
+//   ...     int64[n]  slice end positions in source frames
+//   ...               m column names, each a uint32 length and its bytes
+//   ...               zero padding to the next multiple of 8 bytes
+//   ...     float[n]  values of each column in turn, in name order
+//
+// The optional JSON view carries the same data for tools that prefer text.
+struct DescriptorTable {
+    static constexpr uint32_t kVersion = 1;
+
+    int sampleRate = 0;
+    std::vector<fluid::index> starts;
+    std::vector<fluid::index> ends;
+    std::vector<std::string> columnNames;
+    // One vector per column, each with a value per row.
+    std::vector<std::vector<float>> columns;
+
+    size_t NumRows() const { return starts.size(); }
+    int FindColumn(const std::string &name) const;
+    // Indices of the per-slice means, the columns that slices are compared
+    // and mapped by.
+    std::vector<size_t> MeanColumns() const;
+    // Appends the rows of another table with the same columns.
+    void Append(const DescriptorTable &other);
+    void AppendRow(const DescriptorTable &other, size_t row);
+
+    // "<source file>.rdsc".
+    static std::filesystem::path PathFor(const std::string &sourcePath);
+
+    // Replaces the file in one step; the JSON view goes beside it with
+    // ".json" appended.
+    bool Write(const std::filesystem::path &path, bool withJson) const;
+    static bool Read(const std::filesystem::path &path,
+                     DescriptorTable &table);
+};
@@ -6,13 +6,25 @@
 #include "../../dependencies/flucoma-core/include/flucoma/clients/common/Result.hpp"
 #include "../VectorBufferAdaptor.h"
 #include "IAlgorithm.h"
+#include "Ingest.h"
+#include "JobProgress.h"
+#include "SliceCache.h"
+#include "SliceIndex.h"
+#include "SliceMapping.h"
+#include "Spectrogram.h"
 
 #include "wdltypes.h"
 #include "reaper_plugin_functions.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <filesystem>
+#include <functional>
 #include <iomanip>
+#include <map>
 #include <sstream>
+#include <thread>
 
 using namespace fluid;
 using namespace client;
@@ -27,106 +39,140 @@ template <typename ClientType> class FlucomaAlgorithm : public IAlgorithm {
                   FluidDefaultAllocator()},
           mClient{mParams, mContext} {}
 
-    virtual ~FlucomaAlgorithm() override = default;
+    // Derived classes have shut down by now; this only catches a worker
+    // that one of them forgot, and cannot make that safe.
+    virtual ~FlucomaAlgorithm() override { Shutdown(); }
 
-    bool StartProcessItemAsync(MediaItem *item) override final {
-
-        SetMediaItemInfo_Value(item, "C_LOCK", true);
-        UpdateTimeline();
-
-        if (!item || !mApiProvider)
-            return false;
-        mIsFinishedFlag = false;
-        mProgress = 0.0;
+    bool StartProcessItemsAsync(
+        const std::vector<MediaItem *> &items) override final {
+        return StartProcess(items, nullptr);
+    }
 
-        MediaItem_Take *take = GetActiveTake(item);
-        if (!take)
-            return false;
+    bool StartProcessBufferAsync(const std::vector<MediaItem *> &items,
+                                 const StageAudio &audio) override final {
+        return audio.buffer && StartProcess(items, &audio);
+    }
 
-        PCM_source *source = GetMediaItemTake_Source(take);
-        if (!source)
+    bool StartProcessAudioAsync(InputBufferT::type audio,
+                                int sampleRate) override final {
+        BufferAdaptor::ReadAccess reader(audio.get());
+        if (!reader.exists() || !reader.valid() || !reader.numFrames())
             return false;
 
-        const int sampleRate = GetMediaSourceSampleRate(source);
-        const int numChannels = GetMediaSourceNumChannels(source);
-        const double itemLength = GetMediaItemInfo_Value(item, "D_LENGTH");
-        const double playrate = GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
-        const double takeOffset =
-            GetMediaItemTakeInfo_Value(take, "D_STARTOFFS");
-        const double sourceDuration = source->GetLength();
-
-        const double effectiveTakeDuration = itemLength * playrate;
-        const double actualDurationToProcess =
-            std::min(effectiveTakeDuration, sourceDuration - takeOffset);
-        const int frameCount =
-            static_cast<int>(sampleRate * actualDurationToProcess);
-
-        if (frameCount <= 0 || numChannels <= 0)
-            return false;
+        mItemsForAsync.clear();
+        mPlan = IngestPlan{};
+        mSourcePath.clear();
+        mOutputSourcePath.clear();
+        mSourceSignature.clear();
+        // Results stay in memory, exactly as for an intermediate stage.
+        mIsPipelineStage = true;
+        mJobProgress.SetWeights(0.0, 0.95, 0.0, 0.05);
 
-        std::vector<double> allChannelsAsDouble(frameCount * numChannels);
-        PCM_source_transfer_t transfer{};
-        transfer.time_s = takeOffset;
-        transfer.samplerate = static_cast<double>(sampleRate);
-        transfer.nch = numChannels;
-        transfer.length = frameCount;
-        transfer.samples = allChannelsAsDouble.data();
-        source->GetSamples(&transfer);
-
-        std::vector<float> allChannelsAsFloat(allChannelsAsDouble.begin(),
-                                              allChannelsAsDouble.end());
-        auto inputBuffer = InputBufferT::type(new fluid::VectorBufferAdaptor(
-            allChannelsAsFloat, numChannels, frameCount, sampleRate));
-
-        mItemForAsync = item;
-        mTakeForAsync = take;
-        mNumChannelsForAsync = numChannels;
+        mNumChannelsForAsync = static_cast<int>(reader.numChans());
         mSampleRateForAsync = sampleRate;
-
-        if (!DoProcess(inputBuffer, numChannels, frameCount, sampleRate)) {
-            return false;
-        }
-
-        return true;
+        mTakeStartFrame = 0;
+        mIngestStartFrame = 0;
+        mIngestFrameCount = reader.numFrames();
+        return StartAnalysis(std::move(audio));
     }
 
     bool IsFinished() override final {
         if (mIsFinishedFlag)
             return true;
-        Result result;
-        ProcessState processState = mClient.checkProgress(result);
-        mProgress = mClient.progress();
 
-        if (processState == fluid::client::ProcessState::kDone ||
-            processState == fluid::client::ProcessState::kDoneStillProcessing) {
-            mIsFinishedFlag = true;
-            mProgress = 1.0;
+        if (mUsesTask) {
+            if (mTaskRunning)
+                return false;
+            JoinTask();
+            mUsesTask = false;
+            if (!mTaskSucceeded)
+                return Finish(false);
+        } else if (mPhase == Phase::kAnalyse) {
+            Result result;
+            ProcessState processState = mClient.checkProgress(result);
+            mJobProgress.Report(mClient.progress());
+            if (processState != ProcessState::kDone &&
+                processState != ProcessState::kDoneStillProcessing)
+                return false;
         }
-        return mIsFinishedFlag;
-    }
 
-    bool FinalizeProcess(MediaItem *item) override final {
-        if (!mItemForAsync || item != mItemForAsync)
-            return false;
+        if (mCancelToken.IsCancelled())
+            return Finish(false);
 
-        bool success = HandleResults(mItemForAsync, mTakeForAsync,
-                                     mNumChannelsForAsync, mSampleRateForAsync);
+        switch (mPhase) {
+        case Phase::kIngest:
+            if (!StartAnalysis(std::move(mIngestedBuffer)))
+                return Finish(false);
+            return false;
+        case Phase::kAnalyse:
+            // The results no longer need the source; let it go before the
+            // outputs are written.
+            mParams.template set<0>(InputBufferT::type(), nullptr);
+            mPhase = Phase::kWrite;
+            mJobProgress.BeginPhase(JobProgress::kWrite);
+            if (!mIsPipelineStage && StartWritePhase(mSampleRateForAsync))
+                return false;
+            return Finish(true);
+        default:
+            return Finish(true);
+        }
+    }
 
-        mItemForAsync = nullptr;
-        mTakeForAsync = nullptr;
+    bool Succeeded() override final {
+        return mIsFinishedFlag && mSucceeded;
+    }
 
-        SetMediaItemInfo_Value(item, "C_LOCK", false);
+    bool FinalizeProcess() override final {
+        bool success = !mPlan.spans.empty();
+        for (size_t i = 0; i < mPlan.spans.size(); ++i) {
+            const IngestPlan::ItemSpan &span = mPlan.spans[i];
+            // Closing the project takes even locked items with it.
+            if (!ValidatePtr2(nullptr, span.item, "MediaItem*")) {
+                success = false;
+                continue;
+            }
+            mTakeStartFrame = span.startFrame;
+            success = HandleResults(span.item, span.take, mNumChannelsForAsync,
+                                    mSampleRateForAsync) &&
+                      success;
+            mJobProgress.Report(static_cast<double>(i + 1) /
+                                mPlan.spans.size());
+        }
+        if (!mPlan.spans.empty()) {
+            success = FinishResults(mSampleRateForAsync) && success;
+        }
+        mPlan.spans.clear();
+        mJobProgress.Complete();
 
-        if (success) {
-            UpdateTimeline();
+        // Results that split items may have removed some of them.
+        if (!LeavesProjectAlone()) {
+            for (MediaItem *item : mItemsForAsync) {
+                if (ValidatePtr2(nullptr, item, "MediaItem*")) {
+                    SetMediaItemInfo_Value(item, "C_LOCK", false);
+                }
+            }
+            if (success) {
+                UpdateTimeline();
+            }
         }
+        mItemsForAsync.clear();
 
         return success;
     }
 
-    void Cancel() override final { mClient.cancel(); }
+    void Cancel() override final {
+        mCancelToken.Cancel();
+        mClient.cancel();
+    }
+
+    void Shutdown() override final {
+        Cancel();
+        JoinTask();
+        mUsesTask = false;
+        mTaskRunning = false;
+    }
 
-    double GetProgress() override final { return mProgress; }
+    double GetProgress() override final { return mJobProgress.Get(); }
 
     bool SupportsSegmentation() override { return true; }
 
@@ -135,85 +181,377 @@ template <typename ClientType> class FlucomaAlgorithm : public IAlgorithm {
     bool CreatesTakes() override { return false; }
 
   protected:
+    // Runs whose results all go to a slice sink leave the project alone.
+    bool LeavesProjectAlone() { return mSliceSink && SupportsSliceSink(); }
+
     virtual bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                            int frameCount, int sampleRate) = 0;
     virtual bool HandleResults(MediaItem *item, MediaItem_Take *take,
                                int numChannels, int sampleRate) = 0;
 
+    // Lets a subclass narrow the span of source frames that gets ingested and
+    // analysed. Returning false skips the analysis altogether and goes
+    // straight to HandleResults.
+    virtual bool PlanIngest(MediaItem_Take *take, int sampleRate,
+                            fluid::index &startFrame,
+                            fluid::index &frameCount) {
+        return true;
+    }
+
+    // Lets go of whatever a failed or cancelled job allocated for results
+    // that will now never be read.
+    virtual void ReleaseResults() {}
+
+    // Called on the main thread after HandleResults has seen every item, for
+    // results that cover the job as a whole.
+    virtual bool FinishResults(int sampleRate) { return true; }
+
+    // Called once analysis has finished, on the main thread. Returning true
+    // means a task was started to write results out before HandleResults.
+    virtual bool StartWritePhase(int sampleRate) { return false; }
+
+    // Runs work on a background thread. The task reports the fraction of the
+    // current phase through mJobProgress and should return early once
+    // mCancelToken is cancelled; returning false fails the job.
+    void RunTask(std::function<bool()> task) {
+        // A task only starts once the one before it has finished, but its
+        // thread may not have been joined yet.
+        JoinTask();
+        mUsesTask = true;
+        mTaskRunning = true;
+        mTaskSucceeded = false;
+        mTaskThread = std::thread([this, task = std::move(task)]() {
+            mTaskSucceeded = task() && !mCancelToken.IsCancelled();
+            mTaskRunning = false;
+        });
+    }
+
+    // The items of the job and where each starts in the source. Empty when
+    // the audio was handed over directly.
+    const IngestPlan &GetIngestPlan() const { return mPlan; }
+    fluid::index GetIngestFrameCount() const { return mIngestFrameCount; }
+
+    SpectrogramKey MakeSpectrogramKey(fluid::index frameCount,
+                                      fluid::index windowSize,
+                                      fluid::index hopSize,
+                                      fluid::index fftSize,
+                                      bool summed = false) const {
+        return {mSourcePath, mIngestStartFrame, frameCount, windowSize,
+                hopSize,     fftSize,           summed};
+    }
+
+    // Safe to call from a task. Spectrograms of a known source range are
+    // shared with every other algorithm that asks for the same settings.
+    // Null once the job is cancelled.
+    std::shared_ptr<const Spectrogram>
+    GetSpectrogram(const SpectrogramKey &key,
+                   const fluid::client::BufferAdaptor *source) {
+        if (key.source.empty()) {
+            auto spectrogram =
+                std::make_shared<const Spectrogram>(source, key, mCancelToken);
+            return spectrogram->Cancelled() ? nullptr : spectrogram;
+        }
+        return GetSpectrogramCache().GetOrCompute(key, source, mCancelToken);
+    }
+
+    static std::string GetSourceFilePath(MediaItem_Take *take) {
+        char filePath[4096] = "";
+        if (take) {
+            auto takeSource = GetMediaItemTake_Source(take);
+            if (takeSource) {
+                auto srcParent = GetMediaSourceParent(takeSource);
+                GetMediaSourceFileName(srcParent ? srcParent : takeSource,
+                                       filePath, sizeof(filePath));
+            }
+        }
+        return filePath;
+    }
+
   protected:
     FluidContext mContext;
     typename ClientType::ParamSetType mParams;
     ClientType mClient;
 
+    // Source frame at which the take being handled starts, and at which the
+    // buffer handed to DoProcess starts.
+    fluid::index mTakeStartFrame = 0;
+    fluid::index mIngestStartFrame = 0;
+    // Empty when the ingested frames cannot be shared with other jobs.
+    std::string mSourcePath;
+    // File the items play, used to place written outputs.
+    std::string mOutputSourcePath;
+    // Describes the upstream stage when running as part of a pipeline.
+    std::string mSourceSignature;
+
+    JobProgress mJobProgress;
+
   private:
-    MediaItem *mItemForAsync = nullptr;
-    MediaItem_Take *mTakeForAsync = nullptr;
+    bool StartProcess(const std::vector<MediaItem *> &items,
+                      const StageAudio *upstream) {
+        mItemsForAsync = items;
+        if (!LeavesProjectAlone()) {
+            for (MediaItem *item : mItemsForAsync) {
+                SetMediaItemInfo_Value(item, "C_LOCK", true);
+            }
+            UpdateTimeline();
+        }
+
+        mIsFinishedFlag = true;
+        mSucceeded = false;
+        mJobProgress.SetWeights(0.15, 0.65,
+                                CreatesTakes() && !mIsPipelineStage ? 0.15
+                                                                    : 0.0,
+                                0.05);
+        mJobProgress.BeginPhase(JobProgress::kIngest);
+        mPlan = IngestPlan::ForItems(items);
+
+        if (mPlan.spans.empty() || !mApiProvider)
+            return false;
+
+        // Sections of a file start their offsets at the section, so their
+        // frames cannot be compared with other users of the same file.
+        mSourcePath = GetMediaSourceParent(mPlan.source)
+                          ? std::string()
+                          : GetSourceFilePath(mPlan.spans.front().take);
+        mSourceSignature.clear();
+        int numChannels = mPlan.numChannels;
+        if (upstream) {
+            BufferAdaptor::ReadAccess reader(upstream->buffer.get());
+            if (!reader.exists() || !reader.valid() || !reader.numFrames())
+                return false;
+            numChannels = static_cast<int>(reader.numChans());
+            mSourceSignature = upstream->signature;
+            if (!mSourcePath.empty() && !mSourceSignature.empty()) {
+                mSourcePath += "|" + mSourceSignature;
+            }
+        }
+
+        if (numChannels <= 0)
+            return false;
+
+        const int sampleRate = mPlan.sampleRate;
+        mNumChannelsForAsync = numChannels;
+        mSampleRateForAsync = sampleRate;
+        mOutputSourcePath = GetSourceFilePath(mPlan.spans.front().take);
+
+        mIngestStartFrame = mPlan.startFrame;
+        mIngestFrameCount = mPlan.endFrame - mPlan.startFrame;
+        if (!PlanIngest(mPlan.spans.front().take, sampleRate,
+                        mIngestStartFrame, mIngestFrameCount)) {
+            mJobProgress.BeginPhase(JobProgress::kFinalize);
+            mSucceeded = true;
+            return true;
+        }
+
+        if (upstream) {
+            if (upstream->startFrame == mIngestStartFrame &&
+                upstream->buffer->numFrames() == mIngestFrameCount) {
+                return StartAnalysis(upstream->buffer);
+            }
+            return StartAnalysis(
+                CopyUpstreamFrames(*upstream, numChannels, mIngestFrameCount));
+        }
+
+        // Decode on a worker through a private reader so the UI stays
+        // responsive and the read can be abandoned part way.
+        PCM_source *reader = mPlan.source->Duplicate();
+        if (!reader)
+            return false;
+
+        mPhase = Phase::kIngest;
+        mIsFinishedFlag = false;
+        mSucceeded = false;
+        RunTask([this, reader, plan = mPlan, from = mIngestStartFrame,
+                 count = mIngestFrameCount]() {
+            mIngestedBuffer =
+                plan.Read(reader, from, count, mCancelToken, &mJobProgress);
+            delete reader;
+            return mIngestedBuffer != nullptr;
+        });
+        return true;
+    }
+
+    bool StartAnalysis(InputBufferT::type inputBuffer) {
+        mPhase = Phase::kAnalyse;
+        mJobProgress.BeginPhase(JobProgress::kAnalyse);
+        mIsFinishedFlag = false;
+        mSucceeded = false;
+        if (!DoProcess(inputBuffer, mNumChannelsForAsync,
+                       static_cast<int>(mIngestFrameCount),
+                       mSampleRateForAsync)) {
+            Finish(false);
+            return false;
+        }
+        return true;
+    }
+
+    bool Finish(bool success) {
+        if (!success) {
+            mPlan.spans.clear();
+            mParams.template set<0>(InputBufferT::type(), nullptr);
+            ReleaseResults();
+        }
+        mIngestedBuffer.reset();
+        mPhase = Phase::kDone;
+        mIsFinishedFlag = true;
+        mSucceeded = success;
+        if (success) {
+            mJobProgress.BeginPhase(JobProgress::kFinalize);
+        } else {
+            mJobProgress.Complete();
+        }
+        return true;
+    }
+
+    // Copies the requested range out of an upstream stage's output, padding
+    // with silence wherever the stage did not cover it.
+    InputBufferT::type CopyUpstreamFrames(const StageAudio &upstream,
+                                          int numChannels,
+                                          fluid::index frameCount) {
+        std::vector<float> interleaved(frameCount * numChannels);
+        BufferAdaptor::ReadAccess reader(upstream.buffer.get());
+        const fluid::index offset = mIngestStartFrame - upstream.startFrame;
+        for (int c = 0; c < numChannels; ++c) {
+            auto samples = reader.samps(c);
+            for (fluid::index i = 0; i < frameCount; ++i) {
+                const fluid::index frame = offset + i;
+                if (frame >= 0 && frame < reader.numFrames()) {
+                    interleaved[i * numChannels + c] = samples(frame);
+                }
+            }
+        }
+        return std::make_shared<fluid::VectorBufferAdaptor>(
+            std::move(interleaved), numChannels, frameCount,
+            mSampleRateForAsync);
+    }
+
+    void JoinTask() {
+        if (mTaskThread.joinable()) {
+            mTaskThread.join();
+        }
+    }
+
+    enum class Phase { kIngest, kAnalyse, kWrite, kDone };
+
+    std::vector<MediaItem *> mItemsForAsync;
+    IngestPlan mPlan;
+    Phase mPhase = Phase::kDone;
+    fluid::index mIngestFrameCount = 0;
+    InputBufferT::type mIngestedBuffer;
     int mNumChannelsForAsync = 0;
     int mSampleRateForAsync = 0;
     bool mIsFinishedFlag = false;
-    double mProgress = 0.0;
+    bool mSucceeded = false;
+
+    std::thread mTaskThread;
+    std::atomic<bool> mTaskRunning{false};
+    std::atomic<bool> mTaskSucceeded{false};
+    bool mUsesTask = false;
 };
 
 template <typename ClientType>
 class AudioOutputAlgorithm : public FlucomaAlgorithm<ClientType> {
   protected:
     using FlucomaAlgorithm<ClientType>::mApiProvider;
+    using FlucomaAlgorithm<ClientType>::mTakeStartFrame;
+    using FlucomaAlgorithm<ClientType>::mIngestStartFrame;
+    using FlucomaAlgorithm<ClientType>::mSourceSignature;
 
     AudioOutputAlgorithm(ReacomaExtension *apiProvider)
         : FlucomaAlgorithm<ClientType>(apiProvider) {}
 
-    void AddOutputToTake(MediaItem *item, BufferT::type output, int sampleRate,
-                         const std::string &suffix) {
-        if (!output)
-            return;
-
-        fluid::client::BufferAdaptor::ReadAccess bufferReader(output.get());
-        if (!bufferReader.exists() || !bufferReader.valid())
-            return;
+    // Returns the output buffer with the given name once processing is done.
+    virtual BufferT::type FindOutput(const std::string &name) = 0;
 
-        auto numFrames = bufferReader.numFrames();
-        auto numChans = bufferReader.numChans();
+  public:
+    StageAudio GetAudioOutput(const std::string &name) override {
+        StageAudio audio;
+        audio.buffer = FindOutput(name);
+        audio.startFrame = mIngestStartFrame;
+        audio.signature = mSourceSignature + this->GetName() + "." + name +
+                          "(" + this->GetParamSignature() + ")";
+        return audio;
+    }
 
-        std::vector<std::vector<ReaSample>> channelData(
-            numChans, std::vector<ReaSample>(numFrames));
-        std::vector<ReaSample *> pointerArray(numChans);
-        const float *sourceData = bufferReader.allFrames().data();
+  protected:
+    // Each output is written to disk once per job, on a worker, before any
+    // takes are added.
+    bool StartWritePhase(int sampleRate) override {
+        auto now = std::chrono::system_clock::now();
+        auto in_time_t = std::chrono::system_clock::to_time_t(now);
+        std::stringstream ss;
+        ss << std::put_time(std::localtime(&in_time_t), "%Y%m%d%H%M%S");
 
-        for (int i = 0; i < numChans; ++i) {
-            for (int j = 0; j < numFrames; ++j) {
-                channelData[i][j] =
-                    static_cast<ReaSample>(sourceData[j * numChans + i]);
+        this->RunTask([this, sampleRate, timestamp = ss.str(),
+                       names = this->GetAudioOutputNames(),
+                       sourcePath = std::filesystem::path(
+                           this->mOutputSourcePath)]() {
+            for (size_t i = 0; i < names.size(); ++i) {
+                auto path = WriteOutput(FindOutput(names[i]), sampleRate,
+                                        sourcePath, timestamp + "_" + names[i],
+                                        static_cast<double>(i) / names.size(),
+                                        1.0 / names.size());
+                if (this->mCancelToken.IsCancelled())
+                    return false;
+                mWrittenOutputs[names[i]] = path;
             }
-            pointerArray[i] = channelData[i].data();
-        }
+            return true;
+        });
+        return true;
+    }
 
-        char originalFilePathCStr[4096] = "";
-        auto activeTake = GetActiveTake(item);
-        if (activeTake) {
-            auto takeSource = GetMediaItemTake_Source(activeTake);
-            if (takeSource) {
-                auto srcParent = GetMediaSourceParent(takeSource);
-                GetMediaSourceFileName(srcParent ? srcParent : takeSource,
-                                       originalFilePathCStr,
-                                       sizeof(originalFilePathCStr));
+    // Every item of the job gets a take that points at its own range of the
+    // written output.
+    void AddOutputToTake(MediaItem *item, BufferT::type output, int sampleRate,
+                         const std::string &suffix) {
+        auto written = mWrittenOutputs.find(suffix);
+        if (written == mWrittenOutputs.end() || written->second.empty())
+            return;
+
+        const std::filesystem::path &outputFilePath = written->second;
+        PCM_source *newSource =
+            PCM_Source_CreateFromFile(outputFilePath.string().c_str());
+        if (newSource) {
+            MediaItem_Take *newTake = AddTakeToMediaItem(item);
+            if (newTake) {
+                std::string takeName = outputFilePath.stem().string();
+                GetSetMediaItemTakeInfo(newTake, "P_SOURCE", newSource);
+                GetSetMediaItemTakeInfo(newTake, "P_NAME",
+                                        (char *)takeName.c_str());
+                SetMediaItemTakeInfo_Value(
+                    newTake, "D_STARTOFFS",
+                    static_cast<double>(mTakeStartFrame - mIngestStartFrame) /
+                        sampleRate);
             }
         }
+    }
 
-        auto now = std::chrono::system_clock::now();
-        auto in_time_t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&in_time_t), "%Y%m%d%H%M%S");
+  private:
+    // Streams the output to disk in chunks. A cancelled write removes the
+    // partial file and returns an empty path.
+    std::filesystem::path WriteOutput(BufferT::type output, int sampleRate,
+                                      const std::filesystem::path &sourcePath,
+                                      const std::string &suffix,
+                                      double progressStart,
+                                      double progressSpan) {
+        if (!output)
+            return {};
 
-        std::filesystem::path originalPath(originalFilePathCStr);
-        auto parentDir = originalPath.parent_path();
-        auto stem = originalPath.stem().string();
+        fluid::client::BufferAdaptor::ReadAccess bufferReader(output.get());
+        if (!bufferReader.exists() || !bufferReader.valid())
+            return {};
 
-        std::filesystem::path reacomaFolder = parentDir / "reacoma";
-        std::filesystem::create_directory(reacomaFolder);
+        auto numFrames = bufferReader.numFrames();
+        auto numChans = bufferReader.numChans();
+
+        std::filesystem::path reacomaFolder =
+            sourcePath.parent_path() / "reacoma";
+        std::error_code error;
+        std::filesystem::create_directory(reacomaFolder, error);
 
-        std::string takeName = stem + "_" + ss.str() + "_" + suffix;
-        std::string newFilename = takeName + ".wav";
-        std::filesystem::path outputFilePath = reacomaFolder / newFilename;
+        std::string takeName = sourcePath.stem().string() + "_" + suffix;
+        std::filesystem::path outputFilePath =
+            reacomaFolder / (takeName + ".wav");
 
         struct WavConfig {
             char fourcc[4];
@@ -226,23 +564,46 @@ class AudioOutputAlgorithm : public FlucomaAlgorithm<ClientType> {
         PCM_sink *sink = PCM_Sink_CreateEx(
             nullptr, outputFilePath.string().c_str(), (const char *)&config,
             sizeof(config), numChans, sampleRate, true);
-        if (sink) {
-            sink->WriteDoubles(pointerArray.data(), numFrames, numChans, 0, 1);
-            delete sink;
+        if (!sink)
+            return {};
+
+        constexpr fluid::index chunkFrames = 65536;
+        std::vector<std::vector<ReaSample>> channelData(
+            numChans, std::vector<ReaSample>(chunkFrames));
+        std::vector<ReaSample *> pointerArray(numChans);
+        for (int i = 0; i < numChans; ++i) {
+            pointerArray[i] = channelData[i].data();
         }
 
-        PCM_source *newSource =
-            PCM_Source_CreateFromFile(outputFilePath.c_str());
-        if (newSource) {
-            MediaItem_Take *newTake = AddTakeToMediaItem(item);
-            if (newTake) {
-                GetSetMediaItemTakeInfo(newTake, "P_SOURCE", newSource);
-                GetSetMediaItemTakeInfo(newTake, "P_NAME",
-                                        (char *)takeName.c_str());
+        for (fluid::index done = 0; done < numFrames; done += chunkFrames) {
+            if (this->mCancelToken.IsCancelled()) {
+                delete sink;
+                std::filesystem::remove(outputFilePath, error);
+                return {};
+            }
+
+            const fluid::index length = std::min(chunkFrames, numFrames - done);
+            for (int i = 0; i < numChans; ++i) {
+                auto samples = bufferReader.samps(i);
+                for (fluid::index j = 0; j < length; ++j) {
+                    channelData[i][j] =
+                        static_cast<ReaSample>(samples(done + j));
+                }
             }
+            sink->WriteDoubles(pointerArray.data(), static_cast<int>(length),
+                               numChans, 0, 1);
+            this->mJobProgress.Report(progressStart +
+                                      progressSpan *
+                                          static_cast<double>(done + length) /
+                                          numFrames);
         }
+
+        delete sink;
+        return outputFilePath;
     }
 
+    std::map<std::string, std::filesystem::path> mWrittenOutputs;
+
   public:
     bool SupportsSegmentation() { return false; }
 
@@ -250,3 +611,605 @@ class AudioOutputAlgorithm : public FlucomaAlgorithm<ClientType> {
 
     bool CreatesTakes() { return true; }
 };
+
+template <typename ClientType>
+class SlicerAlgorithm : public FlucomaAlgorithm<ClientType> {
+  protected:
+    using FlucomaAlgorithm<ClientType>::mApiProvider;
+    using FlucomaAlgorithm<ClientType>::mParams;
+    using FlucomaAlgorithm<ClientType>::mTakeStartFrame;
+    using FlucomaAlgorithm<ClientType>::mIngestStartFrame;
+
+    SlicerAlgorithm(ReacomaExtension *apiProvider)
+        : FlucomaAlgorithm<ClientType>(apiProvider) {}
+
+  public:
+    bool SupportsSliceSink() override { return true; }
+
+    void SetMarkerStyle(const std::string &name, int color) override {
+        mMarkerName = name;
+        mMarkerColor = color;
+    }
+
+    std::vector<fluid::index> GetSliceFrames() override {
+        std::vector<fluid::index> slices;
+        ReadSliceOutput(slices, nullptr);
+        return slices;
+    }
+
+    std::vector<float> GetSliceStrengths() override {
+        std::vector<fluid::index> slices;
+        std::vector<float> strengths;
+        ReadSliceOutput(slices, &strengths);
+        return strengths;
+    }
+
+    DetectionCurve GetDetectionCurve() override {
+        return DecimateCurve(mCachedEntry.curve.values.empty()
+                                 ? mDetectionCurve
+                                 : mCachedEntry.curve);
+    }
+
+  protected:
+    // Number of source frames either side of a point that can influence
+    // whether a slice is detected there.
+    virtual fluid::index GetContextFrames() const = 0;
+
+    // Slicers aiming for a number of slices need to see the whole range at
+    // once, so they never build on cached slices.
+    virtual bool UsesSliceTarget() const { return false; }
+    // Slices to aim for within an item covering frameCount frames.
+    virtual fluid::index TargetSlicesFor(fluid::index frameCount,
+                                         int sampleRate) const {
+        return 0;
+    }
+
+    // A target count wins over a density in slices per second; 0 means the
+    // threshold is used as it is.
+    static fluid::index TargetSliceCount(double count, double density,
+                                         fluid::index frameCount,
+                                         int sampleRate) {
+        if (count > 0)
+            return static_cast<fluid::index>(count);
+        return std::lround(density * frameCount / sampleRate);
+    }
+
+    // Bisects the threshold between the lowest and highest detection values,
+    // re-picking slices from the same curve each time, and returns the
+    // threshold whose count came closest to the target.
+    static double
+    SearchThreshold(const std::vector<double> &curve, fluid::index target,
+                    const std::function<fluid::index(double)> &countSlices) {
+        if (curve.empty())
+            return 0;
+
+        auto range = std::minmax_element(curve.begin(), curve.end());
+        double low = *range.first;
+        double high = *range.second;
+        double best = high;
+        fluid::index bestError = target;
+        for (int i = 0; i < 40 && bestError > 0; ++i) {
+            const double threshold = (low + high) / 2;
+            const fluid::index count = countSlices(threshold);
+            const fluid::index error = std::abs(count - target);
+            if (error < bestError) {
+                best = threshold;
+                bestError = error;
+            }
+            if (count > target) {
+                low = threshold;
+            } else {
+                high = threshold;
+            }
+        }
+        return best;
+    }
+
+    // For slicers that run their own detector in a task. The curve holds one
+    // value per analysis hop, the first at firstFrame of the ingested audio,
+    // and a peak picked at value i is a slice at firstFrame + i * hopSize.
+    // Slices are picked at the threshold, or with a slice target at the one
+    // whose count comes closest to each item's own target, and written to
+    // the slice output.
+    void WriteCurveSlices(BufferAdaptor *output,
+                          const std::vector<double> &curve,
+                          fluid::index firstFrame, fluid::index hopSize,
+                          int sampleRate) {
+        mDetectionCurve.startFrame = mIngestStartFrame + firstFrame;
+        mDetectionCurve.hop = hopSize;
+        mDetectionCurve.values.assign(curve.begin(), curve.end());
+        mCurveSampleRate = sampleRate;
+
+        std::vector<fluid::index> slices;
+        std::vector<float> strengths;
+        if (UsesSliceTarget()) {
+            PickTargetSlices(curve, firstFrame, hopSize, sampleRate, slices,
+                             strengths);
+        } else {
+            PickCurveSlices(curve, firstFrame, hopSize, 0, 0, slices,
+                            strengths);
+        }
+        WriteDetectedSlices(output, slices, strengths, sampleRate);
+    }
+
+    // Slicers that run their own detector say which of their parameters
+    // shape the detection curve, so that a cached curve can be picked again
+    // when only the others have changed. Empty for slicers that run their
+    // client, which only leaves slices to cache.
+    virtual std::string GetCurveSignature() const { return {}; }
+
+    // Indices of the curve values that are slices at the threshold, with
+    // the value each slice is given as its strength.
+    virtual void PickPeaks(const std::vector<double> &curve, double threshold,
+                           std::vector<fluid::index> &peaks,
+                           std::vector<float> &strengths) const {}
+
+    virtual double GetThreshold() const { return 0; }
+
+    std::string GetSignatureOf(std::initializer_list<int> params) const {
+        std::string signature;
+        for (int param : params) {
+            signature += std::to_string(this->GetParamValue(param)) + ';';
+        }
+        return signature;
+    }
+
+    // Fills the slice output the way the clients do, with the detection
+    // value of each slice in a second channel.
+    static void WriteDetectedSlices(BufferAdaptor *output,
+                                    const std::vector<fluid::index> &slices,
+                                    const std::vector<float> &strengths,
+                                    int sampleRate) {
+        BufferAdaptor::Access writer(output);
+        if (slices.empty()) {
+            writer.resize(1, 1, sampleRate);
+            writer.samps(0)(0) = -1;
+            return;
+        }
+        writer.resize(static_cast<fluid::index>(slices.size()), 2,
+                      sampleRate);
+        for (size_t i = 0; i < slices.size(); ++i) {
+            writer.samps(0)(i) = static_cast<float>(slices[i]);
+            writer.samps(1)(i) = strengths[i];
+        }
+    }
+
+    bool PlanIngest(MediaItem_Take *take, int sampleRate,
+                    fluid::index &startFrame,
+                    fluid::index &frameCount) override {
+        const fluid::index requestedStart = startFrame;
+        const fluid::index requestedEnd = startFrame + frameCount;
+
+        mSourceKey = this->mSourcePath.empty()
+                         ? std::string()
+                         : this->mSourcePath + "|" + this->GetName();
+        mCachedEntry = SliceCache::Entry{};
+        mCachedEntry.paramSignature =
+            this->GetParamSignature() + std::to_string(sampleRate);
+        const std::string curveSignature = GetCurveSignature();
+        if (!curveSignature.empty()) {
+            mCachedEntry.curveSignature =
+                curveSignature + std::to_string(sampleRate);
+        }
+        mCachedEntry.startFrame = requestedStart;
+        mCachedEntry.endFrame = requestedEnd;
+        mFreshStart = requestedStart;
+        mFreshEnd = requestedEnd;
+        mRanAnalysis = true;
+        mResultsCollected = false;
+        mDetectionCurve = DetectionCurve{};
+        mCurveSampleRate = sampleRate;
+
+        // A cached curve can be picked again at any threshold; cached slices
+        // are only any use if every parameter is the same.
+        const SliceCache::Entry *cached =
+            mSourceKey.empty() ? nullptr
+                               : mApiProvider->GetSliceCache().Find(mSourceKey);
+        mUsesCachedCurve = cached && !mCachedEntry.curveSignature.empty() &&
+                           cached->curveSignature ==
+                               mCachedEntry.curveSignature &&
+                           !cached->curve.values.empty();
+        if (!cached || UsesSliceTarget() ||
+            (!mUsesCachedCurve &&
+             cached->paramSignature != mCachedEntry.paramSignature) ||
+            requestedEnd <= cached->startFrame ||
+            requestedStart >= cached->endFrame) {
+            mUsesCachedCurve = false;
+            return true;
+        }
+
+        const bool extendsStart = requestedStart < cached->startFrame;
+        const bool extendsEnd = requestedEnd > cached->endFrame;
+        if (extendsStart && extendsEnd) {
+            mUsesCachedCurve = false;
+            return true;
+        }
+
+        // A fresh curve has to fall on the cached curve's hops, so the
+        // ingest starts a whole number of hops from where the cached one did.
+        auto alignToCurve = [cached, this](fluid::index frame) {
+            if (!mUsesCachedCurve)
+                return frame;
+            const fluid::index hop = cached->curve.hop;
+            return frame - ((frame - cached->curveIngestStart) % hop + hop) %
+                               hop;
+        };
+        const fluid::index context = GetContextFrames();
+        if (extendsEnd) {
+            mFreshStart = std::max(requestedStart, cached->endFrame - context);
+            startFrame =
+                alignToCurve(std::max(requestedStart, mFreshStart - context));
+            frameCount = requestedEnd - startFrame;
+        } else if (extendsStart) {
+            mFreshEnd = std::min(requestedEnd, cached->startFrame + context);
+            startFrame = alignToCurve(requestedStart);
+            frameCount =
+                std::min(requestedEnd, mFreshEnd + context) - startFrame;
+        } else {
+            mFreshStart = mFreshEnd = requestedStart;
+            mRanAnalysis = false;
+        }
+
+        mCachedEntry.startFrame = std::min(requestedStart, cached->startFrame);
+        mCachedEntry.endFrame = std::max(requestedEnd, cached->endFrame);
+        if (mUsesCachedCurve) {
+            mCachedEntry.curve = cached->curve;
+            mCachedEntry.curveIngestStart = cached->curveIngestStart;
+            return mRanAnalysis;
+        }
+        const bool hasStrengths =
+            cached->strengths.size() == cached->slices.size();
+        for (size_t i = 0; i < cached->slices.size(); ++i) {
+            const fluid::index slice = cached->slices[i];
+            if (slice < mFreshStart || slice >= mFreshEnd) {
+                mCachedEntry.slices.push_back(slice);
+                if (hasStrengths) {
+                    mCachedEntry.strengths.push_back(cached->strengths[i]);
+                }
+            }
+        }
+        return mRanAnalysis;
+    }
+
+    bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
+                       int sampleRate) override {
+        std::vector<fluid::index> &slices = mCachedEntry.slices;
+
+        if (!mResultsCollected) {
+            if (!CollectSlices())
+                return false;
+            if (!mSourceKey.empty()) {
+                mApiProvider->GetSliceCache().Store(mSourceKey, mCachedEntry);
+            }
+            if (this->mSliceOutput.sidecar) {
+                WriteSidecar(sampleRate);
+            }
+            mResultsCollected = true;
+        }
+
+        SliceMapping mapping;
+        mapping.takeStartFrame = mTakeStartFrame;
+        mapping.itemLength = GetMediaItemInfo_Value(item, "D_LENGTH");
+        mapping.playrate = GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+        mapping.sampleRate = sampleRate;
+        mapping.minGap = this->mSliceOutput.minGap;
+        const SliceMapping::Positions positions = mapping.Map(slices);
+
+        if (this->mSliceSink) {
+            this->mSliceSink(item, positions.itemTimes);
+            return true;
+        }
+
+        if (!this->mSliceOutput.takeMarkers)
+            return true;
+
+        int markerCount = GetNumTakeMarkers(take);
+        for (int i = markerCount - 1; i >= 0; i--) {
+            if (!mMarkerName.empty()) {
+                char name[256] = "";
+                GetTakeMarker(take, i, name, sizeof(name), nullptr);
+                if (mMarkerName != name)
+                    continue;
+            }
+            DeleteTakeMarker(take, i);
+        }
+
+        for (double position : positions.sourceTimes) {
+            SetTakeMarker(take, -1, mMarkerName.c_str(), &position,
+                          mMarkerColor ? &mMarkerColor : nullptr);
+        }
+        return true;
+    }
+
+  private:
+    // Everything this slicer knows about the source, including slices kept
+    // from earlier runs, goes into one sidecar per source and slicer.
+    void WriteSidecar(int sampleRate) {
+        if (this->mSourcePath.empty())
+            return;
+
+        std::string name = mMarkerName.empty() ? this->GetName() : mMarkerName;
+        if (!this->mSourceSignature.empty()) {
+            // Slices of derived audio, such as a pipeline stage's output,
+            // must not overwrite those of the source itself.
+            std::stringstream hash;
+            hash << std::hex
+                 << (std::hash<std::string>{}(this->mSourceSignature) &
+                     0xffffffff);
+            name += " " + hash.str();
+        }
+
+        SliceIndex index;
+        index.sampleRate = sampleRate;
+        index.startFrame = mCachedEntry.startFrame;
+        index.endFrame = mCachedEntry.endFrame;
+        index.frames = mCachedEntry.slices;
+        index.strengths = mCachedEntry.strengths;
+        index.curve = GetDetectionCurve();
+        index.Write(SliceIndex::PathFor(this->mOutputSourcePath, name),
+                    this->mSliceOutput.sidecarJson);
+    }
+
+    // Brings this run's slices, and its curve if the slicer has one,
+    // together with what was kept from the cache.
+    bool CollectSlices() {
+        if (mUsesCachedCurve) {
+            if (mRanAnalysis && !JoinCachedCurve())
+                return false;
+            PickCachedCurve();
+            return true;
+        }
+        if (mRanAnalysis && !MergeSliceOutput())
+            return false;
+        // Only a curve over everything the entry covers can stand in for
+        // its slices.
+        if (!mCachedEntry.curveSignature.empty() &&
+            !mDetectionCurve.values.empty() &&
+            mFreshStart == mCachedEntry.startFrame &&
+            mFreshEnd == mCachedEntry.endFrame) {
+            mCachedEntry.curve = mDetectionCurve;
+            mCachedEntry.curveIngestStart = mIngestStartFrame;
+        }
+        return true;
+    }
+
+    // Adds the fresh slices of this run to those kept from the cache.
+    // Strengths are only kept while every slice has one.
+    bool MergeSliceOutput() {
+        std::vector<fluid::index> found;
+        std::vector<float> foundStrengths;
+        if (!ReadSliceOutput(found, &foundStrengths))
+            return false;
+
+        std::vector<fluid::index> &slices = mCachedEntry.slices;
+        std::vector<float> &strengths = mCachedEntry.strengths;
+        const bool keepStrengths = foundStrengths.size() == found.size() &&
+                                   strengths.size() == slices.size();
+
+        std::vector<std::pair<fluid::index, float>> merged;
+        for (size_t i = 0; i < slices.size(); ++i) {
+            merged.emplace_back(slices[i], keepStrengths ? strengths[i] : 0);
+        }
+        for (size_t i = 0; i < found.size(); ++i) {
+            fluid::index slice = mIngestStartFrame + found[i];
+            if (slice >= mFreshStart && slice < mFreshEnd) {
+                merged.emplace_back(slice,
+                                    keepStrengths ? foundStrengths[i] : 0);
+            }
+        }
+        std::sort(merged.begin(), merged.end());
+
+        slices.clear();
+        strengths.clear();
+        for (const auto &[slice, strength] : merged) {
+            slices.push_back(slice);
+            if (keepStrengths) {
+                strengths.push_back(strength);
+            }
+        }
+        return true;
+    }
+
+    // Slices in the analysis output, relative to the ingested audio, and
+    // their strengths if the output carries them.
+    bool ReadSliceOutput(std::vector<fluid::index> &slices,
+                         std::vector<float> *strengths) {
+        auto processedSlicesBuffer = mParams.template get<5>();
+        BufferAdaptor::ReadAccess reader(processedSlicesBuffer.get());
+
+        if (!reader.exists() || !reader.valid())
+            return false;
+
+        auto view = reader.samps(0);
+        if (strengths && reader.numChans() > 1) {
+            auto strengthView = reader.samps(1);
+            SliceMapping::CollectPositive(view, slices, &strengthView,
+                                          strengths);
+        } else {
+            SliceMapping::CollectPositive(view, slices);
+        }
+        return true;
+    }
+
+    // Slices no earlier than minFrame, from the curve described as for
+    // WriteCurveSlices.
+    void PickCurveSlices(const std::vector<double> &curve,
+                         fluid::index firstFrame, fluid::index hopSize,
+                         fluid::index minFrame, fluid::index targetSlices,
+                         std::vector<fluid::index> &slices,
+                         std::vector<float> &strengths) const {
+        std::vector<fluid::index> peaks;
+        auto pick = [&](double threshold) {
+            PickPeaks(curve, threshold, peaks, strengths);
+            return static_cast<fluid::index>(peaks.size());
+        };
+        double threshold = GetThreshold();
+        if (targetSlices > 0) {
+            threshold = SearchThreshold(curve, targetSlices, pick);
+        }
+        pick(threshold);
+
+        slices.clear();
+        for (fluid::index peak : peaks) {
+            slices.push_back(std::max(minFrame, firstFrame + peak * hopSize));
+        }
+    }
+
+    // Picks the part of the curve under each item on its own, against that
+    // item's target, so that items sharing a source each get their share.
+    // Where items overlap, the overlap holds the slices of both. Audio handed
+    // over directly counts as one item.
+    void PickTargetSlices(const std::vector<double> &curve,
+                          fluid::index firstFrame, fluid::index hopSize,
+                          int sampleRate, std::vector<fluid::index> &slices,
+                          std::vector<float> &strengths) const {
+        std::vector<std::pair<fluid::index, fluid::index>> ranges;
+        for (const IngestPlan::ItemSpan &span : this->GetIngestPlan().spans) {
+            const fluid::index start = span.startFrame - mIngestStartFrame;
+            ranges.emplace_back(start, start + span.frameCount);
+        }
+        if (ranges.empty()) {
+            ranges.emplace_back(0, this->GetIngestFrameCount());
+        }
+
+        // Index of the first value whose slice is at or after frame.
+        const auto numValues = static_cast<fluid::index>(curve.size());
+        auto firstValueFrom = [=](fluid::index frame) {
+            const fluid::index offset = frame - firstFrame;
+            const fluid::index value = offset > 0
+                                           ? (offset + hopSize - 1) / hopSize
+                                           : -(-offset / hopSize);
+            return std::clamp<fluid::index>(value, 0, numValues);
+        };
+
+        std::vector<std::pair<fluid::index, float>> picked;
+        for (const auto &[start, end] : ranges) {
+            const fluid::index from = firstValueFrom(start);
+            const fluid::index to = firstValueFrom(end);
+            if (from >= to)
+                continue;
+
+            const std::vector<double> values(curve.begin() + from,
+                                             curve.begin() + to);
+            std::vector<fluid::index> spanSlices;
+            std::vector<float> spanStrengths;
+            PickCurveSlices(values, firstFrame + from * hopSize, hopSize, 0,
+                            TargetSlicesFor(end - start, sampleRate),
+                            spanSlices, spanStrengths);
+            for (size_t i = 0; i < spanSlices.size(); ++i) {
+                picked.emplace_back(spanSlices[i], spanStrengths[i]);
+            }
+        }
+        std::sort(picked.begin(), picked.end());
+        picked.erase(std::unique(picked.begin(), picked.end(),
+                                 [](const auto &a, const auto &b) {
+                                     return a.first == b.first;
+                                 }),
+                     picked.end());
+
+        slices.clear();
+        strengths.clear();
+        for (const auto &[slice, strength] : picked) {
+            slices.push_back(slice);
+            strengths.push_back(strength);
+        }
+    }
+
+    // Lays this run's curve over the cached one. Fresh values win inside
+    // [mFreshStart, mFreshEnd), cached ones elsewhere, and either fills in
+    // where the other has none. PlanIngest lined the ingest up with the
+    // cached hops.
+    bool JoinCachedCurve() {
+        const DetectionCurve &fresh = mDetectionCurve;
+        DetectionCurve &cached = mCachedEntry.curve;
+        const fluid::index hop = fresh.hop;
+        if (fresh.values.empty() || cached.hop != hop ||
+            (fresh.startFrame - cached.startFrame) % hop != 0)
+            return false;
+
+        auto endOf = [hop](const DetectionCurve &curve) {
+            return curve.startFrame +
+                   static_cast<fluid::index>(curve.values.size()) * hop;
+        };
+        DetectionCurve joined;
+        joined.hop = hop;
+        joined.startFrame = std::min(fresh.startFrame, cached.startFrame);
+        const fluid::index end = std::max(endOf(fresh), endOf(cached));
+        for (fluid::index frame = joined.startFrame; frame < end;
+             frame += hop) {
+            const bool inFresh =
+                frame >= fresh.startFrame && frame < endOf(fresh);
+            const bool inCached =
+                frame >= cached.startFrame && frame < endOf(cached);
+            const bool preferFresh =
+                !inCached || (frame >= mFreshStart && frame < mFreshEnd);
+            joined.values.push_back(
+                inFresh && preferFresh
+                    ? fresh.values[(frame - fresh.startFrame) / hop]
+                : inCached ? cached.values[(frame - cached.startFrame) / hop]
+                           : 0.0f);
+        }
+        cached = std::move(joined);
+        return true;
+    }
+
+    // The slices of everything the cached curve covers, at this run's
+    // threshold and minimum length.
+    void PickCachedCurve() {
+        const DetectionCurve &curve = mCachedEntry.curve;
+        const std::vector<double> values(curve.values.begin(),
+                                         curve.values.end());
+        std::vector<fluid::index> slices;
+        std::vector<float> strengths;
+        PickCurveSlices(values, curve.startFrame, curve.hop,
+                        mCachedEntry.startFrame, 0, slices, strengths);
+
+        mCachedEntry.slices.clear();
+        mCachedEntry.strengths.clear();
+        for (size_t i = 0; i < slices.size(); ++i) {
+            if (slices[i] < mCachedEntry.endFrame) {
+                mCachedEntry.slices.push_back(slices[i]);
+                mCachedEntry.strengths.push_back(strengths[i]);
+            }
+        }
+    }
+
+    // The curve with the largest value of each span the slice output asks
+    // for.
+    DetectionCurve DecimateCurve(const DetectionCurve &curve) const {
+        const double rate = this->mSliceOutput.curveRate;
+        if (rate <= 0.0 || curve.hop <= 0 || mCurveSampleRate <= 0)
+            return {};
+
+        const fluid::index span = std::max<fluid::index>(
+            1, std::lround(mCurveSampleRate / (rate * curve.hop)));
+        DetectionCurve decimated;
+        decimated.startFrame = curve.startFrame;
+        decimated.hop = curve.hop * span;
+        for (size_t i = 0; i < curve.values.size(); ++i) {
+            if (i % span == 0) {
+                decimated.values.push_back(curve.values[i]);
+            } else {
+                decimated.values.back() =
+                    std::max(decimated.values.back(), curve.values[i]);
+            }
+        }
+        return decimated;
+    }
+
+    std::string mSourceKey;
+    SliceCache::Entry mCachedEntry;
+    // Slices inside [mFreshStart, mFreshEnd) come from this run's analysis;
+    // everything else is carried over from the cache.
+    fluid::index mFreshStart = 0;
+    fluid::index mFreshEnd = 0;
+    bool mRanAnalysis = true;
+    // Slices come from picking the cached curve, joined with this run's.
+    bool mUsesCachedCurve = false;
+    bool mResultsCollected = false;
+    // Per hop, as the detector produced it.
+    DetectionCurve mDetectionCurve;
+    int mCurveSampleRate = 0;
+    std::string mMarkerName;
+    int mMarkerColor = 0;
+};
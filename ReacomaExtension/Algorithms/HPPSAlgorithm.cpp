@@ -5,7 +5,7 @@
 HPSSAlgorithm::HPSSAlgorithm(ReacomaExtension *apiProvider)
     : AudioOutputAlgorithm<NRTThreadedHPSSClient>(apiProvider) {}
 
-HPSSAlgorithm::~HPSSAlgorithm() = default;
+HPSSAlgorithm::~HPSSAlgorithm() { Shutdown(); }
 
 void HPSSAlgorithm::RegisterParameters() {
     mBaseParamIdx = mApiProvider->NParams();
@@ -32,22 +32,12 @@ void HPSSAlgorithm::RegisterParameters() {
 
 bool HPSSAlgorithm::DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                               int frameCount, int sampleRate) {
-    auto harmFilterSizeParam =
-        mApiProvider->GetParam(mBaseParamIdx + HPSSAlgorithm::kHarmFilterSize)
-            ->Value();
-    auto percFilterSizeParam =
-        mApiProvider->GetParam(mBaseParamIdx + HPSSAlgorithm::kPercFilterSize)
-            ->Value();
-
-    auto windowSize =
-        mApiProvider->GetParam(mBaseParamIdx + HPSSAlgorithm::kWindowSize)
-            ->Value();
-    auto hopSize =
-        mApiProvider->GetParam(mBaseParamIdx + HPSSAlgorithm::kHopSize)
-            ->Value();
-    auto fftSize =
-        mApiProvider->GetParam(mBaseParamIdx + HPSSAlgorithm::kFFTSize)
-            ->Value();
+    auto harmFilterSizeParam = GetParamValue(HPSSAlgorithm::kHarmFilterSize);
+    auto percFilterSizeParam = GetParamValue(HPSSAlgorithm::kPercFilterSize);
+
+    auto windowSize = GetParamValue(HPSSAlgorithm::kWindowSize);
+    auto hopSize = GetParamValue(HPSSAlgorithm::kHopSize);
+    auto fftSize = GetParamValue(HPSSAlgorithm::kFFTSize);
 
     auto harmMemoryBuffer =
         std::make_shared<MemoryBufferAdaptor>(1, frameCount, sampleRate);
@@ -84,11 +74,7 @@ bool HPSSAlgorithm::DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
     mClient.enqueue(mParams);
     Result result = mClient.process();
 
-    if (!result.ok()) {
-        ShowConsoleMsg("NMF processing failed.\n");
-        return false;
-    }
-    return true;
+    return result.ok();
 }
 
 bool HPSSAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
@@ -101,6 +87,23 @@ bool HPSSAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
     return true;
 }
 
+void HPSSAlgorithm::ReleaseResults() {
+    mParams.template set<5>(BufferT::type(), nullptr);
+    mParams.template set<6>(BufferT::type(), nullptr);
+}
+
+BufferT::type HPSSAlgorithm::FindOutput(const std::string &name) {
+    if (name == "harmonic")
+        return mParams.template get<5>();
+    if (name == "percussive")
+        return mParams.template get<6>();
+    return nullptr;
+}
+
+std::vector<std::string> HPSSAlgorithm::GetAudioOutputNames() const {
+    return {"harmonic", "percussive"};
+}
+
 const char *HPSSAlgorithm::GetName() const {
     return "Harmonic Percussive Source Separation";
 }
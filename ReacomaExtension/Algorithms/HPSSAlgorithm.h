@@ -20,10 +20,13 @@ class HPSSAlgorithm
     const char *GetName() const override;
     void RegisterParameters() override;
     int GetNumAlgorithmParams() const override;
+    std::vector<std::string> GetAudioOutputNames() const override;
 
   protected:
     bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                    int frameCount, int sampleRate) override;
     bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
                        int sampleRate) override;
+    BufferT::type FindOutput(const std::string &name) override;
+    void ReleaseResults() override;
 };
@@ -1,6 +1,76 @@
 #include "IAlgorithm.h"
+#include "ReacomaExtension.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+std::string NormaliseParamName(const std::string &name) {
+    std::string normalised;
+    for (char c : name) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            normalised += static_cast<char>(
+                std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    return normalised;
+}
+} // namespace
 
 IAlgorithm::IAlgorithm(ReacomaExtension *apiProvider)
     : mApiProvider(apiProvider) {}
 
 IAlgorithm::~IAlgorithm() = default;
+
+std::string IAlgorithm::GetParamSignature() const {
+    std::string signature;
+    for (int i = 0; i < GetNumAlgorithmParams(); ++i) {
+        signature += std::to_string(GetParamValue(i));
+        signature += ';';
+    }
+    return signature;
+}
+
+void IAlgorithm::SnapshotParams() {
+    mParamValues.clear();
+    for (int i = 0; i < GetNumAlgorithmParams(); ++i) {
+        mParamValues.push_back(
+            mApiProvider->GetParam(GetGlobalParamIdx(i))->Value());
+    }
+}
+
+bool IAlgorithm::SetParamValue(const std::string &name, double value) {
+    if (mParamValues.empty()) {
+        SnapshotParams();
+    }
+
+    const int index = FindParam(name);
+    if (index < 0)
+        return false;
+
+    const IParam *param = mApiProvider->GetParam(GetGlobalParamIdx(index));
+    mParamValues[index] = std::clamp(value, param->GetMin(), param->GetMax());
+    return true;
+}
+
+int IAlgorithm::FindParam(const std::string &name) const {
+    const std::string wanted = NormaliseParamName(name);
+    for (int i = 0; i < GetNumAlgorithmParams(); ++i) {
+        const IParam *param = mApiProvider->GetParam(GetGlobalParamIdx(i));
+        if (NormaliseParamName(param->GetName()) == wanted)
+            return i;
+    }
+    return -1;
+}
+
+double IAlgorithm::GetParamValue(int algorithmParamEnum) const {
+    if (algorithmParamEnum < static_cast<int>(mParamValues.size())) {
+        return mParamValues[algorithmParamEnum];
+    }
+    return mApiProvider->GetParam(GetGlobalParamIdx(algorithmParamEnum))
+        ->Value();
+}
+
+SpectrogramCache &IAlgorithm::GetSpectrogramCache() const {
+    return mApiProvider->GetSpectrogramCache();
+}
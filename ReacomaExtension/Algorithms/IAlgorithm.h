@@ -1,21 +1,132 @@
 #pragma once
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+#include "CancellationToken.h"
+#include "DescriptorTable.h"
+#include "SliceIndex.h"
+
+#include <functional>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 class MediaItem;
 class ReacomaExtension;
+class SpectrogramCache;
+
+namespace fluid {
+namespace client {
+class BufferAdaptor;
+}
+} // namespace fluid
+
+// Audio handed from one pipeline stage to the next, covering the items'
+// shared source from startFrame onwards.
+struct StageAudio {
+    std::shared_ptr<const fluid::client::BufferAdaptor> buffer;
+    fluid::index startFrame = 0;
+    // Describes how the audio was derived from the source, so that caches
+    // never mix it up with the source itself.
+    std::string signature;
+};
+
+// Where slicers put their results. Sidecars are only written for items
+// that play a whole file, since sections have no stable frame positions.
+struct SliceOutput {
+    bool takeMarkers = true;
+    bool sidecar = false;
+    bool sidecarJson = false;
+    // Points per second of the detection curve kept in sidecars, or 0 to
+    // leave it out.
+    double curveRate = 0.0;
+    // Seconds of item time below which neighbouring slices are thinned out
+    // on top of the slicer's own minimum length.
+    double minGap = 0.0;
+};
 
 class IAlgorithm {
   public:
     IAlgorithm(ReacomaExtension *apiProvider);
     virtual ~IAlgorithm();
 
-    virtual bool StartProcessItemAsync(MediaItem *item) = 0;
+    // Items passed together share a source file; their ranges are ingested
+    // and analysed as one span and the results are split back per item.
+    virtual bool
+    StartProcessItemsAsync(const std::vector<MediaItem *> &items) = 0;
     virtual bool IsFinished() = 0;
-    virtual bool FinalizeProcess(MediaItem *item) = 0;
+    // Once IsFinished, whether the job ran to the end rather than failing
+    // or being cancelled.
+    virtual bool Succeeded() = 0;
+    virtual bool FinalizeProcess() = 0;
+
+    // Pipeline stages: start from audio produced by a previous stage rather
+    // than from the items' source, and hand named audio outputs onwards.
+    virtual bool StartProcessBufferAsync(const std::vector<MediaItem *> &items,
+                                         const StageAudio &audio) {
+        return false;
+    }
+    virtual StageAudio GetAudioOutput(const std::string &name) { return {}; }
+    virtual std::vector<std::string> GetAudioOutputNames() const { return {}; }
+
+    // Hosts without a project, such as the command-line tool, hand over
+    // audio directly. Nothing is written anywhere: once IsFinished, read the
+    // results back with GetSliceFrames or GetAudioOutput.
+    virtual bool StartProcessAudioAsync(
+        std::shared_ptr<const fluid::client::BufferAdaptor> audio,
+        int sampleRate) {
+        return false;
+    }
+    // Slice positions of the last run, in frames from the start of the audio
+    // it was given.
+    virtual std::vector<fluid::index> GetSliceFrames() { return {}; }
+    // Slicers that run their own detector also report the detection value
+    // at each slice and, when the slice output asks for one, the detection
+    // curve. Both are empty otherwise.
+    virtual std::vector<float> GetSliceStrengths() { return {}; }
+    virtual DetectionCurve GetDetectionCurve() { return {}; }
+    // Gates report (start, end) frame pairs instead of single slices.
+    virtual std::vector<std::pair<fluid::index, fluid::index>>
+    GetGateFrames() {
+        return {};
+    }
+
+    // Describers reduce their frame descriptors over the segments between
+    // consecutive boundaries, given in frames from the start of the audio
+    // of the last run.
+    virtual DescriptorTable
+    DescribeSlices(const std::vector<fluid::index> &boundaries) {
+        return {};
+    }
+
+    // Slicers tag their markers so that several can share a take. Only
+    // markers with the same name are replaced on the next run.
+    virtual void SetMarkerStyle(const std::string &name, int color) {}
+    void SetSliceOutput(const SliceOutput &output) { mSliceOutput = output; }
+
+    // Slicers hand their slice times, in seconds from the start of each
+    // item, to the sink instead of writing markers when one is set.
+    using SliceSink =
+        std::function<void(MediaItem *, const std::vector<double> &)>;
+    virtual void SetSliceSink(SliceSink sink) { mSliceSink = std::move(sink); }
+    // Whether a sink keeps every result out of the project. Items are not
+    // locked while such a run has one, as nothing is written to them.
+    virtual bool SupportsSliceSink() { return false; }
+    // Whether a batch may only run this as its single job, because its
+    // results replace something every job shares.
+    virtual bool RunsAlone() const { return false; }
+
+    // Intermediate pipeline stages keep their results in memory and never
+    // write to disk or to the project.
+    void SetPipelineStage(bool isPipelineStage) {
+        mIsPipelineStage = isPipelineStage;
+    }
 
     virtual double GetProgress() = 0;
     virtual void Cancel() = 0;
+    // Cancels the algorithm and waits for any work it still has running.
+    // Workers use members of the most-derived class, so that class calls
+    // this from its destructor, before any of them are destroyed.
+    virtual void Shutdown() {}
 
     virtual const char *GetName() const = 0;
     virtual void RegisterParameters() = 0;
@@ -24,13 +135,36 @@ class IAlgorithm {
     }
     virtual int GetNumAlgorithmParams() const = 0;
     int GetBaseParamIdx() const { return mBaseParamIdx; }
+    // Whether a parameter has any effect with the others as they are set.
+    // The UI disables those that have none.
+    virtual bool IsParamActive(int algorithmParamEnum) const { return true; }
     void SetBaseParamIdx(int idx) { mBaseParamIdx = idx; }
+    std::string GetParamSignature() const;
+
+    // Copies the current parameter values so that a job keeps running with
+    // the values it was started with, whatever happens to the UI meanwhile.
+    void SnapshotParams();
+    // Overrides a snapshotted value by parameter name, ignoring case and
+    // spaces. The value is clamped to the parameter's range.
+    bool SetParamValue(const std::string &name, double value);
+    // Index of the named parameter among this algorithm's own, or -1.
+    int FindParam(const std::string &name) const;
+    double GetParamValue(int algorithmParamEnum) const;
 
     virtual bool SupportsSegmentation() = 0;
     virtual bool SupportsRegions() = 0;
     virtual bool CreatesTakes() = 0;
 
   protected:
+    SpectrogramCache &GetSpectrogramCache() const;
+
     ReacomaExtension *mApiProvider;
     int mBaseParamIdx = 0;
+    bool mIsPipelineStage = false;
+    CancellationToken mCancelToken;
+    SliceSink mSliceSink;
+    SliceOutput mSliceOutput;
+
+  private:
+    std::vector<double> mParamValues;
 };
@@ -0,0 +1,90 @@
+#include "Ingest.h"
+#include "../VectorBufferAdaptor.h"
+
+#include <algorithm>
+#include <cmath>
+
+IngestPlan IngestPlan::ForItems(const std::vector<MediaItem *> &items) {
+    IngestPlan plan;
+
+    for (MediaItem *item : items) {
+        MediaItem_Take *take = item ? GetActiveTake(item) : nullptr;
+        if (!take)
+            continue;
+
+        PCM_source *takeSource = GetMediaItemTake_Source(take);
+        if (!takeSource)
+            continue;
+
+        if (!plan.source) {
+            plan.source = takeSource;
+            plan.sampleRate = GetMediaSourceSampleRate(takeSource);
+            plan.numChannels = GetMediaSourceNumChannels(takeSource);
+        }
+
+        const double itemLength = GetMediaItemInfo_Value(item, "D_LENGTH");
+        const double playrate = GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+        const double takeOffset =
+            GetMediaItemTakeInfo_Value(take, "D_STARTOFFS");
+        const double sourceDuration = takeSource->GetLength();
+
+        const double effectiveTakeDuration = itemLength * playrate;
+        const double actualDurationToProcess =
+            std::min(effectiveTakeDuration, sourceDuration - takeOffset);
+        const int frameCount =
+            static_cast<int>(plan.sampleRate * actualDurationToProcess);
+
+        if (frameCount <= 0)
+            continue;
+
+        const fluid::index startFrame =
+            std::llround(takeOffset * plan.sampleRate);
+        if (plan.spans.empty()) {
+            plan.startFrame = startFrame;
+            plan.endFrame = startFrame + frameCount;
+        } else {
+            plan.startFrame = std::min(plan.startFrame, startFrame);
+            plan.endFrame = std::max(plan.endFrame, startFrame + frameCount);
+        }
+        plan.spans.push_back({item, take, startFrame, frameCount});
+    }
+
+    return plan;
+}
+
+std::shared_ptr<const fluid::client::BufferAdaptor>
+IngestPlan::Read(PCM_source *reader, fluid::index fromFrame,
+                 fluid::index frameCount, const CancellationToken &token,
+                 JobProgress *progress) const {
+    constexpr fluid::index chunkFrames = 65536;
+
+    std::vector<float> allChannelsAsFloat(frameCount * numChannels);
+    std::vector<double> chunk(chunkFrames * numChannels);
+
+    for (fluid::index done = 0; done < frameCount; done += chunkFrames) {
+        if (token.IsCancelled())
+            return nullptr;
+
+        const fluid::index length = std::min(chunkFrames, frameCount - done);
+        PCM_source_transfer_t transfer{};
+        transfer.time_s = static_cast<double>(fromFrame + done) / sampleRate;
+        transfer.samplerate = static_cast<double>(sampleRate);
+        transfer.nch = numChannels;
+        transfer.length = static_cast<int>(length);
+        transfer.samples = chunk.data();
+        reader->GetSamples(&transfer);
+
+        // A source can return fewer frames than asked for, near its end or
+        // when it fails to decode; the rest of the buffer stays silent.
+        const fluid::index decoded = std::clamp<fluid::index>(
+            transfer.samples_out, 0, length);
+        std::copy(chunk.begin(), chunk.begin() + decoded * numChannels,
+                  allChannelsAsFloat.begin() + done * numChannels);
+        if (progress) {
+            progress->Report(static_cast<double>(done + length) / frameCount);
+        }
+    }
+
+    return std::make_shared<fluid::VectorBufferAdaptor>(
+        std::move(allChannelsAsFloat), numChannels, frameCount, sampleRate);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/clients/common/BufferAdaptor.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+#include "CancellationToken.h"
+#include "JobProgress.h"
+
+#include "wdltypes.h"
+#include "reaper_plugin_functions.h"
+
+#include <memory>
+#include <vector>
+
+// The range of a source covered by a group of items that share it, and where
+// each item starts within it. All positions are source frames.
+struct IngestPlan {
+    struct ItemSpan {
+        MediaItem *item;
+        MediaItem_Take *take;
+        fluid::index startFrame;
+        fluid::index frameCount;
+    };
+
+    PCM_source *source = nullptr;
+    int sampleRate = 0;
+    int numChannels = 0;
+    fluid::index startFrame = 0;
+    fluid::index endFrame = 0;
+    std::vector<ItemSpan> spans;
+
+    static IngestPlan ForItems(const std::vector<MediaItem *> &items);
+
+    // Decodes a range of the source into a buffer that any number of
+    // algorithms can read at once. Reads in chunks so that it can stop early;
+    // returns null if cancelled. Safe off the main thread when reader is a
+    // duplicate of the source.
+    std::shared_ptr<const fluid::client::BufferAdaptor>
+    Read(PCM_source *reader, fluid::index fromFrame, fluid::index frameCount,
+         const CancellationToken &token,
+         JobProgress *progress = nullptr) const;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+// Progress of one job through its phases, weighted by how long each phase
+// usually takes. Whichever thread is running the current phase reports its
+// fraction; the UI thread reads the total without taking a lock.
+class JobProgress {
+  public:
+    enum Phase { kIngest = 0, kAnalyse, kWrite, kFinalize, kNumPhases };
+
+    // Phases that a job does not have get a weight of zero.
+    void SetWeights(double ingest, double analyse, double write,
+                    double finalize) {
+        const double total = ingest + analyse + write + finalize;
+        mWeights[kIngest] = ingest / total;
+        mWeights[kAnalyse] = analyse / total;
+        mWeights[kWrite] = write / total;
+        mWeights[kFinalize] = finalize / total;
+    }
+
+    void BeginPhase(Phase phase) {
+        mPhase.store(phase, std::memory_order_relaxed);
+        Report(0.0);
+    }
+
+    void Report(double fraction) {
+        const int phase = mPhase.load(std::memory_order_relaxed);
+        double value = 0.0;
+        for (int i = 0; i < phase; ++i) {
+            value += mWeights[i];
+        }
+        value += mWeights[phase] * std::clamp(fraction, 0.0, 1.0);
+        mValue.store(value, std::memory_order_relaxed);
+    }
+
+    void Complete() { mValue.store(1.0, std::memory_order_relaxed); }
+
+    double Get() const { return mValue.load(std::memory_order_relaxed); }
+
+  private:
+    double mWeights[kNumPhases] = {0.15, 0.65, 0.15, 0.05};
+    std::atomic<int> mPhase{kIngest};
+    std::atomic<double> mValue{0.0};
+};
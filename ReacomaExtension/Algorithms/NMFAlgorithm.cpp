@@ -5,7 +5,7 @@
 NMFAlgorithm::NMFAlgorithm(ReacomaExtension *apiProvider)
     : AudioOutputAlgorithm<NRTThreadedNMFClient>(apiProvider) {}
 
-NMFAlgorithm::~NMFAlgorithm() = default;
+NMFAlgorithm::~NMFAlgorithm() { Shutdown(); }
 
 void NMFAlgorithm::RegisterParameters() {
     mBaseParamIdx = mApiProvider->NParams();
@@ -25,22 +25,50 @@ void NMFAlgorithm::RegisterParameters() {
 
     mApiProvider->GetParam(mBaseParamIdx + NMFAlgorithm::kFFTSize)
         ->InitInt("FFT Size", 1024, 2, 65536);
+
+    IParam *basesParam = mApiProvider->GetParam(mBaseParamIdx + kBases);
+    basesParam->InitEnum("Bases", kLearnBases, kNumBasesModes);
+    basesParam->SetDisplayText(kLearnBases, "Learn");
+    basesParam->SetDisplayText(kStoreBases, "Store");
+    basesParam->SetDisplayText(kFixedBases, "Fixed");
+
+    // Used when filtering playback with the stored bases.
+    mApiProvider->GetParam(mBaseParamIdx + kLiveComponent)
+        ->InitInt("Live Component", 1, 1, 10);
+    mApiProvider->GetParam(mBaseParamIdx + kLiveIterations)
+        ->InitInt("Live Iterations", 10, 1, 100);
+
+    // Only activations are estimated against fixed bases, which settles in
+    // far fewer iterations than learning both.
+    mApiProvider->GetParam(mBaseParamIdx + kFixedIterations)
+        ->InitInt("Fixed Iterations", 20, 1, 1000);
 }
 
 bool NMFAlgorithm::DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                              int frameCount, int sampleRate) {
-    auto componentsParam =
-        mApiProvider->GetParam(mBaseParamIdx + kComponents)->Value();
-    auto iterationsParam =
-        mApiProvider->GetParam(mBaseParamIdx + kIterations)->Value();
-
-    auto windowSize =
-        mApiProvider->GetParam(mBaseParamIdx + NMFAlgorithm::kWindowSize)
-            ->Value();
-    auto hopSize =
-        mApiProvider->GetParam(mBaseParamIdx + NMFAlgorithm::kHopSize)->Value();
-    auto fftSize =
-        mApiProvider->GetParam(mBaseParamIdx + NMFAlgorithm::kFFTSize)->Value();
+    auto componentsParam = GetParamValue(kComponents);
+    auto iterationsParam = GetParamValue(kIterations);
+
+    auto windowSize = GetParamValue(NMFAlgorithm::kWindowSize);
+    auto hopSize = GetParamValue(NMFAlgorithm::kHopSize);
+    auto fftSize = GetParamValue(NMFAlgorithm::kFFTSize);
+
+    const auto basesMode = static_cast<int>(GetParamValue(kBases));
+    mBasesBuffer = nullptr;
+    if (basesMode == kFixedBases) {
+        // Fixed bases only fit the analysis they were learned with.
+        const NMFBases &bases = mApiProvider->GetNMFBases();
+        if (bases.IsEmpty() || bases.sampleRate != sampleRate)
+            return false;
+        componentsParam = static_cast<double>(bases.numComponents);
+        windowSize = static_cast<double>(bases.windowSize);
+        hopSize = static_cast<double>(bases.hopSize);
+        fftSize = static_cast<double>(bases.fftSize);
+        iterationsParam = GetParamValue(kFixedIterations);
+        mBasesBuffer = MakeFixedBases(bases, numChannels, sampleRate);
+    } else if (basesMode == kStoreBases) {
+        mBasesBuffer = std::make_shared<MemoryBufferAdaptor>(1, 1, sampleRate);
+    }
 
     auto resynthMemoryBuffer = std::make_shared<MemoryBufferAdaptor>(
         numChannels * componentsParam, frameCount, sampleRate);
@@ -54,6 +82,11 @@ bool NMFAlgorithm::DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
     mParams.template set<4>(LongT::type(-1), nullptr);
     mParams.template set<5>(std::move(resynthOutputBuffer), nullptr);
     mParams.template set<6>(LongT::type(1), nullptr);
+    if (mBasesBuffer) {
+        mParams.template set<7>(BufferT::type(mBasesBuffer), nullptr);
+        mParams.template set<8>(
+            LongT::type(basesMode == kFixedBases ? 2 : 0), nullptr);
+    }
     mParams.template set<11>(componentsParam, nullptr);
     mParams.template set<12>(iterationsParam, nullptr);
     mParams.template set<13>(
@@ -75,6 +108,77 @@ bool NMFAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
     return true;
 }
 
+bool NMFAlgorithm::FinishResults(int sampleRate) {
+    if (!mBasesBuffer || GetParamValue(kBases) != kStoreBases)
+        return true;
+
+    BufferAdaptor::ReadAccess reader(mBasesBuffer.get());
+    const auto numComponents =
+        static_cast<fluid::index>(GetParamValue(kComponents));
+    const fluid::index numChannels = reader.numChans() / numComponents;
+    const fluid::index numBins = reader.numFrames();
+    if (!reader.exists() || numChannels < 1 || numBins < 1)
+        return true;
+
+    // Channels hold every component of the first input channel, then every
+    // component of the next.
+    NMFBases bases;
+    bases.numComponents = numComponents;
+    bases.numBins = numBins;
+    bases.windowSize = static_cast<fluid::index>(GetParamValue(kWindowSize));
+    bases.hopSize = static_cast<fluid::index>(GetParamValue(kHopSize));
+    bases.fftSize = static_cast<fluid::index>(GetParamValue(kFFTSize));
+    bases.sampleRate = sampleRate;
+    bases.generation = mApiProvider->GetNMFBases().generation + 1;
+    bases.values.assign(numComponents * numBins, 0.f);
+    for (fluid::index c = 0; c < numChannels; ++c) {
+        for (fluid::index k = 0; k < numComponents; ++k) {
+            auto basis = reader.samps(c * numComponents + k);
+            for (fluid::index bin = 0; bin < numBins; ++bin) {
+                bases.values[k * numBins + bin] += basis(bin) / numChannels;
+            }
+        }
+    }
+    mApiProvider->GetNMFBases() = std::move(bases);
+    return true;
+}
+
+bool NMFAlgorithm::RunsAlone() const {
+    return static_cast<int>(GetParamValue(kBases)) == kStoreBases;
+}
+
+BufferT::type NMFAlgorithm::MakeFixedBases(const NMFBases &bases,
+                                           int numChannels,
+                                           int sampleRate) const {
+    auto buffer = std::make_shared<MemoryBufferAdaptor>(
+        numChannels * bases.numComponents, bases.numBins, sampleRate);
+    BufferAdaptor::Access writer(buffer.get());
+    for (int c = 0; c < numChannels; ++c) {
+        for (fluid::index k = 0; k < bases.numComponents; ++k) {
+            auto basis = writer.samps(c * bases.numComponents + k);
+            for (fluid::index bin = 0; bin < bases.numBins; ++bin) {
+                basis(bin) = bases.values[k * bases.numBins + bin];
+            }
+        }
+    }
+    return buffer;
+}
+
+void NMFAlgorithm::ReleaseResults() {
+    mParams.template set<5>(BufferT::type(), nullptr);
+    mBasesBuffer = nullptr;
+}
+
+BufferT::type NMFAlgorithm::FindOutput(const std::string &name) {
+    if (name == "nmf")
+        return mParams.template get<5>();
+    return nullptr;
+}
+
+std::vector<std::string> NMFAlgorithm::GetAudioOutputNames() const {
+    return {"nmf"};
+}
+
 const char *NMFAlgorithm::GetName() const {
     return "Non-negative Matrix Factorisation";
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "../../dependencies/flucoma-core/include/flucoma/clients/nrt/NMFClient.hpp"
 #include "FlucomaAlgorithmBase.h"
+#include "NMFBases.h"
 
 class NMFAlgorithm
     : public AudioOutputAlgorithm<fluid::client::NRTThreadedNMFClient> {
@@ -11,19 +12,45 @@ class NMFAlgorithm
         kWindowSize,
         kHopSize,
         kFFTSize,
+        kBases,
+        kLiveComponent,
+        kLiveIterations,
+        kFixedIterations,
         kNumParams
     };
 
+    // kStoreBases only runs on items sharing one source, as a batch of
+    // several jobs would leave the bases of whichever finished last; such a
+    // batch fails instead. kFixedBases fails on items at another sample rate
+    // than the stored bases.
+    enum EBasesModes {
+        kLearnBases = 0,
+        kStoreBases,
+        kFixedBases,
+        kNumBasesModes
+    };
+
     NMFAlgorithm(ReacomaExtension *apiProvider);
     ~NMFAlgorithm() override;
 
     const char *GetName() const override;
     void RegisterParameters() override;
     int GetNumAlgorithmParams() const override;
+    std::vector<std::string> GetAudioOutputNames() const override;
 
   protected:
     bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                    int frameCount, int sampleRate) override;
     bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
                        int sampleRate) override;
+    bool FinishResults(int sampleRate) override;
+    bool RunsAlone() const override;
+    BufferT::type FindOutput(const std::string &name) override;
+    void ReleaseResults() override;
+
+  private:
+    BufferT::type MakeFixedBases(const NMFBases &bases, int numChannels,
+                                 int sampleRate) const;
+
+    BufferT::type mBasesBuffer;
 };
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+
+#include <vector>
+
+// Bases kept from a reference item, so that later jobs can hold them fixed
+// and only work out activations. Each component then means the same thing
+// on every item. Averaged over the reference's channels so that items with
+// any number of channels can use them.
+struct NMFBases {
+    fluid::index numComponents = 0;
+    fluid::index numBins = 0;
+    fluid::index windowSize = 0;
+    fluid::index hopSize = 0;
+    fluid::index fftSize = 0;
+    // Bins only stand for the same frequencies at the rate the reference was
+    // analysed at.
+    int sampleRate = 0;
+    // Counts the bases stored so far, so that users can tell new ones apart.
+    int generation = 0;
+    // numComponents bases of numBins magnitudes, one after another.
+    std::vector<float> values;
+
+    bool IsEmpty() const { return values.empty(); }
+};
@@ -0,0 +1,135 @@
+#include "NMFFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double kEpsilon = 1e-10;
+// Activations never reach zero, where multiplicative updates would hold
+// them for good.
+constexpr double kMinActivation = 1e-9;
+} // namespace
+
+NMFFilter::NMFFilter(const NMFBases &bases)
+    : mSampleRate(bases.sampleRate), mNumBins(bases.numBins),
+      mNumComponents(bases.numComponents),
+      mFFTSize(2 * (bases.numBins - 1)),
+      mWindowSize(std::clamp<fluid::index>(bases.windowSize, 1, mFFTSize)),
+      mHopSize(std::clamp<fluid::index>(bases.hopSize, 1, mWindowSize)),
+      mBases(bases.values.begin(), bases.values.end()),
+      mBasisSums(mNumComponents, 0.0),
+      mSTFT(mWindowSize, mFFTSize, mHopSize),
+      mISTFT(mWindowSize, mFFTSize, mHopSize), mFrame(mWindowSize),
+      mResynthesised(mWindowSize), mSpectrum(mNumBins),
+      mMagnitudes(mNumBins), mEstimate(mNumBins),
+      mNumerators(mNumComponents), mNormalisation(mHopSize, 0.0) {
+    for (fluid::index k = 0; k < mNumComponents; ++k) {
+        for (fluid::index bin = 0; bin < mNumBins; ++bin) {
+            mBasisSums[k] += mBases[k * mNumBins + bin];
+        }
+    }
+
+    for (Channel &channel : mChannels) {
+        channel.input.assign(mWindowSize, 0.0);
+        channel.output.assign(mWindowSize, 0.0);
+        channel.activations.assign(mNumComponents, 1.0);
+    }
+
+    // The gain of an unmasked frame at each position, whatever windows and
+    // scaling the transforms apply, summed over the frames that overlap.
+    for (fluid::index i = 0; i < mWindowSize; ++i) {
+        mFrame(i) = 1.0;
+    }
+    mSTFT.processFrame(mFrame, mSpectrum);
+    mISTFT.processFrame(mSpectrum, mResynthesised);
+    for (fluid::index i = 0; i < mWindowSize; ++i) {
+        mNormalisation[i % mHopSize] += mResynthesised(i);
+    }
+    for (double &gain : mNormalisation) {
+        gain = std::abs(gain) > kEpsilon ? 1.0 / gain : 0.0;
+    }
+}
+
+NMFFilter::~NMFFilter() = default;
+
+void NMFFilter::Process(double *const *channels, int numChannels,
+                        int numFrames, int component, int iterations) {
+    numChannels = std::min(numChannels, kMaxChannels);
+    const fluid::index kept =
+        std::clamp<fluid::index>(component, 0, mNumComponents - 1);
+    const fluid::index numIterations = std::max(iterations, 1);
+    const fluid::index newest = mWindowSize - mHopSize;
+
+    for (int i = 0; i < numFrames; ++i) {
+        for (int c = 0; c < numChannels; ++c) {
+            Channel &channel = mChannels[c];
+            channel.input[newest + mHopPosition] = channels[c][i];
+            channels[c][i] =
+                channel.output[mHopPosition] * mNormalisation[mHopPosition];
+        }
+        if (++mHopPosition < mHopSize)
+            continue;
+
+        mHopPosition = 0;
+        for (int c = 0; c < numChannels; ++c) {
+            ProcessFrame(mChannels[c], kept, numIterations);
+        }
+    }
+}
+
+void NMFFilter::ProcessFrame(Channel &channel, fluid::index component,
+                             fluid::index iterations) {
+    for (fluid::index i = 0; i < mWindowSize; ++i) {
+        mFrame(i) = channel.input[i];
+    }
+    mSTFT.processFrame(mFrame, mSpectrum);
+    for (fluid::index bin = 0; bin < mNumBins; ++bin) {
+        mMagnitudes[bin] = std::abs(mSpectrum(bin));
+    }
+
+    double *activations = channel.activations.data();
+    auto estimate = [&]() {
+        std::fill(mEstimate.begin(), mEstimate.end(), kEpsilon);
+        for (fluid::index k = 0; k < mNumComponents; ++k) {
+            const double *basis = mBases.data() + k * mNumBins;
+            for (fluid::index bin = 0; bin < mNumBins; ++bin) {
+                mEstimate[bin] += basis[bin] * activations[k];
+            }
+        }
+    };
+
+    // Multiplicative updates for the KL divergence, with the bases held.
+    for (fluid::index iteration = 0; iteration < iterations; ++iteration) {
+        estimate();
+        for (fluid::index k = 0; k < mNumComponents; ++k) {
+            const double *basis = mBases.data() + k * mNumBins;
+            double numerator = 0.0;
+            for (fluid::index bin = 0; bin < mNumBins; ++bin) {
+                numerator += basis[bin] * mMagnitudes[bin] / mEstimate[bin];
+            }
+            mNumerators[k] = numerator;
+        }
+        for (fluid::index k = 0; k < mNumComponents; ++k) {
+            activations[k] = std::max(activations[k] * mNumerators[k] /
+                                          (mBasisSums[k] + kEpsilon),
+                                      kMinActivation);
+        }
+    }
+    estimate();
+
+    const double *basis = mBases.data() + component * mNumBins;
+    for (fluid::index bin = 0; bin < mNumBins; ++bin) {
+        mSpectrum(bin) *=
+            basis[bin] * activations[component] / mEstimate[bin];
+    }
+    mISTFT.processFrame(mSpectrum, mResynthesised);
+
+    std::copy(channel.output.begin() + mHopSize, channel.output.end(),
+              channel.output.begin());
+    std::fill(channel.output.end() - mHopSize, channel.output.end(), 0.0);
+    for (fluid::index i = 0; i < mWindowSize; ++i) {
+        channel.output[i] += mResynthesised(i);
+    }
+    std::copy(channel.input.begin() + mHopSize, channel.input.end(),
+              channel.input.begin());
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/STFT.hpp"
+#include "NMFBases.h"
+
+#include <complex>
+#include <vector>
+
+// Separates one NMF component of a signal as it plays. The magnitudes of
+// each frame are explained by fixed bases through multiplicative updates of
+// the activations alone, started from the previous frame's, and the
+// component's share of that estimate masks the spectrum. Everything is
+// allocated on construction, so Process can run on the audio thread.
+class NMFFilter {
+  public:
+    static constexpr int kMaxChannels = 2;
+
+    explicit NMFFilter(const NMFBases &bases);
+    ~NMFFilter();
+
+    // Filters each channel in place; channels past kMaxChannels are left
+    // alone. The output is delayed by GetLatency() frames.
+    void Process(double *const *channels, int numChannels, int numFrames,
+                 int component, int iterations);
+    int GetLatency() const { return static_cast<int>(mWindowSize); }
+    int GetSampleRate() const { return mSampleRate; }
+
+  private:
+    struct Channel {
+        // The last window of input, and the overlap-added output of the
+        // frames so far.
+        std::vector<double> input;
+        std::vector<double> output;
+        std::vector<double> activations;
+    };
+
+    void ProcessFrame(Channel &channel, fluid::index component,
+                      fluid::index iterations);
+
+    int mSampleRate;
+    fluid::index mNumBins;
+    fluid::index mNumComponents;
+    fluid::index mFFTSize;
+    fluid::index mWindowSize;
+    fluid::index mHopSize;
+    // Bases as numComponents runs of numBins, and the sum of each.
+    std::vector<double> mBases;
+    std::vector<double> mBasisSums;
+
+    fluid::algorithm::STFT mSTFT;
+    fluid::algorithm::ISTFT mISTFT;
+    fluid::RealVector mFrame;
+    fluid::RealVector mResynthesised;
+    fluid::FluidTensor<std::complex<double>, 1> mSpectrum;
+    std::vector<double> mMagnitudes;
+    std::vector<double> mEstimate;
+    std::vector<double> mNumerators;
+    // Reciprocal of the summed window gain at each position within a hop,
+    // which makes the overlap-add exact whatever the hop.
+    std::vector<double> mNormalisation;
+
+    Channel mChannels[kMaxChannels];
+    fluid::index mHopPosition = 0;
+};
@@ -1,11 +1,12 @@
 #include "NoveltySliceAlgorithm.h"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/NoveltyFeature.hpp"
 #include "IPlugParameter.h"
 #include "ReacomaExtension.h"
 
 NoveltySliceAlgorithm::NoveltySliceAlgorithm(ReacomaExtension *apiProvider)
-    : FlucomaAlgorithm<NRTThreadingNoveltySliceClient>(apiProvider) {}
+    : SlicerAlgorithm<NRTThreadingNoveltySliceClient>(apiProvider) {}
 
-NoveltySliceAlgorithm::~NoveltySliceAlgorithm() = default;
+NoveltySliceAlgorithm::~NoveltySliceAlgorithm() { Shutdown(); }
 
 void NoveltySliceAlgorithm::RegisterParameters() {
     mBaseParamIdx = mApiProvider->NParams();
@@ -39,12 +40,19 @@ void NoveltySliceAlgorithm::RegisterParameters() {
     IParam *algoParam = mApiProvider->GetParam(
         mBaseParamIdx + NoveltySliceAlgorithm::kAlgorithm);
     algoParam->InitEnum("Algorithm", NoveltySliceAlgorithm::kSpectrum,
-                        NoveltySliceAlgorithm::kNumAlgorithmOptions - 1);
+                        NoveltySliceAlgorithm::kNumAlgorithmOptions);
     algoParam->SetDisplayText(NoveltySliceAlgorithm::kSpectrum, "Spectrum");
     algoParam->SetDisplayText(NoveltySliceAlgorithm::kMFCC, "MFCC");
     algoParam->SetDisplayText(NoveltySliceAlgorithm::kChroma, "Chroma");
     algoParam->SetDisplayText(NoveltySliceAlgorithm::kPitch, "Pitch");
     algoParam->SetDisplayText(NoveltySliceAlgorithm::kLoudness, "Loudness");
+
+    mApiProvider->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kTargetSlices)
+        ->InitInt("Target Slices", 0, 0, 10000);
+
+    mApiProvider
+        ->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kTargetDensity)
+        ->InitDouble("Target Density", 0.0, 0.0, 50.0, 0.1);
 }
 
 bool NoveltySliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
@@ -55,43 +63,43 @@ bool NoveltySliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
         std::make_shared<MemoryBufferAdaptor>(1, estimatedSlices, sampleRate);
     auto slicesOutputBuffer = fluid::client::BufferT::type(outBuffer);
 
-    auto threshold =
-        mApiProvider
-            ->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kThreshold)
-            ->Value();
-
-    auto kernelsize =
-        mApiProvider
-            ->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kKernelSize)
-            ->Value();
-    auto filtersize =
-        mApiProvider
-            ->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kFilterSize)
-            ->Value();
-    auto minslicelength =
-        mApiProvider
-            ->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kMinSliceLength)
-            ->Value();
-    auto windowSize =
-        mApiProvider
-            ->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kWindowSize)
-            ->Value();
-    auto hopSize =
-        mApiProvider->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kHopSize)
-            ->Value();
-    auto fftSize =
-        mApiProvider->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kFFTSize)
-            ->Value();
-    auto algorithm =
-        mApiProvider
-            ->GetParam(mBaseParamIdx + NoveltySliceAlgorithm::kAlgorithm)
-            ->Value();
+    auto threshold = GetParamValue(NoveltySliceAlgorithm::kThreshold);
+
+    auto kernelsize = GetParamValue(NoveltySliceAlgorithm::kKernelSize);
+    auto filtersize = GetParamValue(NoveltySliceAlgorithm::kFilterSize);
+    auto minslicelength = GetParamValue(NoveltySliceAlgorithm::kMinSliceLength);
+    auto windowSize = GetParamValue(NoveltySliceAlgorithm::kWindowSize);
+    auto hopSize = GetParamValue(NoveltySliceAlgorithm::kHopSize);
+    auto fftSize = GetParamValue(NoveltySliceAlgorithm::kFFTSize);
+    auto algorithm = GetParamValue(NoveltySliceAlgorithm::kAlgorithm);
 
     if (static_cast<int>(kernelsize) % 2 == 0)
         kernelsize += 1;
     if (static_cast<int>(filtersize) % 2 == 0)
         filtersize += 1;
 
+    if (static_cast<int>(algorithm) == kSpectrum) {
+        mParams.template set<5>(std::move(slicesOutputBuffer), nullptr);
+        auto key = MakeSpectrogramKey(
+            frameCount, static_cast<fluid::index>(windowSize),
+            static_cast<fluid::index>(hopSize),
+            Spectrogram::EffectiveFFTSize(static_cast<fluid::index>(windowSize),
+                                          static_cast<fluid::index>(fftSize)),
+            true);
+        RunTask([this, key, sourceBuffer, outBuffer, sampleRate,
+                 kernel = static_cast<fluid::index>(kernelsize),
+                 filter = static_cast<fluid::index>(filtersize)]() {
+            auto spectrogram = GetSpectrogram(key, sourceBuffer.get());
+            if (!spectrogram)
+                return false;
+            const STFTFraming framing{key.windowSize, key.hopSize,
+                                      key.fftSize};
+            return DetectSpectralSlices(*spectrogram, framing, outBuffer.get(),
+                                        sampleRate, kernel, filter);
+        });
+        return true;
+    }
+
     mParams.template set<0>(std::move(sourceBuffer), nullptr);
     mParams.template set<1>(LongT::type(0), nullptr);
     mParams.template set<2>(LongT::type(-1), nullptr);
@@ -116,30 +124,120 @@ bool NoveltySliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
     return result.ok();
 }
 
-bool NoveltySliceAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
-                                          int numChannels, int sampleRate) {
-    auto processedSlicesBuffer = mParams.template get<5>();
-    BufferAdaptor::ReadAccess reader(processedSlicesBuffer.get());
-
-    if (!reader.exists() || !reader.valid())
-        return false;
-
-    int markerCount = GetNumTakeMarkers(take);
-    for (int i = markerCount - 1; i >= 0; i--) {
-        DeleteTakeMarker(take, i);
+// Runs the same novelty detector as the client over the shared magnitude
+// spectrogram of the summed channels, which is what the client analyses.
+// The whole curve is kept so that peaks can be picked here, as often as a
+// slice target or a change of threshold needs, rather than once by
+// NoveltySegmentation.
+bool NoveltySliceAlgorithm::DetectSpectralSlices(
+    const Spectrogram &spectrogram, const STFTFraming &framing,
+    BufferAdaptor *output, int sampleRate, fluid::index kernelSize,
+    fluid::index filterSize) {
+    const fluid::index numFrames = spectrogram.NumFrames();
+    const fluid::index numBins = spectrogram.NumBins();
+
+    fluid::algorithm::NoveltyFeature novelty(kernelSize, numBins, filterSize);
+    novelty.init(kernelSize, filterSize, numBins);
+
+    // The novelty curve peaks half a kernel plus half a filter after the
+    // change that caused it, and a peak is only known one frame later. The
+    // frames after the last one are silence, as the client pads the end of
+    // the audio by its latency.
+    const fluid::index delay = (kernelSize + 1) / 2 + (filterSize + 1) / 2;
+
+    RealVector magnitudes(numBins);
+    std::vector<double> curve;
+    curve.reserve(numFrames + delay);
+    for (fluid::index frame = 0; frame < numFrames + delay; ++frame) {
+        if (mCancelToken.IsCancelled())
+            return false;
+
+        for (fluid::index bin = 0; bin < numBins; ++bin) {
+            magnitudes(bin) =
+                frame < numFrames ? spectrogram.Channel(0)(frame, bin) : 0.0;
+        }
+        curve.push_back(novelty.processFrame(magnitudes));
+        mJobProgress.Report(static_cast<double>(frame) / (numFrames + delay));
     }
 
-    double itemLength = GetMediaItemInfo_Value(item, "D_LENGTH");
-    auto view = reader.samps(0);
-    for (fluid::index i = 0; i < view.size(); i++) {
-        if (view(i) > 0) {
-            double markerTimeInSeconds =
-                static_cast<double>(view(i)) / sampleRate;
-            if (markerTimeInSeconds < itemLength) {
-                SetTakeMarker(take, -1, "", &markerTimeInSeconds, nullptr);
-            }
+    // Values before the one a peak at the first frame shows up as can
+    // never be slices, so the curve starts there.
+    curve.erase(curve.begin(),
+                curve.begin() + std::max<fluid::index>(delay - 1, 0));
+    WriteCurveSlices(output, curve, framing.FrameCentre(0), framing.hopSize,
+                     sampleRate);
+    return true;
+}
+
+// A peak is a value above its neighbours and the threshold; like
+// NoveltySegmentation, a peak starts a debounce of minimum slice length
+// frames. The curve has been shifted so that a peak's index is the frame
+// whose centre the change happened at.
+void NoveltySliceAlgorithm::PickPeaks(const std::vector<double> &curve,
+                                      double threshold,
+                                      std::vector<fluid::index> &peaks,
+                                      std::vector<float> &strengths) const {
+    peaks.clear();
+    strengths.clear();
+    const auto minSliceLength =
+        static_cast<fluid::index>(GetParamValue(kMinSliceLength));
+    fluid::index debounce = 0;
+    const auto numFrames = static_cast<fluid::index>(curve.size());
+    for (fluid::index frame = 0; frame < numFrames; ++frame) {
+        const double beforePeak = frame >= 2 ? curve[frame - 2] : 0;
+        const double peak = frame >= 1 ? curve[frame - 1] : 0;
+        if (peak > beforePeak && peak > curve[frame] && peak > threshold &&
+            debounce == 0) {
+            debounce = minSliceLength;
+            peaks.push_back(frame - 1);
+            strengths.push_back(static_cast<float>(peak));
+        } else if (debounce > 0) {
+            --debounce;
         }
     }
+}
+
+double NoveltySliceAlgorithm::GetThreshold() const {
+    return GetParamValue(kThreshold);
+}
+
+// Only the spectrum is analysed here; the other features run the client,
+// which leaves no curve to keep.
+std::string NoveltySliceAlgorithm::GetCurveSignature() const {
+    if (static_cast<int>(GetParamValue(kAlgorithm)) != kSpectrum)
+        return {};
+    return GetSignatureOf({kKernelSize, kFilterSize, kWindowSize, kHopSize,
+                           kFFTSize, kAlgorithm});
+}
+
+fluid::index NoveltySliceAlgorithm::GetContextFrames() const {
+    auto param = [this](int idx) {
+        return static_cast<fluid::index>(GetParamValue(idx));
+    };
+    fluid::index hops =
+        param(kKernelSize) + param(kFilterSize) + param(kMinSliceLength);
+    return hops * param(kHopSize) +
+           std::max(param(kWindowSize), param(kFFTSize));
+}
+
+// Only the spectrum leaves a curve to search a threshold on.
+bool NoveltySliceAlgorithm::UsesSliceTarget() const {
+    return static_cast<int>(GetParamValue(kAlgorithm)) == kSpectrum &&
+           (GetParamValue(kTargetSlices) > 0 ||
+            GetParamValue(kTargetDensity) > 0);
+}
+
+fluid::index NoveltySliceAlgorithm::TargetSlicesFor(fluid::index frameCount,
+                                                    int sampleRate) const {
+    return TargetSliceCount(GetParamValue(kTargetSlices),
+                            GetParamValue(kTargetDensity), frameCount,
+                            sampleRate);
+}
+
+bool NoveltySliceAlgorithm::IsParamActive(int algorithmParamEnum) const {
+    if (algorithmParamEnum == kTargetSlices ||
+        algorithmParamEnum == kTargetDensity)
+        return static_cast<int>(GetParamValue(kAlgorithm)) == kSpectrum;
     return true;
 }
 
@@ -3,7 +3,7 @@
 #include "FlucomaAlgorithmBase.h"
 
 class NoveltySliceAlgorithm
-    : public FlucomaAlgorithm<fluid::client::NRTThreadingNoveltySliceClient> {
+    : public SlicerAlgorithm<fluid::client::NRTThreadingNoveltySliceClient> {
   public:
     enum Params {
         kThreshold = 0,
@@ -14,6 +14,8 @@ class NoveltySliceAlgorithm
         kHopSize,
         kFFTSize,
         kAlgorithm,
+        kTargetSlices,
+        kTargetDensity,
         kNumParams
     };
 
@@ -32,10 +34,24 @@ class NoveltySliceAlgorithm
     const char *GetName() const override;
     void RegisterParameters() override;
     int GetNumAlgorithmParams() const override;
+    bool IsParamActive(int algorithmParamEnum) const override;
 
   protected:
     bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                    int frameCount, int sampleRate) override;
-    bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
-                       int sampleRate) override;
+    fluid::index GetContextFrames() const override;
+    bool UsesSliceTarget() const override;
+    fluid::index TargetSlicesFor(fluid::index frameCount,
+                                 int sampleRate) const override;
+    std::string GetCurveSignature() const override;
+    void PickPeaks(const std::vector<double> &curve, double threshold,
+                   std::vector<fluid::index> &peaks,
+                   std::vector<float> &strengths) const override;
+    double GetThreshold() const override;
+
+  private:
+    bool DetectSpectralSlices(const Spectrogram &spectrogram,
+                              const STFTFraming &framing, BufferAdaptor *output,
+                              int sampleRate, fluid::index kernelSize,
+                              fluid::index filterSize);
 };
@@ -1,11 +1,12 @@
 #include "OnsetSliceAlgorithm.h"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/OnsetDetectionFunctions.hpp"
 #include "IPlugParameter.h"
 #include "ReacomaExtension.h"
 
 OnsetSliceAlgorithm::OnsetSliceAlgorithm(ReacomaExtension *apiProvider)
-    : FlucomaAlgorithm<NRTThreadingOnsetSliceClient>(apiProvider) {}
+    : SlicerAlgorithm<NRTThreadingOnsetSliceClient>(apiProvider) {}
 
-OnsetSliceAlgorithm::~OnsetSliceAlgorithm() = default;
+OnsetSliceAlgorithm::~OnsetSliceAlgorithm() { Shutdown(); }
 
 void OnsetSliceAlgorithm::RegisterParameters() {
     mBaseParamIdx = mApiProvider->NParams();
@@ -27,6 +28,10 @@ void OnsetSliceAlgorithm::RegisterParameters() {
         ->InitInt("Hop Size", 512, 2, 65536);
     mApiProvider->GetParam(mBaseParamIdx + kFFTSize)
         ->InitInt("FFT Size", 1024, 2, 65536);
+    mApiProvider->GetParam(mBaseParamIdx + kTargetSlices)
+        ->InitInt("Target Slices", 0, 0, 10000);
+    mApiProvider->GetParam(mBaseParamIdx + kTargetDensity)
+        ->InitDouble("Target Density", 0.0, 0.0, 50.0, 0.1);
 }
 
 bool OnsetSliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
@@ -37,72 +42,150 @@ bool OnsetSliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
         std::make_shared<MemoryBufferAdaptor>(1, estimatedSlices, sampleRate);
     auto slicesOutputBuffer = fluid::client::BufferT::type(outBuffer);
 
-    auto metric = mApiProvider->GetParam(mBaseParamIdx + kMetric)->Value();
-    auto threshold =
-        mApiProvider->GetParam(mBaseParamIdx + kThreshold)->Value();
-    auto filterSize =
-        mApiProvider->GetParam(mBaseParamIdx + kFilterSize)->Value();
-    auto frameDelta =
-        mApiProvider->GetParam(mBaseParamIdx + kFrameDelta)->Value();
-    auto minLength =
-        mApiProvider->GetParam(mBaseParamIdx + kMinSliceLength)->Value();
-    auto windowSize =
-        mApiProvider->GetParam(mBaseParamIdx + kWindowSize)->Value();
-    auto hopSize = mApiProvider->GetParam(mBaseParamIdx + kHopSize)->Value();
-    auto fftSize = mApiProvider->GetParam(mBaseParamIdx + kFFTSize)->Value();
+    auto metric = GetParamValue(kMetric);
+    auto filterSize = GetParamValue(kFilterSize);
+    auto frameDelta = GetParamValue(kFrameDelta);
+    auto windowSize = GetParamValue(kWindowSize);
+    auto hopSize = GetParamValue(kHopSize);
+    auto fftSize = GetParamValue(kFFTSize);
 
     if (static_cast<int>(filterSize) % 2 == 0)
         filterSize += 1;
 
-    mParams.template set<0>(std::move(sourceBuffer), nullptr);
-    mParams.template set<1>(LongT::type(0), nullptr);
-    mParams.template set<2>(LongT::type(-1), nullptr);
-    mParams.template set<3>(LongT::type(0), nullptr);
-    mParams.template set<4>(LongT::type(-1), nullptr);
+    Settings settings;
+    settings.metric = static_cast<fluid::index>(metric);
+    settings.filterSize = static_cast<fluid::index>(filterSize);
+    settings.frameDelta = static_cast<fluid::index>(frameDelta);
+    settings.windowSize = static_cast<fluid::index>(windowSize);
+    settings.hopSize = static_cast<fluid::index>(hopSize);
+    settings.fftSize = Spectrogram::EffectiveFFTSize(
+        settings.windowSize, static_cast<fluid::index>(fftSize));
+
     mParams.template set<5>(std::move(slicesOutputBuffer), nullptr);
-    mParams.template set<6>(LongT::type(metric), nullptr);
-    mParams.template set<7>(FloatT::type(threshold), nullptr);
-    mParams.template set<8>(LongT::type(minLength), nullptr);
-    mParams.template set<9>(LongRuntimeMaxParam(filterSize, filterSize),
-                            nullptr);
-    mParams.template set<10>(LongT::type(frameDelta), nullptr);
-    mParams.template set<11>(
-        fluid::client::FFTParams(windowSize, hopSize, fftSize), nullptr);
-
-    mClient = NRTThreadingOnsetSliceClient(mParams, mContext);
-    mClient.setSynchronous(false);
-    mClient.enqueue(mParams);
-    Result result = mClient.process();
-    return result.ok();
+    RunTask([this, sourceBuffer, outBuffer, sampleRate, settings]() {
+        return DetectOnsets(sourceBuffer.get(), outBuffer.get(), sampleRate,
+                            settings);
+    });
+    return true;
 }
 
-bool OnsetSliceAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
-                                        int numChannels, int sampleRate) {
-    auto processedSlicesBuffer = mParams.template get<5>();
-    BufferAdaptor::ReadAccess reader(processedSlicesBuffer.get());
-
+// Runs the client's detection function over the summed channels, which is
+// what the client analyses, framed as the client frames them. The whole
+// curve is kept so that onsets can be picked from it as often as a slice
+// target or a change of threshold needs.
+bool OnsetSliceAlgorithm::DetectOnsets(const BufferAdaptor *source,
+                                       BufferAdaptor *output, int sampleRate,
+                                       const Settings &settings) {
+    BufferAdaptor::ReadAccess reader(source);
     if (!reader.exists() || !reader.valid())
         return false;
 
-    int markerCount = GetNumTakeMarkers(take);
-    for (int i = markerCount - 1; i >= 0; i--) {
-        DeleteTakeMarker(take, i);
-    }
+    const STFTFraming framing{settings.windowSize, settings.hopSize,
+                              settings.fftSize};
+    const fluid::index numSamples = reader.numFrames();
+    const fluid::index numFrames = framing.NumFrames(numSamples);
+
+    fluid::algorithm::OnsetDetectionFunctions detector(settings.fftSize,
+                                                       settings.filterSize);
+    detector.init(settings.windowSize, settings.fftSize, settings.filterSize);
+
+    // The detector compares each window with the one frameDelta samples
+    // before it, so it is handed that much more audio.
+    RealVector frame(settings.windowSize + settings.frameDelta);
+    std::vector<double> curve;
+    curve.reserve(numFrames);
+    for (fluid::index f = 0; f < numFrames; ++f) {
+        if (mCancelToken.IsCancelled())
+            return false;
 
-    double itemLength = GetMediaItemInfo_Value(item, "D_LENGTH");
-    auto view = reader.samps(0);
-    for (fluid::index i = 0; i < view.size(); i++) {
-        if (view(i) > 0) {
-            double markerTimeInSeconds =
-                static_cast<double>(view(i)) / sampleRate;
-            if (markerTimeInSeconds < itemLength) {
-                SetTakeMarker(take, -1, "", &markerTimeInSeconds, nullptr);
+        const fluid::index start = framing.FrameStart(f) - settings.frameDelta;
+        for (fluid::index i = 0; i < frame.size(); ++i) {
+            frame(i) = 0.0;
+        }
+        const fluid::index first = std::max<fluid::index>(0, -start);
+        const fluid::index end = std::min(frame.size(), numSamples - start);
+        for (fluid::index c = 0; c < reader.numChans(); ++c) {
+            auto samples = reader.samps(c);
+            for (fluid::index i = first; i < end; ++i) {
+                frame(i) += samples(start + i);
             }
         }
+        curve.push_back(detector.processFrame(
+            frame, settings.metric, settings.filterSize, settings.frameDelta));
+        mJobProgress.Report(static_cast<double>(f + 1) / numFrames);
     }
+
+    WriteCurveSlices(output, curve, framing.FrameStart(0), settings.hopSize,
+                     sampleRate);
     return true;
 }
 
+// Picks upward threshold crossings the way OnsetSegmentation does; each is
+// a slice at the start of the window that crossed, or at the start of the
+// audio for a window that began in the padding before it. A slice's strength
+// is the highest value reached before the curve falls back under the
+// threshold.
+void OnsetSliceAlgorithm::PickPeaks(const std::vector<double> &curve,
+                                    double threshold,
+                                    std::vector<fluid::index> &peaks,
+                                    std::vector<float> &strengths) const {
+    peaks.clear();
+    strengths.clear();
+    const auto minSliceLength =
+        static_cast<fluid::index>(GetParamValue(kMinSliceLength));
+    double previous = 0;
+    bool inOnset = false;
+    fluid::index debounce = 0;
+    for (size_t i = 0; i < curve.size(); ++i) {
+        const double value = curve[i];
+        if (value > threshold && previous < threshold && debounce == 0) {
+            peaks.push_back(static_cast<fluid::index>(i));
+            strengths.push_back(static_cast<float>(value));
+            debounce = minSliceLength;
+            inOnset = true;
+        } else if (debounce > 0) {
+            --debounce;
+        }
+        inOnset = inOnset && value >= threshold;
+        if (inOnset) {
+            strengths.back() =
+                std::max(strengths.back(), static_cast<float>(value));
+        }
+        previous = value;
+    }
+}
+
+double OnsetSliceAlgorithm::GetThreshold() const {
+    return GetParamValue(kThreshold);
+}
+
+std::string OnsetSliceAlgorithm::GetCurveSignature() const {
+    return GetSignatureOf({kMetric, kFilterSize, kFrameDelta, kWindowSize,
+                           kHopSize, kFFTSize});
+}
+
+fluid::index OnsetSliceAlgorithm::GetContextFrames() const {
+    auto param = [this](int idx) {
+        return static_cast<fluid::index>(GetParamValue(idx));
+    };
+    fluid::index hops =
+        param(kFilterSize) + param(kFrameDelta) + param(kMinSliceLength) + 1;
+    return hops * param(kHopSize) +
+           std::max(param(kWindowSize), param(kFFTSize));
+}
+
+bool OnsetSliceAlgorithm::UsesSliceTarget() const {
+    return GetParamValue(kTargetSlices) > 0 ||
+           GetParamValue(kTargetDensity) > 0;
+}
+
+fluid::index OnsetSliceAlgorithm::TargetSlicesFor(fluid::index frameCount,
+                                                  int sampleRate) const {
+    return TargetSliceCount(GetParamValue(kTargetSlices),
+                            GetParamValue(kTargetDensity), frameCount,
+                            sampleRate);
+}
+
 const char *OnsetSliceAlgorithm::GetName() const { return "Onset Slice"; }
 
 int OnsetSliceAlgorithm::GetNumAlgorithmParams() const { return kNumParams; }
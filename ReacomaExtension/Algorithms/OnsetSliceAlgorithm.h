@@ -2,8 +2,11 @@
 #include "../../dependencies/flucoma-core/include/flucoma/clients/rt/OnsetSliceClient.hpp"
 #include "FlucomaAlgorithmBase.h"
 
+// Detects onsets with the onset slice client's detection function, run here
+// in a task so that the whole curve is kept. The client itself is never
+// run: its parameter set carries the slice output, as for the other slicers.
 class OnsetSliceAlgorithm
-    : public FlucomaAlgorithm<fluid::client::NRTThreadingOnsetSliceClient> {
+    : public SlicerAlgorithm<fluid::client::NRTThreadingOnsetSliceClient> {
   public:
     enum Params {
         kMetric = 0,
@@ -14,6 +17,8 @@ class OnsetSliceAlgorithm
         kWindowSize,
         kHopSize,
         kFFTSize,
+        kTargetSlices,
+        kTargetDensity,
         kNumParams
     };
 
@@ -27,6 +32,26 @@ class OnsetSliceAlgorithm
   protected:
     bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                    int frameCount, int sampleRate) override;
-    bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
-                       int sampleRate) override;
+    fluid::index GetContextFrames() const override;
+    bool UsesSliceTarget() const override;
+    fluid::index TargetSlicesFor(fluid::index frameCount,
+                                 int sampleRate) const override;
+    std::string GetCurveSignature() const override;
+    void PickPeaks(const std::vector<double> &curve, double threshold,
+                   std::vector<fluid::index> &peaks,
+                   std::vector<float> &strengths) const override;
+    double GetThreshold() const override;
+
+  private:
+    struct Settings {
+        fluid::index metric;
+        fluid::index filterSize;
+        fluid::index frameDelta;
+        fluid::index windowSize;
+        fluid::index hopSize;
+        fluid::index fftSize;
+    };
+
+    bool DetectOnsets(const BufferAdaptor *source, BufferAdaptor *output,
+                      int sampleRate, const Settings &settings);
 };
\ No newline at end of file
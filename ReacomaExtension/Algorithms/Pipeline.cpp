@@ -0,0 +1,107 @@
+#include "Pipeline.h"
+
+const std::vector<PipelineDefinition> &GetBuiltinPipelines() {
+    static const std::vector<PipelineDefinition> pipelines = {
+        {"Reacoma: HPSS percussive > Onset Slice",
+         {{ReacomaExtension::kHPSS, nullptr},
+          {ReacomaExtension::kOnsetSlice, "percussive"}}},
+        {"Reacoma: HPSS percussive > Transient Slice",
+         {{ReacomaExtension::kHPSS, nullptr},
+          {ReacomaExtension::kTransientSlice, "percussive"}}},
+        {"Reacoma: HPSS harmonic > Novelty Slice",
+         {{ReacomaExtension::kHPSS, nullptr},
+          {ReacomaExtension::kNoveltySlice, "harmonic"}}},
+    };
+    return pipelines;
+}
+
+PipelineAlgorithm::PipelineAlgorithm(
+    ReacomaExtension *apiProvider, const PipelineDefinition &definition,
+    std::vector<std::unique_ptr<IAlgorithm>> stages)
+    : IAlgorithm(apiProvider), mDefinition(definition),
+      mStages(std::move(stages)) {
+    for (size_t i = 0; i + 1 < mStages.size(); ++i) {
+        mStages[i]->SetPipelineStage(true);
+    }
+}
+
+PipelineAlgorithm::~PipelineAlgorithm() = default;
+
+bool PipelineAlgorithm::StartProcessItemsAsync(
+    const std::vector<MediaItem *> &items) {
+    mItems = items;
+    mCurrentStage = 0;
+    mFailed =
+        mStages.empty() || !mStages.front()->StartProcessItemsAsync(items);
+    return !mFailed;
+}
+
+bool PipelineAlgorithm::IsFinished() {
+    if (mStages.empty())
+        return true;
+
+    while (!mFailed && mStages[mCurrentStage]->IsFinished()) {
+        if (mCurrentStage + 1 == mStages.size())
+            return true;
+
+        const char *input = mDefinition.stages[mCurrentStage + 1].input;
+        StageAudio audio = mStages[mCurrentStage]->GetAudioOutput(input);
+        ++mCurrentStage;
+        mFailed =
+            !mStages[mCurrentStage]->StartProcessBufferAsync(mItems, audio);
+    }
+    // A failed or cancelled stage may still be winding down.
+    return mFailed && mStages[mCurrentStage]->IsFinished();
+}
+
+bool PipelineAlgorithm::Succeeded() {
+    return !mFailed && !mStages.empty() && mStages.back()->Succeeded();
+}
+
+bool PipelineAlgorithm::FinalizeProcess() {
+    if (mFailed) {
+        for (MediaItem *item : mItems) {
+            SetMediaItemInfo_Value(item, "C_LOCK", false);
+        }
+        return false;
+    }
+    return mStages.back()->FinalizeProcess();
+}
+
+void PipelineAlgorithm::SetSliceSink(SliceSink sink) {
+    if (!mStages.empty()) {
+        mStages.back()->SetSliceSink(std::move(sink));
+    }
+}
+
+double PipelineAlgorithm::GetProgress() {
+    if (mStages.empty())
+        return 1.0;
+    return (mCurrentStage + mStages[mCurrentStage]->GetProgress()) /
+           mStages.size();
+}
+
+void PipelineAlgorithm::Cancel() {
+    if (!mStages.empty()) {
+        mStages[mCurrentStage]->Cancel();
+    }
+    mFailed = true;
+}
+
+const char *PipelineAlgorithm::GetName() const { return mDefinition.name; }
+
+void PipelineAlgorithm::RegisterParameters() {}
+
+int PipelineAlgorithm::GetNumAlgorithmParams() const { return 0; }
+
+bool PipelineAlgorithm::SupportsSegmentation() {
+    return !mStages.empty() && mStages.back()->SupportsSegmentation();
+}
+
+bool PipelineAlgorithm::SupportsRegions() {
+    return !mStages.empty() && mStages.back()->SupportsRegions();
+}
+
+bool PipelineAlgorithm::CreatesTakes() {
+    return !mStages.empty() && mStages.back()->CreatesTakes();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "IAlgorithm.h"
+#include "ReacomaExtension.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// One step of a pipeline. Every stage after the first reads the named audio
+// output of the stage before it instead of the items' source.
+struct PipelineStage {
+    ReacomaExtension::EAlgorithmChoice algorithm;
+    const char *input;
+};
+
+struct PipelineDefinition {
+    const char *name;
+    std::vector<PipelineStage> stages;
+};
+
+const std::vector<PipelineDefinition> &GetBuiltinPipelines();
+
+// Runs the stages of a pipeline one after another, keeping the audio passed
+// between them in memory. Only the last stage writes anything to the
+// project. Each stage uses the current parameters of its algorithm.
+class PipelineAlgorithm : public IAlgorithm {
+  public:
+    PipelineAlgorithm(ReacomaExtension *apiProvider,
+                      const PipelineDefinition &definition,
+                      std::vector<std::unique_ptr<IAlgorithm>> stages);
+    ~PipelineAlgorithm() override;
+
+    bool StartProcessItemsAsync(const std::vector<MediaItem *> &items) override;
+    bool IsFinished() override;
+    bool Succeeded() override;
+    bool FinalizeProcess() override;
+    void SetSliceSink(SliceSink sink) override;
+
+    double GetProgress() override;
+    void Cancel() override;
+
+    const char *GetName() const override;
+    void RegisterParameters() override;
+    int GetNumAlgorithmParams() const override;
+
+    bool SupportsSegmentation() override;
+    bool SupportsRegions() override;
+    bool CreatesTakes() override;
+
+  private:
+    const PipelineDefinition &mDefinition;
+    std::vector<std::unique_ptr<IAlgorithm>> mStages;
+    std::vector<MediaItem *> mItems;
+    size_t mCurrentStage = 0;
+    bool mFailed = false;
+};
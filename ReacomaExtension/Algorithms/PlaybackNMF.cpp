@@ -0,0 +1,89 @@
+#include "PlaybackNMF.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// Weight of the latest block in the averaged load, about 20 blocks' worth.
+constexpr double kLoadSmoothing = 0.05;
+} // namespace
+
+PlaybackNMF::PlaybackNMF() {
+    mHook.OnAudioBuffer = &PlaybackNMF::OnAudioBuffer;
+    mHook.userdata1 = this;
+}
+
+PlaybackNMF::~PlaybackNMF() { Stop(); }
+
+void PlaybackNMF::Start(const NMFBases &bases) {
+    if (bases.IsEmpty())
+        return;
+
+    Tick();
+    // A filter the audio thread has not picked up yet is simply replaced.
+    delete mPending.exchange(new NMFFilter(bases));
+    if (!mRegistered) {
+        mRegistered = Audio_RegHardwareHook(true, &mHook) > 0;
+    }
+}
+
+void PlaybackNMF::Stop() {
+    if (mRegistered) {
+        Audio_RegHardwareHook(false, &mHook);
+        mRegistered = false;
+    }
+    // REAPER no longer calls the hook once it has been removed, so every
+    // filter is the main thread's again.
+    delete mActive;
+    mActive = nullptr;
+    delete mPending.exchange(nullptr);
+    delete mRetired.exchange(nullptr);
+    mLoad.store(0.0);
+    mRateMatches.store(true);
+}
+
+void PlaybackNMF::Tick() { delete mRetired.exchange(nullptr); }
+
+void PlaybackNMF::OnAudioBuffer(bool isPost, int length, double sampleRate,
+                                audio_hook_register_t *hook) {
+    // The output is only there to filter once REAPER has mixed the block.
+    if (isPost) {
+        static_cast<PlaybackNMF *>(hook->userdata1)
+            ->Process(length, sampleRate);
+    }
+}
+
+void PlaybackNMF::Process(int length, double sampleRate) {
+    const auto started = std::chrono::steady_clock::now();
+
+    // A new filter is only taken once the main thread has freed the last
+    // one handed back, so the slot never has to hold two.
+    if (!mRetired.load()) {
+        if (NMFFilter *next = mPending.exchange(nullptr)) {
+            mRetired.store(mActive);
+            mActive = next;
+        }
+    }
+    if (!mActive || length <= 0 || sampleRate <= 0.0)
+        return;
+    const bool rateMatches =
+        static_cast<int>(sampleRate) == mActive->GetSampleRate();
+    mRateMatches.store(rateMatches);
+    if (!rateMatches)
+        return;
+
+    ReaSample *channels[NMFFilter::kMaxChannels] = {};
+    const int maxChannels = std::min(mHook.output_nch, NMFFilter::kMaxChannels);
+    int numChannels = 0;
+    while (numChannels < maxChannels &&
+           (channels[numChannels] = mHook.GetBuffer(true, numChannels))) {
+        ++numChannels;
+    }
+    mActive->Process(channels, numChannels, length, mComponent.load(),
+                     mIterations.load());
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - started;
+    const double load = elapsed.count() * sampleRate / length;
+    mLoad.store(mLoad.load() + (load - mLoad.load()) * kLoadSmoothing);
+}
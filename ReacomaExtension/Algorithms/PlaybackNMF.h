@@ -0,0 +1,57 @@
+#pragma once
+
+#include "NMFFilter.h"
+
+#include "wdltypes.h"
+#include "reaper_plugin.h"
+#include "reaper_plugin_functions.h"
+
+#include <atomic>
+
+// Keeps one NMF component of REAPER's hardware output through a native
+// audio hook. Filters are built on the main thread and handed to the audio
+// thread through atomic slots, one each way, so that neither thread waits
+// for the other or frees memory the other may be using.
+class PlaybackNMF {
+  public:
+    PlaybackNMF();
+    ~PlaybackNMF();
+
+    // Main thread. Starting again swaps in filters for the new bases.
+    void Start(const NMFBases &bases);
+    void Stop();
+    bool IsRunning() const { return mRegistered; }
+    // Frees filters the audio thread has let go of.
+    void Tick();
+
+    // Read by the audio thread at the start of each block. Components count
+    // from 0.
+    void SetComponent(int component) { mComponent.store(component); }
+    void SetIterations(int iterations) { mIterations.store(iterations); }
+
+    // Time spent filtering a block as a fraction of the block's length,
+    // averaged over recent blocks.
+    double GetLoad() const { return mLoad.load(); }
+    // False while the output runs at another rate than the bases were
+    // learned at, when it is left unfiltered.
+    bool RateMatches() const { return mRateMatches.load(); }
+
+  private:
+    static void OnAudioBuffer(bool isPost, int length, double sampleRate,
+                              audio_hook_register_t *hook);
+    void Process(int length, double sampleRate);
+
+    audio_hook_register_t mHook{};
+    bool mRegistered = false;
+
+    // Only ever touched by the audio thread while registered.
+    NMFFilter *mActive = nullptr;
+    // Main thread to audio thread, and back once replaced.
+    std::atomic<NMFFilter *> mPending{nullptr};
+    std::atomic<NMFFilter *> mRetired{nullptr};
+
+    std::atomic<int> mComponent{0};
+    std::atomic<int> mIterations{10};
+    std::atomic<double> mLoad{0.0};
+    std::atomic<bool> mRateMatches{true};
+};
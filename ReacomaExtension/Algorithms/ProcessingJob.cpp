@@ -4,15 +4,21 @@
 #include "NMFAlgorithm.h"
 #include "OnsetSliceAlgorithm.h"
 #include "TransientSliceAlgorithm.h"
+#include "AmpSliceAlgorithm.h"
+#include "AmpGateAlgorithm.h"
+#include "DescriptorAlgorithm.h"
 #include "TransientAlgorithm.h"
+#include "SinesAlgorithm.h"
+#include "Pipeline.h"
+#include "CompareAlgorithm.h"
 
 ProcessingJob::ProcessingJob(std::unique_ptr<IAlgorithm> algorithm,
-                             MediaItem *item)
-    : mAlgorithm(std::move(algorithm)), mItem(item) {}
+                             const std::vector<MediaItem *> &items)
+    : mAlgorithm(std::move(algorithm)), mItems(items) {}
 
 void ProcessingJob::Start() {
-    if (mAlgorithm && mItem) {
-        mAlgorithm->StartProcessItemAsync(mItem);
+    if (mAlgorithm && !mItems.empty()) {
+        mAlgorithm->StartProcessItemsAsync(mItems);
     }
 }
 
@@ -20,10 +26,11 @@ bool ProcessingJob::IsFinished() {
     return mAlgorithm ? mAlgorithm->IsFinished() : true;
 }
 
-void ProcessingJob::Finalize() {
-    if (mAlgorithm && mItem) {
-        mAlgorithm->FinalizeProcess(mItem);
-    }
+bool ProcessingJob::Finalize() {
+    if (!mAlgorithm || mItems.empty())
+        return false;
+    const bool succeeded = mAlgorithm->Succeeded();
+    return mAlgorithm->FinalizeProcess() && succeeded;
 }
 
 void ProcessingJob::Cancel() {
@@ -32,9 +39,9 @@ void ProcessingJob::Cancel() {
     }
 }
 
-std::unique_ptr<ProcessingJob>
-ProcessingJob::Create(ReacomaExtension::EAlgorithmChoice algoChoice,
-                      MediaItem *item, ReacomaExtension *provider) {
+std::unique_ptr<IAlgorithm>
+ProcessingJob::CreateAlgorithm(ReacomaExtension::EAlgorithmChoice algoChoice,
+                               ReacomaExtension *provider) {
     std::unique_ptr<IAlgorithm> algorithm = nullptr;
     const IAlgorithm *prototypeAlgorithm = nullptr;
 
@@ -63,11 +70,86 @@ ProcessingJob::Create(ReacomaExtension::EAlgorithmChoice algoChoice,
         algorithm = std::make_unique<TransientSliceAlgorithm>(provider);
         prototypeAlgorithm = provider->GetTransientSliceAlgorithm();
         break;
+    case ReacomaExtension::kAmpSlice:
+        algorithm = std::make_unique<AmpSliceAlgorithm>(provider);
+        prototypeAlgorithm = provider->GetAmpSliceAlgorithm();
+        break;
+    case ReacomaExtension::kAmpGate:
+        algorithm = std::make_unique<AmpGateAlgorithm>(provider);
+        prototypeAlgorithm = provider->GetAmpGateAlgorithm();
+        break;
+    case ReacomaExtension::kSines:
+        algorithm = std::make_unique<SinesAlgorithm>(provider);
+        prototypeAlgorithm = provider->GetSinesAlgorithm();
+        break;
+    case ReacomaExtension::kDescribe:
+        algorithm = std::make_unique<DescriptorAlgorithm>(provider);
+        prototypeAlgorithm = provider->GetDescriptorAlgorithm();
+        break;
     }
 
     if (algorithm && prototypeAlgorithm) {
         algorithm->SetBaseParamIdx(prototypeAlgorithm->GetBaseParamIdx());
-        return std::make_unique<ProcessingJob>(std::move(algorithm), item);
+        algorithm->SnapshotParams();
+        algorithm->SetSliceOutput(provider->GetSliceOutput());
+        return algorithm;
     }
     return nullptr;
 }
+
+std::unique_ptr<ProcessingJob>
+ProcessingJob::Create(ReacomaExtension::EAlgorithmChoice algoChoice,
+                      const std::vector<MediaItem *> &items,
+                      ReacomaExtension *provider) {
+    auto algorithm = CreateAlgorithm(algoChoice, provider);
+    if (!algorithm)
+        return nullptr;
+    return std::make_unique<ProcessingJob>(std::move(algorithm), items);
+}
+
+std::unique_ptr<ProcessingJob>
+ProcessingJob::CreatePipeline(const PipelineDefinition &pipeline,
+                              const std::vector<MediaItem *> &items,
+                              ReacomaExtension *provider) {
+    std::vector<std::unique_ptr<IAlgorithm>> stages;
+    for (const PipelineStage &stage : pipeline.stages) {
+        auto algorithm = CreateAlgorithm(stage.algorithm, provider);
+        if (!algorithm)
+            return nullptr;
+        stages.push_back(std::move(algorithm));
+    }
+    return std::make_unique<ProcessingJob>(
+        std::make_unique<PipelineAlgorithm>(provider, pipeline,
+                                            std::move(stages)),
+        items);
+}
+
+std::unique_ptr<ProcessingJob>
+ProcessingJob::CreateComparison(const std::vector<MediaItem *> &items,
+                                ReacomaExtension *provider) {
+    struct ComparedSlicer {
+        ReacomaExtension::EAlgorithmChoice algorithm;
+        const char *markerName;
+        int r, g, b;
+    };
+    static const ComparedSlicer slicers[] = {
+        {ReacomaExtension::kNoveltySlice, "novelty", 220, 60, 60},
+        {ReacomaExtension::kOnsetSlice, "onset", 40, 160, 70},
+        {ReacomaExtension::kTransientSlice, "transient", 50, 90, 220},
+        {ReacomaExtension::kAmpSlice, "amp", 230, 150, 30},
+    };
+
+    std::vector<std::unique_ptr<IAlgorithm>> algorithms;
+    for (const ComparedSlicer &slicer : slicers) {
+        auto algorithm = CreateAlgorithm(slicer.algorithm, provider);
+        if (!algorithm)
+            return nullptr;
+        algorithm->SetMarkerStyle(slicer.markerName,
+                                  ColorToNative(slicer.r, slicer.g, slicer.b) |
+                                      0x1000000);
+        algorithms.push_back(std::move(algorithm));
+    }
+    return std::make_unique<ProcessingJob>(
+        std::make_unique<CompareAlgorithm>(provider, std::move(algorithms)),
+        items);
+}
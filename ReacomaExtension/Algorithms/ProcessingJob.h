@@ -1,27 +1,43 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "ReacomaExtension.h"
 #include "IAlgorithm.h"
 
 class MediaItem;
 class ReacomaExtension;
+struct PipelineDefinition;
 
 class ProcessingJob {
   public:
     static std::unique_ptr<ProcessingJob>
-    Create(ReacomaExtension::EAlgorithmChoice algoChoice, MediaItem *item,
-           ReacomaExtension *provider);
+    Create(ReacomaExtension::EAlgorithmChoice algoChoice,
+           const std::vector<MediaItem *> &items, ReacomaExtension *provider);
+    static std::unique_ptr<ProcessingJob>
+    CreatePipeline(const PipelineDefinition &pipeline,
+                   const std::vector<MediaItem *> &items,
+                   ReacomaExtension *provider);
+    static std::unique_ptr<ProcessingJob>
+    CreateComparison(const std::vector<MediaItem *> &items,
+                     ReacomaExtension *provider);
 
     void Start();
     bool IsFinished();
-    void Finalize();
+    // Applies the results; false if the job failed or could not apply them.
+    bool Finalize();
     void Cancel();
 
     double GetProgress() { return mAlgorithm->GetProgress(); }
 
     std::unique_ptr<IAlgorithm> mAlgorithm;
-    MediaItem *mItem;
+    std::vector<MediaItem *> mItems;
+
+    ProcessingJob(std::unique_ptr<IAlgorithm> algorithm,
+                  const std::vector<MediaItem *> &items);
 
-    ProcessingJob(std::unique_ptr<IAlgorithm> algorithm, MediaItem *item);
+  private:
+    static std::unique_ptr<IAlgorithm>
+    CreateAlgorithm(ReacomaExtension::EAlgorithmChoice algoChoice,
+                    ReacomaExtension *provider);
 };
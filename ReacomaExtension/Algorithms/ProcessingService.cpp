@@ -0,0 +1,323 @@
+#include "ProcessingService.h"
+#include "ProcessingJob.h"
+#include "ReacomaExtension.h"
+
+#include <algorithm>
+#include <map>
+#include <thread>
+
+namespace {
+// Applying results touches the project, so it happens on the main thread.
+// Finished jobs are applied a few at a time to keep the arrange view
+// responsive while a large batch completes.
+constexpr std::chrono::milliseconds kFinalizeBudget(15);
+
+// Queued items are not locked, so the user may have deleted them, or closed
+// their project, since the batch was submitted.
+void DropDeletedItems(std::vector<MediaItem *> &items) {
+    items.erase(std::remove_if(items.begin(), items.end(),
+                               [](MediaItem *item) {
+                                   return !ValidatePtr2(nullptr, item,
+                                                        "MediaItem*");
+                               }),
+                items.end());
+}
+
+void UnlockItems(const std::vector<MediaItem *> &items) {
+    for (MediaItem *item : items) {
+        if (ValidatePtr2(nullptr, item, "MediaItem*")) {
+            SetMediaItemInfo_Value(item, "C_LOCK", false);
+        }
+    }
+}
+} // namespace
+
+// Each running job holds its ingested source, its outputs and whatever
+// spectrograms it is computing, on top of what the shared spectrogram cache
+// keeps, so peak memory grows with this limit as well as with the cache.
+ProcessingService::ProcessingService() {
+    auto cores = std::thread::hardware_concurrency();
+    mConcurrencyLimit = std::max(1U, std::min(4U, cores));
+}
+
+ProcessingService::~ProcessingService() {
+    for (auto &job : mActiveJobs) {
+        job->Cancel();
+    }
+}
+
+int ProcessingService::Submit(const std::string &undoName,
+                              const std::vector<MediaItem *> &items,
+                              JobFactory jobFactory, bool writesToProject) {
+    auto batch = std::make_unique<Batch>();
+    batch->undoName = undoName;
+    batch->jobFactory = std::move(jobFactory);
+    batch->writesToProject = writesToProject;
+    for (auto &group : GroupItemsBySource(items)) {
+        batch->pendingJobs.push_back(std::move(group));
+    }
+    batch->totalJobs = batch->pendingJobs.size();
+
+    if (batch->pendingJobs.empty())
+        return 0;
+
+    const int id = mNextBatchId++;
+    batch->id = id;
+    mQueuedBatches.push_back(std::move(batch));
+    if (!mCurrentBatch) {
+        BeginNextBatch();
+    }
+    return id;
+}
+
+void ProcessingService::CancelAll() {
+    for (const auto &batch : mQueuedBatches) {
+        mUnsuccessfulBatches.insert(batch->id);
+    }
+    mQueuedBatches.clear();
+    if (!mCurrentBatch)
+        return;
+
+    mCurrentBatch->failed = true;
+    for (auto &job : mActiveJobs) {
+        job->Cancel();
+    }
+
+    // Jobs that already finished have their results ready; dropping them
+    // without finalizing would leave their items locked. Batches that keep
+    // out of the project never locked them.
+    if (mCurrentBatch->writesToProject) {
+        Undo_BeginBlock2(UndoProject());
+        for (auto &job : mActiveJobs) {
+            UnlockItems(job->mItems);
+        }
+        for (auto &job : mFinalizationQueue) {
+            UnlockItems(job->mItems);
+        }
+        Undo_EndBlock2(UndoProject(), "Reacoma: Batch Process Cancelled", -1);
+    }
+    mDrainingJobs.splice(mDrainingJobs.end(), mActiveJobs);
+    mFinalizationQueue.clear();
+
+    EndBatch();
+}
+
+void ProcessingService::Tick() {
+    mDrainingJobs.remove_if([](const std::unique_ptr<ProcessingJob> &job) {
+        return job->IsFinished();
+    });
+
+    if (!mCurrentBatch)
+        return;
+
+    for (auto it = mActiveJobs.begin(); it != mActiveJobs.end();) {
+        if ((*it)->IsFinished()) {
+            mFinalizationQueue.push_back(std::move(*it));
+            it = mActiveJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto &pendingJobs = mCurrentBatch->pendingJobs;
+    while (mActiveJobs.size() < mConcurrencyLimit && !pendingJobs.empty()) {
+        std::vector<MediaItem *> itemsToProcess =
+            std::move(pendingJobs.front());
+        pendingJobs.pop_front();
+        DropDeletedItems(itemsToProcess);
+        if (itemsToProcess.empty())
+            continue;
+
+        auto job = mCurrentBatch->jobFactory(itemsToProcess);
+        if (job && job->mAlgorithm && job->mAlgorithm->RunsAlone() &&
+            mCurrentBatch->totalJobs > 1) {
+            job = nullptr;
+        }
+        if (job) {
+            job->Start();
+            mActiveJobs.push_back(std::move(job));
+        } else {
+            mCurrentBatch->failed = true;
+        }
+    }
+
+    FinalizeWithinBudget();
+    UpdateProgress();
+
+    if (pendingJobs.empty() && mActiveJobs.empty() &&
+        mFinalizationQueue.empty()) {
+        EndBatch();
+    }
+}
+
+double ProcessingService::GetRemainingSeconds() const {
+    if (!mCurrentBatch)
+        return -1.0;
+
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() -
+                               mBatchStartTime)
+                               .count();
+    // Wait for enough throughput to be observed for the estimate to mean
+    // something.
+    if (elapsed < 1.0 || mProgress < 0.02)
+        return -1.0;
+    return elapsed * (1.0 - mProgress) / mProgress;
+}
+
+double ProcessingService::GetBatchProgress(int batchId) const {
+    if (batchId <= 0 || batchId >= mNextBatchId)
+        return -1.0;
+    if (mCurrentBatch && mCurrentBatch->id == batchId)
+        return mProgress;
+    for (const auto &batch : mQueuedBatches) {
+        if (batch->id == batchId)
+            return 0.0;
+    }
+    return mUnsuccessfulBatches.count(batchId) ? kBatchUnsuccessful : 1.0;
+}
+
+// Batches whose items have all gone since they were queued end here,
+// unsuccessfully.
+void ProcessingService::BeginNextBatch() {
+    while (!mQueuedBatches.empty()) {
+        std::unique_ptr<Batch> batch = std::move(mQueuedBatches.front());
+        mQueuedBatches.pop_front();
+
+        auto &pendingJobs = batch->pendingJobs;
+        for (auto &items : pendingJobs) {
+            DropDeletedItems(items);
+        }
+        pendingJobs.erase(
+            std::remove_if(pendingJobs.begin(), pendingJobs.end(),
+                           [](const std::vector<MediaItem *> &items) {
+                               return items.empty();
+                           }),
+            pendingJobs.end());
+        batch->totalJobs = pendingJobs.size();
+        if (pendingJobs.empty()) {
+            mUnsuccessfulBatches.insert(batch->id);
+            continue;
+        }
+
+        mCurrentBatch = std::move(batch);
+        mProgress = 0.0;
+        mBatchStartTime = std::chrono::steady_clock::now();
+        mUndoProject = GetItemProjectContext(pendingJobs.front().front());
+        return;
+    }
+}
+
+void ProcessingService::EndBatch() {
+    if (mCurrentBatch->failed) {
+        mUnsuccessfulBatches.insert(mCurrentBatch->id);
+    }
+    mUndoProject = nullptr;
+    mCurrentBatch.reset();
+    mProgress = 0.0;
+
+    UpdateArrange();
+    UpdateTimeline();
+
+    BeginNextBatch();
+}
+
+// Each tick's results get an undo point of their own, so that the block
+// never stays open across ticks and takes in the user's own edits.
+void ProcessingService::FinalizeWithinBudget() {
+    if (mFinalizationQueue.empty())
+        return;
+
+    const bool writesToProject = mCurrentBatch->writesToProject;
+    const auto deadline = std::chrono::steady_clock::now() + kFinalizeBudget;
+    if (writesToProject) {
+        Undo_BeginBlock2(UndoProject());
+    }
+    while (!mFinalizationQueue.empty()) {
+        if (!mFinalizationQueue.front()->Finalize()) {
+            mCurrentBatch->failed = true;
+        }
+        mFinalizationQueue.pop_front();
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+    if (writesToProject) {
+        Undo_EndBlock2(UndoProject(), mCurrentBatch->undoName.c_str(), -1);
+    }
+}
+
+// The batch's project may have been closed while it ran; the active project
+// takes the undo point then.
+ReaProject *ProcessingService::UndoProject() const {
+    return ValidatePtr2(nullptr, mUndoProject, "ReaProject*") ? mUndoProject
+                                                               : nullptr;
+}
+
+void ProcessingService::UpdateProgress() {
+    const size_t totalJobs = mCurrentBatch->totalJobs;
+    if (totalJobs == 0)
+        return;
+
+    double totalProgressUnits = 0.0;
+    for (const auto &job : mActiveJobs) {
+        totalProgressUnits += job->GetProgress();
+    }
+
+    size_t completedJobs = totalJobs - mCurrentBatch->pendingJobs.size() -
+                           mActiveJobs.size();
+    totalProgressUnits += static_cast<double>(completedJobs);
+
+    mProgress = std::max(mProgress, totalProgressUnits / totalJobs);
+}
+
+std::vector<std::vector<MediaItem *>>
+ProcessingService::GroupItemsBySource(const std::vector<MediaItem *> &items) {
+    struct SourceRange {
+        MediaItem *item;
+        double start;
+        double end;
+    };
+
+    std::vector<std::vector<MediaItem *>> groups;
+    std::map<std::string, std::vector<SourceRange>> rangesBySource;
+
+    for (MediaItem *item : items) {
+        MediaItem_Take *take = GetActiveTake(item);
+        PCM_source *source = take ? GetMediaItemTake_Source(take) : nullptr;
+
+        char filePath[4096] = "";
+        if (source && !GetMediaSourceParent(source)) {
+            GetMediaSourceFileName(source, filePath, sizeof(filePath));
+        }
+
+        if (!filePath[0]) {
+            groups.push_back({item});
+            continue;
+        }
+
+        const double start = GetMediaItemTakeInfo_Value(take, "D_STARTOFFS");
+        const double length = GetMediaItemInfo_Value(item, "D_LENGTH") *
+                              GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+        rangesBySource[filePath].push_back({item, start, start + length});
+    }
+
+    for (auto &[filePath, ranges] : rangesBySource) {
+        std::sort(ranges.begin(), ranges.end(),
+                  [](const SourceRange &a, const SourceRange &b) {
+                      return a.start < b.start;
+                  });
+
+        double groupEnd = 0.0;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (i == 0 || ranges[i].start > groupEnd) {
+                groups.emplace_back();
+                groupEnd = ranges[i].end;
+            } else {
+                groupEnd = std::max(groupEnd, ranges[i].end);
+            }
+            groups.back().push_back(ranges[i].item);
+        }
+    }
+
+    return groups;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "reaper_plugin.h"
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+class ProcessingJob;
+
+// Owns the queue of submitted batches and the jobs running for them, apart
+// from the window, so that work carries on while the UI is closed. Batches
+// run one after another; the results each tick applies make one undo point.
+// Driven from the extension's idle timer, which REAPER calls whether or not
+// the UI is open.
+class ProcessingService {
+  public:
+    using JobFactory = std::function<std::unique_ptr<ProcessingJob>(
+        const std::vector<MediaItem *> &)>;
+
+    ProcessingService();
+    ~ProcessingService();
+
+    // Queues a batch over the given items. Items sharing a source are grouped
+    // into one job each. Returns an id for the batch, or 0 if there was
+    // nothing to process. A batch whose jobs keep their results out of the
+    // project, with writesToProject false, makes no undo points.
+    int Submit(const std::string &undoName,
+               const std::vector<MediaItem *> &items, JobFactory jobFactory,
+               bool writesToProject = true);
+    // Cancels the running batch and drops every queued one.
+    void CancelAll();
+    void Tick();
+
+    bool IsBusy() const { return mCurrentBatch != nullptr; }
+    size_t GetNumQueuedBatches() const { return mQueuedBatches.size(); }
+    // Progress of the running batch; never goes backwards.
+    double GetProgress() const { return mProgress; }
+    // Extrapolated from the throughput so far, or negative if unknown.
+    double GetRemainingSeconds() const;
+    // 0 while queued and 1 once finished; kBatchUnsuccessful once cancelled
+    // or if any of its jobs failed, and -1 for ids never handed out.
+    static constexpr double kBatchUnsuccessful = -2.0;
+    double GetBatchProgress(int batchId) const;
+
+  private:
+    struct Batch {
+        int id = 0;
+        std::string undoName;
+        JobFactory jobFactory;
+        std::deque<std::vector<MediaItem *>> pendingJobs;
+        size_t totalJobs = 0;
+        bool writesToProject = true;
+        bool failed = false;
+    };
+
+    static std::vector<std::vector<MediaItem *>>
+    GroupItemsBySource(const std::vector<MediaItem *> &items);
+
+    void BeginNextBatch();
+    void EndBatch();
+    void FinalizeWithinBudget();
+    ReaProject *UndoProject() const;
+    void UpdateProgress();
+
+    std::deque<std::unique_ptr<Batch>> mQueuedBatches;
+    std::unique_ptr<Batch> mCurrentBatch;
+
+    unsigned int mConcurrencyLimit = 1;
+    std::list<std::unique_ptr<ProcessingJob>> mActiveJobs;
+    std::deque<std::unique_ptr<ProcessingJob>> mFinalizationQueue;
+    // Cancelled jobs whose workers have not stopped yet; destroyed once they
+    // have, so that cancelling never blocks the main thread.
+    std::list<std::unique_ptr<ProcessingJob>> mDrainingJobs;
+
+    int mNextBatchId = 1;
+    std::set<int> mUnsuccessfulBatches;
+    ReaProject *mUndoProject = nullptr;
+    double mProgress = 0.0;
+    std::chrono::steady_clock::time_point mBatchStartTime;
+};
@@ -0,0 +1,311 @@
+#include "ScriptApi.h"
+#include "ProcessingJob.h"
+#include "ReacomaExtension.h"
+
+#include <cctype>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+using SliceTimes = std::map<MediaItem *, std::vector<double>>;
+
+struct ScriptJob {
+    ReacomaExtension::EAlgorithmChoice choice;
+    std::vector<MediaItem *> items;
+    std::vector<std::pair<std::string, double>> params;
+    int batchId = 0;
+    // Shared with the slice sink, which may still be called after a script
+    // has released the job.
+    std::shared_ptr<SliceTimes> slices;
+};
+
+struct AlgorithmName {
+    const char *name;
+    ReacomaExtension::EAlgorithmChoice choice;
+};
+
+// Compared with spaces removed and case ignored.
+const AlgorithmName kAlgorithmNames[] = {
+    {"noveltyslice", ReacomaExtension::kNoveltySlice},
+    {"onsetslice", ReacomaExtension::kOnsetSlice},
+    {"transientslice", ReacomaExtension::kTransientSlice},
+    {"ampslice", ReacomaExtension::kAmpSlice},
+    {"ampgate", ReacomaExtension::kAmpGate},
+    {"hpss", ReacomaExtension::kHPSS},
+    {"nmf", ReacomaExtension::kNMF},
+    {"transients", ReacomaExtension::kTransients},
+    {"sines", ReacomaExtension::kSines},
+    {"describe", ReacomaExtension::kDescribe},
+};
+
+ReacomaExtension *gExtension = nullptr;
+// REAPER may keep the registration names, so they live as long as we do.
+std::deque<std::string> gRegisteredNames;
+std::map<int, ScriptJob> gJobs;
+int gNextJobId = 1;
+
+ScriptJob *FindJob(int jobId) {
+    auto it = gJobs.find(jobId);
+    return it != gJobs.end() ? &it->second : nullptr;
+}
+
+int Reacoma_CreateJob(const char *algorithm) {
+    if (!gExtension || !algorithm)
+        return 0;
+
+    std::string wanted;
+    for (const char *c = algorithm; *c; ++c) {
+        if (!std::isspace(static_cast<unsigned char>(*c))) {
+            wanted += static_cast<char>(
+                std::tolower(static_cast<unsigned char>(*c)));
+        }
+    }
+
+    for (const AlgorithmName &entry : kAlgorithmNames) {
+        if (wanted == entry.name) {
+            const int jobId = gNextJobId++;
+            gJobs[jobId].choice = entry.choice;
+            return jobId;
+        }
+    }
+    return 0;
+}
+
+bool Reacoma_AddItem(int jobId, MediaItem *item) {
+    ScriptJob *job = FindJob(jobId);
+    if (!job || job->batchId || !ValidatePtr2(nullptr, item, "MediaItem*") ||
+        !GetActiveTake(item))
+        return false;
+
+    job->items.push_back(item);
+    return true;
+}
+
+bool Reacoma_SetParam(int jobId, const char *name, double value) {
+    ScriptJob *job = FindJob(jobId);
+    if (!job || job->batchId || !name)
+        return false;
+
+    const IAlgorithm *algorithm = gExtension->GetAlgorithm(job->choice);
+    if (!algorithm || algorithm->FindParam(name) < 0)
+        return false;
+
+    job->params.emplace_back(name, value);
+    return true;
+}
+
+bool Reacoma_Submit(int jobId, bool writeToProject) {
+    ScriptJob *job = FindJob(jobId);
+    if (!job || job->batchId || job->items.empty())
+        return false;
+
+    // The script may have deleted items since adding them.
+    for (MediaItem *item : job->items) {
+        if (!ValidatePtr2(nullptr, item, "MediaItem*"))
+            return false;
+    }
+
+    // Only slicers have results that can be kept out of the project.
+    IAlgorithm *prototype = gExtension->GetAlgorithm(job->choice);
+    if (!prototype || (!writeToProject && !prototype->SupportsSliceSink()))
+        return false;
+
+    std::shared_ptr<SliceTimes> slices;
+    if (!writeToProject) {
+        slices = std::make_shared<SliceTimes>();
+    }
+    job->slices = slices;
+
+    ReacomaExtension *extension = gExtension;
+    auto jobFactory = [extension, choice = job->choice, params = job->params,
+                       slices](const std::vector<MediaItem *> &items) {
+        auto processingJob = ProcessingJob::Create(choice, items, extension);
+        if (!processingJob)
+            return processingJob;
+
+        for (const auto &[name, value] : params) {
+            processingJob->mAlgorithm->SetParamValue(name, value);
+        }
+        if (slices) {
+            processingJob->mAlgorithm->SetSliceSink(
+                [slices](MediaItem *item, const std::vector<double> &times) {
+                    (*slices)[item] = times;
+                });
+        }
+        return processingJob;
+    };
+
+    job->batchId = extension->GetProcessingService().Submit(
+        "Reacoma: Script batch", job->items, std::move(jobFactory),
+        writeToProject);
+    return job->batchId != 0;
+}
+
+double Reacoma_GetProgress(int jobId) {
+    ScriptJob *job = FindJob(jobId);
+    if (!job)
+        return -1.0;
+    if (!job->batchId)
+        return 0.0;
+    return gExtension->GetProcessingService().GetBatchProgress(job->batchId);
+}
+
+int Reacoma_GetNumSlices(int jobId, MediaItem *item) {
+    ScriptJob *job = FindJob(jobId);
+    if (!job || !job->slices)
+        return -1;
+
+    auto it = job->slices->find(item);
+    return it != job->slices->end() ? static_cast<int>(it->second.size())
+                                    : -1;
+}
+
+double Reacoma_GetSlice(int jobId, MediaItem *item, int index) {
+    ScriptJob *job = FindJob(jobId);
+    if (!job || !job->slices)
+        return -1.0;
+
+    auto it = job->slices->find(item);
+    if (it == job->slices->end() || index < 0 ||
+        index >= static_cast<int>(it->second.size()))
+        return -1.0;
+    return it->second[index];
+}
+
+void Reacoma_ReleaseJob(int jobId) { gJobs.erase(jobId); }
+
+// ReaScript calls through these. Integers, booleans and pointers arrive in
+// the slots themselves, doubles by pointer, and a double result is written
+// to the extra slot at the end.
+template <typename T> void *ToVararg(T value) {
+    return reinterpret_cast<void *>(static_cast<intptr_t>(value));
+}
+
+int IntArg(void **arglist, int index) {
+    return static_cast<int>(reinterpret_cast<intptr_t>(arglist[index]));
+}
+
+void *ReturnDouble(void **arglist, int numparms, double value) {
+    double *result = static_cast<double *>(arglist[numparms - 1]);
+    *result = value;
+    return result;
+}
+
+void *CreateJobVararg(void **arglist, int numparms) {
+    return ToVararg(
+        Reacoma_CreateJob(static_cast<const char *>(arglist[0])));
+}
+
+void *AddItemVararg(void **arglist, int numparms) {
+    return ToVararg(Reacoma_AddItem(IntArg(arglist, 0),
+                                    static_cast<MediaItem *>(arglist[1])));
+}
+
+void *SetParamVararg(void **arglist, int numparms) {
+    return ToVararg(Reacoma_SetParam(IntArg(arglist, 0),
+                                     static_cast<const char *>(arglist[1]),
+                                     *static_cast<double *>(arglist[2])));
+}
+
+void *SubmitVararg(void **arglist, int numparms) {
+    return ToVararg(
+        Reacoma_Submit(IntArg(arglist, 0), IntArg(arglist, 1) != 0));
+}
+
+void *GetProgressVararg(void **arglist, int numparms) {
+    return ReturnDouble(arglist, numparms,
+                        Reacoma_GetProgress(IntArg(arglist, 0)));
+}
+
+void *GetNumSlicesVararg(void **arglist, int numparms) {
+    return ToVararg(Reacoma_GetNumSlices(
+        IntArg(arglist, 0), static_cast<MediaItem *>(arglist[1])));
+}
+
+void *GetSliceVararg(void **arglist, int numparms) {
+    return ReturnDouble(arglist, numparms,
+                        Reacoma_GetSlice(IntArg(arglist, 0),
+                                         static_cast<MediaItem *>(arglist[1]),
+                                         IntArg(arglist, 2)));
+}
+
+void *ReleaseJobVararg(void **arglist, int numparms) {
+    Reacoma_ReleaseJob(IntArg(arglist, 0));
+    return nullptr;
+}
+
+struct ApiFunction {
+    const char *name;
+    void *function;
+    void *(*vararg)(void **, int);
+    // Return type, argument types, argument names and help, separated by
+    // NUL characters as REAPER expects.
+    const char *definition;
+};
+
+const ApiFunction kApiFunctions[] = {
+    {"Reacoma_CreateJob", reinterpret_cast<void *>(&Reacoma_CreateJob),
+     &CreateJobVararg,
+     "int\0const char*\0algorithm\0"
+     "Creates a job for an algorithm such as \"Novelty Slice\" or \"HPSS\". "
+     "Returns 0 if the algorithm is unknown."},
+    {"Reacoma_AddItem", reinterpret_cast<void *>(&Reacoma_AddItem),
+     &AddItemVararg,
+     "bool\0int,MediaItem*\0job,item\0"
+     "Adds an item to a job that has not been submitted yet."},
+    {"Reacoma_SetParam", reinterpret_cast<void *>(&Reacoma_SetParam),
+     &SetParamVararg,
+     "bool\0int,const char*,double\0job,name,value\0"
+     "Overrides a parameter for this job only, by its name in the UI. "
+     "Parameters not set keep their current values."},
+    {"Reacoma_Submit", reinterpret_cast<void *>(&Reacoma_Submit),
+     &SubmitVararg,
+     "bool\0int,bool\0job,writeToProject\0"
+     "Queues the job, or returns false if an item has been deleted. Slicers "
+     "submitted with writeToProject false keep their slices for "
+     "Reacoma_GetSlice instead of writing markers, and leave the project and "
+     "its undo history untouched; other algorithms cannot be. Amp Gate keeps "
+     "the start and end of each gate as two consecutive slices."},
+    {"Reacoma_GetProgress", reinterpret_cast<void *>(&Reacoma_GetProgress),
+     &GetProgressVararg,
+     "double\0int\0job\0"
+     "Returns the job's progress from 0 to 1, -2 once it has been cancelled "
+     "or has failed, or -1 for an unknown job."},
+    {"Reacoma_GetNumSlices", reinterpret_cast<void *>(&Reacoma_GetNumSlices),
+     &GetNumSlicesVararg,
+     "int\0int,MediaItem*\0job,item\0"
+     "Returns the number of slices found in an item, or -1 if there are no "
+     "results for it."},
+    {"Reacoma_GetSlice", reinterpret_cast<void *>(&Reacoma_GetSlice),
+     &GetSliceVararg,
+     "double\0int,MediaItem*,int\0job,item,index\0"
+     "Returns a slice time in seconds from the start of the item."},
+    {"Reacoma_ReleaseJob", reinterpret_cast<void *>(&Reacoma_ReleaseJob),
+     &ReleaseJobVararg,
+     "void\0int\0job\0"
+     "Forgets a job and its results. A job still running carries on."},
+};
+} // namespace
+
+void RegisterScriptApi(ReacomaExtension *extension) {
+    gExtension = extension;
+
+    auto registerName = [](const char *prefix, const char *name,
+                           void *value) {
+        gRegisteredNames.push_back(std::string(prefix) + name);
+        plugin_register(gRegisteredNames.back().c_str(), value);
+    };
+
+    for (const ApiFunction &api : kApiFunctions) {
+        registerName("API_", api.name, api.function);
+        registerName("APIdef_", api.name,
+                     const_cast<char *>(api.definition));
+        registerName("APIvararg_", api.name,
+                     reinterpret_cast<void *>(api.vararg));
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+class ReacomaExtension;
+
+// Exposes batch processing to ReaScript as Reacoma_* functions. A script
+// creates a job for an algorithm, adds items and parameter overrides,
+// submits it, polls its progress and, for slicers that were asked not to
+// write markers, reads back the slice times per item:
+//
+//   local job = reaper.Reacoma_CreateJob("Novelty Slice")
+//   reaper.Reacoma_AddItem(job, item)
+//   reaper.Reacoma_SetParam(job, "Threshold", 0.3)
+//   reaper.Reacoma_Submit(job, false)
+//   ... once reaper.Reacoma_GetProgress(job) reaches 1, or -2 if it was
+//   cancelled or failed ...
+//   for i = 0, reaper.Reacoma_GetNumSlices(job, item) - 1 do
+//     local seconds = reaper.Reacoma_GetSlice(job, item, i)
+//   end
+//   reaper.Reacoma_ReleaseJob(job)
+//
+// Jobs run on the same processing service as the UI and the actions.
+void RegisterScriptApi(ReacomaExtension *extension);
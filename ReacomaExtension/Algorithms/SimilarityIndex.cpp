@@ -0,0 +1,72 @@
+#include "SimilarityIndex.h"
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidDataSet.hpp"
+
+#include <cmath>
+#include <string>
+
+SimilarityIndex::SimilarityIndex() = default;
+
+SimilarityIndex::~SimilarityIndex() = default;
+
+fluid::RealMatrix SimilarityIndex::Standardise(const DescriptorTable &table) {
+    const std::vector<size_t> columns = table.MeanColumns();
+    const fluid::index numRows = static_cast<fluid::index>(table.NumRows());
+    const fluid::index numDims = static_cast<fluid::index>(columns.size());
+
+    fluid::RealMatrix points(numRows, numDims);
+    if (!numRows)
+        return points;
+
+    for (fluid::index d = 0; d < numDims; ++d) {
+        const std::vector<float> &values = table.columns[columns[d]];
+        double mean = 0.0;
+        for (float value : values) {
+            mean += value;
+        }
+        mean /= numRows;
+        double variance = 0.0;
+        for (float value : values) {
+            variance += (value - mean) * (value - mean);
+        }
+        const double deviation = std::sqrt(variance / numRows);
+        const double scale = deviation > 0.0 ? 1.0 / deviation : 1.0;
+        for (fluid::index row = 0; row < numRows; ++row) {
+            points(row, d) = (values[row] - mean) * scale;
+        }
+    }
+    return points;
+}
+
+void SimilarityIndex::Build(const DescriptorTable &table) {
+    mTree.reset();
+
+    mPoints = Standardise(table);
+    const fluid::index numRows = mPoints.rows();
+    const fluid::index numDims = mPoints.cols();
+    if (!numRows || !numDims)
+        return;
+
+    // Rows are identified by their index, as FluCoMa's data sets want
+    // string identifiers.
+    fluid::FluidDataSet<std::string, double, 1> dataSet(numDims);
+    for (fluid::index row = 0; row < numRows; ++row) {
+        dataSet.add(std::to_string(row), mPoints.row(row));
+    }
+    mTree = std::make_unique<fluid::algorithm::KDTree>(dataSet);
+}
+
+std::vector<size_t> SimilarityIndex::Nearest(size_t row,
+                                             fluid::index count) const {
+    std::vector<size_t> rows;
+    if (!mTree || static_cast<fluid::index>(row) >= mPoints.rows())
+        return rows;
+
+    fluid::RealVector query(mPoints.row(static_cast<fluid::index>(row)));
+    auto [distances, ids] = mTree->kNearest(query, count + 1);
+    for (const std::string *id : ids) {
+        const size_t neighbour = std::stoul(*id);
+        if (neighbour != row && static_cast<fluid::index>(rows.size()) < count)
+            rows.push_back(neighbour);
+    }
+    return rows;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/KDTree.hpp"
+#include "DescriptorTable.h"
+
+#include <memory>
+#include <vector>
+
+// Nearest-neighbour lookup over the rows of a descriptor table. Only the
+// per-slice means are used, each standardised over the table so that no
+// descriptor outweighs the others by its units alone.
+class SimilarityIndex {
+  public:
+    SimilarityIndex();
+    ~SimilarityIndex();
+
+    // The per-slice means of a table, one row per slice, each column
+    // scaled to zero mean and unit deviation.
+    static fluid::RealMatrix Standardise(const DescriptorTable &table);
+
+    void Build(const DescriptorTable &table);
+    bool IsEmpty() const { return !mTree; }
+
+    // Rows closest to the given row, nearest first, leaving the row itself
+    // out.
+    std::vector<size_t> Nearest(size_t row, fluid::index count) const;
+
+  private:
+    std::unique_ptr<fluid::algorithm::KDTree> mTree;
+    fluid::RealMatrix mPoints;
+};
@@ -0,0 +1,238 @@
+#include "SinesAlgorithm.h"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/SineExtraction.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/STFT.hpp"
+#include "IPlugParameter.h"
+#include "ReacomaExtension.h"
+
+#include <future>
+
+SinesAlgorithm::SinesAlgorithm(ReacomaExtension *apiProvider)
+    : AudioOutputAlgorithm<NRTThreadedSinesClient>(apiProvider) {}
+
+SinesAlgorithm::~SinesAlgorithm() { Shutdown(); }
+
+void SinesAlgorithm::RegisterParameters() {
+    mBaseParamIdx = mApiProvider->NParams();
+
+    for (int i = 0; i < SinesAlgorithm::kNumParams; ++i) {
+        mApiProvider->AddParam();
+    }
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kBandwidth)
+        ->InitInt("Bandwidth", 76, 1, 65536);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kDetectionThreshold)
+        ->InitDouble("Detection Threshold", -96.0, -144.0, 0.0, 0.1);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kBirthLowThreshold)
+        ->InitDouble("Birth Low Threshold", -24.0, -144.0, 0.0, 0.1);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kBirthHighThreshold)
+        ->InitDouble("Birth High Threshold", -60.0, -144.0, 0.0, 0.1);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kMinTrackLength)
+        ->InitInt("Min Track Length", 15, 1, 1000);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kTrackMagRange)
+        ->InitDouble("Track Magnitude Range", 15.0, 1.0, 200.0, 0.1);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kTrackFreqRange)
+        ->InitDouble("Track Frequency Range", 50.0, 1.0, 10000.0, 0.1);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kTrackProb)
+        ->InitDouble("Track Probability", 0.5, 0.0, 1.0, 0.01);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kWindowSize)
+        ->InitInt("Window Size", 1024, 2, 65536);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kHopSize)
+        ->InitInt("Hop Size", 512, 2, 65536);
+
+    mApiProvider->GetParam(mBaseParamIdx + SinesAlgorithm::kFFTSize)
+        ->InitInt("FFT Size", 1024, 2, 65536);
+}
+
+bool SinesAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
+                               int numChannels, int frameCount,
+                               int sampleRate) {
+    Settings settings;
+    settings.bandwidth =
+        static_cast<fluid::index>(GetParamValue(SinesAlgorithm::kBandwidth));
+    settings.detectionThreshold =
+        GetParamValue(SinesAlgorithm::kDetectionThreshold);
+    settings.birthLowThreshold =
+        GetParamValue(SinesAlgorithm::kBirthLowThreshold);
+    settings.birthHighThreshold =
+        GetParamValue(SinesAlgorithm::kBirthHighThreshold);
+    settings.minTrackLength = static_cast<fluid::index>(
+        GetParamValue(SinesAlgorithm::kMinTrackLength));
+    settings.trackMagRange = GetParamValue(SinesAlgorithm::kTrackMagRange);
+    settings.trackFreqRange = GetParamValue(SinesAlgorithm::kTrackFreqRange);
+    settings.trackProb = GetParamValue(SinesAlgorithm::kTrackProb);
+
+    auto windowSize = GetParamValue(SinesAlgorithm::kWindowSize);
+    auto hopSize = GetParamValue(SinesAlgorithm::kHopSize);
+    auto fftSize = GetParamValue(SinesAlgorithm::kFFTSize);
+
+    auto sinesMemoryBuffer =
+        std::make_shared<MemoryBufferAdaptor>(numChannels, frameCount,
+                                              sampleRate);
+    auto residualMemoryBuffer =
+        std::make_shared<MemoryBufferAdaptor>(numChannels, frameCount,
+                                              sampleRate);
+
+    mParams.template set<5>(fluid::client::BufferT::type(sinesMemoryBuffer),
+                            nullptr);
+    mParams.template set<6>(fluid::client::BufferT::type(residualMemoryBuffer),
+                            nullptr);
+
+    const STFTFraming framing{
+        static_cast<fluid::index>(windowSize),
+        static_cast<fluid::index>(hopSize),
+        Spectrogram::EffectiveFFTSize(static_cast<fluid::index>(windowSize),
+                                      static_cast<fluid::index>(fftSize))};
+    RunTask([this, framing, sourceBuffer, sinesMemoryBuffer,
+             residualMemoryBuffer, settings, frameCount, sampleRate]() {
+        return Separate(sourceBuffer.get(), framing, settings, frameCount,
+                        sampleRate, sinesMemoryBuffer.get(),
+                        residualMemoryBuffer.get());
+    });
+    return true;
+}
+
+// Peak tracking carries state from one frame to the next, so a channel is
+// tracked from start to end by one thread. Channels are independent and
+// run side by side.
+bool SinesAlgorithm::Separate(const BufferAdaptor *source,
+                              const STFTFraming &framing,
+                              const Settings &settings,
+                              fluid::index frameCount, int sampleRate,
+                              BufferAdaptor *sinesOutput,
+                              BufferAdaptor *residualOutput) {
+    BufferAdaptor::ReadAccess reader(source);
+    if (!reader.exists() || !reader.valid())
+        return false;
+    const fluid::index numChannels = reader.numChans();
+
+    BufferAdaptor::Access sinesWriter(sinesOutput);
+    BufferAdaptor::Access residualWriter(residualOutput);
+    sinesWriter.resize(frameCount, numChannels, sampleRate);
+    residualWriter.resize(frameCount, numChannels, sampleRate);
+
+    std::atomic<fluid::index> framesDone{0};
+    auto separateChannel = [&](fluid::index c) {
+        return SeparateChannel(reader.samps(c), framing, settings,
+                               numChannels, sampleRate, sinesWriter.samps(c),
+                               residualWriter.samps(c), framesDone);
+    };
+    std::vector<std::future<bool>> channels;
+    for (fluid::index c = 1; c < numChannels; ++c) {
+        channels.push_back(
+            std::async(std::launch::async, separateChannel, c));
+    }
+
+    bool succeeded = separateChannel(0);
+    for (auto &channel : channels) {
+        succeeded = channel.get() && succeeded;
+    }
+    return succeeded;
+}
+
+// The channel is transformed one frame at a time and each separated frame
+// is resynthesised as soon as it comes out, so only a frame's worth of
+// spectrum is held.
+bool SinesAlgorithm::SeparateChannel(
+    fluid::FluidTensorView<const float, 1> input, const STFTFraming &framing,
+    const Settings &settings, fluid::index numChannels, int sampleRate,
+    fluid::FluidTensorView<float, 1> sinesOutput,
+    fluid::FluidTensorView<float, 1> residualOutput,
+    std::atomic<fluid::index> &framesDone) {
+    const fluid::index numSamples = input.size();
+    const fluid::index numFrames = framing.NumFrames(numSamples);
+    const fluid::index numBins = framing.NumBins();
+    // A peak only becomes a track once it has lasted the minimum length, so
+    // the output lags the input by that many frames.
+    const fluid::index delay = settings.minTrackLength;
+    const double totalFrames =
+        static_cast<double>((numFrames + delay) * numChannels);
+
+    fluid::algorithm::STFT stft(framing.windowSize, framing.fftSize,
+                                framing.hopSize);
+    fluid::algorithm::ISTFT istft(framing.windowSize, framing.fftSize,
+                                  framing.hopSize);
+    fluid::algorithm::SineExtraction sines(framing.fftSize);
+    sines.init(framing.windowSize, framing.fftSize, settings.bandwidth);
+    const OverlapAdd overlapAdd(framing, numSamples);
+
+    RealVector window(framing.windowSize);
+    RealVector audio(framing.windowSize);
+    ComplexVector spectrum(numBins);
+    ComplexVector component(numBins);
+    ComplexMatrix separated(numBins, 2);
+
+    for (fluid::index frame = 0; frame < numFrames + delay; ++frame) {
+        if (mCancelToken.IsCancelled())
+            return false;
+
+        if (frame < numFrames) {
+            framing.ReadFrame(input, frame, window);
+            stft.processFrame(window, spectrum);
+        } else {
+            for (fluid::index bin = 0; bin < numBins; ++bin) {
+                spectrum(bin) = 0.0;
+            }
+        }
+        sines.processFrame(spectrum, separated, sampleRate,
+                           settings.detectionThreshold,
+                           settings.minTrackLength, settings.birthLowThreshold,
+                           settings.birthHighThreshold, 0,
+                           settings.trackMagRange, settings.trackFreqRange,
+                           settings.trackProb, settings.bandwidth);
+        if (frame >= delay) {
+            for (fluid::index part = 0; part < 2; ++part) {
+                for (fluid::index bin = 0; bin < numBins; ++bin) {
+                    component(bin) = separated(bin, part);
+                }
+                istft.processFrame(component, audio);
+                overlapAdd.Add(frame - delay, audio,
+                               part == 0 ? sinesOutput : residualOutput);
+            }
+        }
+        mJobProgress.Report((framesDone.fetch_add(1) + 1) / totalFrames);
+    }
+
+    overlapAdd.Finish(sinesOutput);
+    overlapAdd.Finish(residualOutput);
+    return true;
+}
+
+bool SinesAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
+                                   int numChannels, int sampleRate) {
+    auto sinesOutputBuffer = mParams.template get<5>();
+    auto residualOutputBuffer = mParams.template get<6>();
+
+    AddOutputToTake(item, sinesOutputBuffer, sampleRate, "sines");
+    AddOutputToTake(item, residualOutputBuffer, sampleRate, "residual");
+    return true;
+}
+
+void SinesAlgorithm::ReleaseResults() {
+    mParams.template set<5>(BufferT::type(), nullptr);
+    mParams.template set<6>(BufferT::type(), nullptr);
+}
+
+BufferT::type SinesAlgorithm::FindOutput(const std::string &name) {
+    if (name == "sines")
+        return mParams.template get<5>();
+    if (name == "residual")
+        return mParams.template get<6>();
+    return nullptr;
+}
+
+std::vector<std::string> SinesAlgorithm::GetAudioOutputNames() const {
+    return {"sines", "residual"};
+}
+
+const char *SinesAlgorithm::GetName() const { return "Sines"; }
+
+int SinesAlgorithm::GetNumAlgorithmParams() const { return kNumParams; }
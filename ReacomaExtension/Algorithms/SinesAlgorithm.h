@@ -0,0 +1,63 @@
+#pragma once
+#include "../../dependencies/flucoma-core/include/flucoma/clients/rt/SinesClient.hpp"
+#include "FlucomaAlgorithmBase.h"
+
+class SinesAlgorithm
+    : public AudioOutputAlgorithm<fluid::client::NRTThreadedSinesClient> {
+  public:
+    enum Params {
+        kBandwidth = 0,
+        kDetectionThreshold,
+        kBirthLowThreshold,
+        kBirthHighThreshold,
+        kMinTrackLength,
+        kTrackMagRange,
+        kTrackFreqRange,
+        kTrackProb,
+        kWindowSize,
+        kHopSize,
+        kFFTSize,
+        kNumParams
+    };
+
+    SinesAlgorithm(ReacomaExtension *apiProvider);
+    ~SinesAlgorithm() override;
+
+    const char *GetName() const override;
+    void RegisterParameters() override;
+    int GetNumAlgorithmParams() const override;
+    std::vector<std::string> GetAudioOutputNames() const override;
+
+  protected:
+    bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
+                   int frameCount, int sampleRate) override;
+    bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
+                       int sampleRate) override;
+    BufferT::type FindOutput(const std::string &name) override;
+    void ReleaseResults() override;
+
+  private:
+    using ComplexMatrix = fluid::FluidTensor<std::complex<double>, 2>;
+
+    struct Settings {
+        fluid::index bandwidth;
+        double detectionThreshold;
+        double birthLowThreshold;
+        double birthHighThreshold;
+        fluid::index minTrackLength;
+        double trackMagRange;
+        double trackFreqRange;
+        double trackProb;
+    };
+
+    bool Separate(const BufferAdaptor *source, const STFTFraming &framing,
+                  const Settings &settings, fluid::index frameCount,
+                  int sampleRate, BufferAdaptor *sinesOutput,
+                  BufferAdaptor *residualOutput);
+    bool SeparateChannel(fluid::FluidTensorView<const float, 1> input,
+                         const STFTFraming &framing, const Settings &settings,
+                         fluid::index numChannels, int sampleRate,
+                         fluid::FluidTensorView<float, 1> sinesOutput,
+                         fluid::FluidTensorView<float, 1> residualOutput,
+                         std::atomic<fluid::index> &framesDone);
+};
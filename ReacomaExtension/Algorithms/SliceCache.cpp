@@ -0,0 +1,12 @@
+#include "SliceCache.h"
+
+const SliceCache::Entry *SliceCache::Find(const std::string &sourceKey) const {
+    auto it = mEntries.find(sourceKey);
+    return it != mEntries.end() ? &it->second : nullptr;
+}
+
+void SliceCache::Store(const std::string &sourceKey, Entry entry) {
+    mEntries[sourceKey] = std::move(entry);
+}
+
+void SliceCache::Clear() { mEntries.clear(); }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+#include "SliceIndex.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Remembers which slice points a slicer found over a range of a source file,
+// so that re-running it on a trimmed or extended item only needs to analyse
+// the audio it has not seen yet. Positions are absolute source frames.
+class SliceCache {
+  public:
+    struct Entry {
+        std::string paramSignature;
+        fluid::index startFrame = 0;
+        fluid::index endFrame = 0;
+        std::vector<fluid::index> slices;
+        // Detection value of each slice, or empty if the slicer has none.
+        std::vector<float> strengths;
+        // Slicers that run their own detector also keep its curve, one value
+        // per analysis hop, so that slices can be picked again at another
+        // threshold without analysing. curveSignature covers the parameters
+        // that shape the curve, and curveIngestStart is where the audio the
+        // curve's hops line up with was ingested from.
+        std::string curveSignature;
+        DetectionCurve curve;
+        fluid::index curveIngestStart = 0;
+    };
+
+    const Entry *Find(const std::string &sourceKey) const;
+    void Store(const std::string &sourceKey, Entry entry);
+    void Clear();
+
+  private:
+    std::unordered_map<std::string, Entry> mEntries;
+};
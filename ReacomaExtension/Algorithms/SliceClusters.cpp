@@ -0,0 +1,116 @@
+#include "SliceClusters.h"
+#include "ColumnarKMeans.h"
+#include "SimilarityIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace {
+constexpr int kMaxIterations = 100;
+// How far a take marker may lie from the start of a slice and still mark
+// it, in seconds.
+constexpr double kMarkerTolerance = 0.001;
+
+// Hues spread evenly around the colour wheel.
+int ClusterColor(int cluster, int numClusters) {
+    const double saturation = 0.7;
+    const double value = 0.9;
+    const double hue = 6.0 * cluster / std::max(numClusters, 1);
+    const double fraction = hue - std::floor(hue);
+    const double p = value * (1.0 - saturation);
+    const double q = value * (1.0 - saturation * fraction);
+    const double t = value * (1.0 - saturation * (1.0 - fraction));
+
+    double r, g, b;
+    switch (static_cast<int>(hue) % 6) {
+    case 0:
+        r = value, g = t, b = p;
+        break;
+    case 1:
+        r = q, g = value, b = p;
+        break;
+    case 2:
+        r = p, g = value, b = t;
+        break;
+    case 3:
+        r = p, g = q, b = value;
+        break;
+    case 4:
+        r = t, g = p, b = value;
+        break;
+    default:
+        r = value, g = p, b = q;
+        break;
+    }
+    return ColorToNative(static_cast<int>(r * 255), static_cast<int>(g * 255),
+                         static_cast<int>(b * 255)) |
+           0x1000000;
+}
+} // namespace
+
+std::vector<int> SliceClusters::Assign(const DescriptorTable &table,
+                                       int numClusters) {
+    const fluid::RealMatrix points = SimilarityIndex::Standardise(table);
+    ColumnarKMeans::Columns columns(points.cols(),
+                                    std::vector<float>(points.rows()));
+    for (fluid::index d = 0; d < points.cols(); ++d) {
+        for (fluid::index row = 0; row < points.rows(); ++row) {
+            columns[d][row] = static_cast<float>(points(row, d));
+        }
+    }
+    return ColumnarKMeans::Cluster(columns, numClusters, kMaxIterations);
+}
+
+void SliceClusters::Apply(const SliceCorpus &corpus,
+                          const std::vector<int> &clusters) {
+    const size_t numRows = std::min(corpus.slices.size(), clusters.size());
+    if (!numRows)
+        return;
+    const int numClusters =
+        *std::max_element(clusters.begin(), clusters.begin() + numRows) + 1;
+
+    std::map<MediaItem *, std::vector<size_t>> itemRows;
+    for (size_t row = 0; row < numRows; ++row) {
+        itemRows[corpus.slices[row].item].push_back(row);
+    }
+
+    for (const auto &[item, rows] : itemRows) {
+        // The item may have gone while the clusters were worked out.
+        if (!ValidatePtr2(nullptr, item, "MediaItem*"))
+            continue;
+
+        std::vector<int> counts(numClusters, 0);
+        for (size_t row : rows) {
+            ++counts[clusters[row]];
+        }
+        const int itemCluster = static_cast<int>(
+            std::max_element(counts.begin(), counts.end()) - counts.begin());
+        SetMediaItemInfo_Value(item, "I_CUSTOMCOLOR",
+                               ClusterColor(itemCluster, numClusters));
+
+        MediaItem_Take *take = GetActiveTake(item);
+        if (!take || rows.size() < 2)
+            continue;
+
+        const double position = GetMediaItemInfo_Value(item, "D_POSITION");
+        const double startOffset =
+            GetMediaItemTakeInfo_Value(take, "D_STARTOFFS");
+        const double playrate = GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+        for (int i = 0; i < GetNumTakeMarkers(take); ++i) {
+            char name[256] = "";
+            const double sourceTime =
+                GetTakeMarker(take, i, name, sizeof(name), nullptr);
+            const double time =
+                position + (sourceTime - startOffset) / playrate;
+            for (size_t row : rows) {
+                if (std::abs(corpus.slices[row].position - time) <
+                    kMarkerTolerance) {
+                    int color = ClusterColor(clusters[row], numClusters);
+                    SetTakeMarker(take, i, name, nullptr, &color);
+                    break;
+                }
+            }
+        }
+    }
+}
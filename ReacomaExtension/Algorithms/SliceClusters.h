@@ -0,0 +1,19 @@
+#pragma once
+
+#include "SliceCorpus.h"
+
+#include <vector>
+
+// Groups the slices of a corpus by k-means over their standardised
+// descriptor means and colours the items by group.
+struct SliceClusters {
+    // The cluster of each row of the table. Touches no REAPER state, so it
+    // can run off the main thread.
+    static std::vector<int> Assign(const DescriptorTable &table,
+                                   int numClusters);
+
+    // Colours each item by the cluster most of its slices fall in, and the
+    // take markers at the starts of its slices by their own clusters.
+    static void Apply(const SliceCorpus &corpus,
+                      const std::vector<int> &clusters);
+};
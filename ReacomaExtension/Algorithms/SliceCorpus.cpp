@@ -0,0 +1,188 @@
+#include "SliceCorpus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <sstream>
+
+namespace {
+// Sections of a file have no table of their own.
+std::string TablePathFor(MediaItem_Take *take) {
+    PCM_source *source = take ? GetMediaItemTake_Source(take) : nullptr;
+    if (!source || GetMediaSourceParent(source))
+        return {};
+
+    char filePath[4096] = "";
+    GetMediaSourceFileName(source, filePath, sizeof(filePath));
+    if (!filePath[0])
+        return {};
+    return DescriptorTable::PathFor(filePath).string();
+}
+} // namespace
+
+std::string SliceCorpus::SignatureFor(const std::vector<MediaItem *> &items) {
+    std::ostringstream signature;
+    signature.precision(17);
+    for (MediaItem *item : items) {
+        MediaItem_Take *take = GetActiveTake(item);
+        const std::string path = TablePathFor(take);
+        if (path.empty())
+            continue;
+
+        std::error_code error;
+        const auto written = std::filesystem::last_write_time(path, error);
+        signature << item << ' ' << path << ' '
+                  << written.time_since_epoch().count() << ' '
+                  << GetMediaItemInfo_Value(item, "D_POSITION") << ' '
+                  << GetMediaItemInfo_Value(item, "D_LENGTH") << ' '
+                  << GetMediaItemTakeInfo_Value(take, "D_STARTOFFS") << ' '
+                  << GetMediaItemTakeInfo_Value(take, "D_PLAYRATE") << ';';
+    }
+    return signature.str();
+}
+
+SliceCorpus SliceCorpus::ForItems(const std::vector<MediaItem *> &items) {
+    const std::vector<Placement> placements = PlacementsFor(items);
+    Tables tables;
+    LoadTables(placements, tables);
+    return FromPlacements(placements, tables);
+}
+
+bool SliceCorpus::Placement::operator==(const Placement &other) const {
+    return item == other.item && tablePath == other.tablePath &&
+           position == other.position && length == other.length &&
+           startOffset == other.startOffset && playrate == other.playrate;
+}
+
+std::vector<SliceCorpus::Placement>
+SliceCorpus::PlacementsFor(const std::vector<MediaItem *> &items) {
+    std::vector<Placement> placements;
+    for (MediaItem *item : items) {
+        MediaItem_Take *take = GetActiveTake(item);
+        Placement placement;
+        placement.tablePath = TablePathFor(take);
+        if (placement.tablePath.empty())
+            continue;
+
+        placement.item = item;
+        placement.position = GetMediaItemInfo_Value(item, "D_POSITION");
+        placement.length = GetMediaItemInfo_Value(item, "D_LENGTH");
+        placement.startOffset =
+            GetMediaItemTakeInfo_Value(take, "D_STARTOFFS");
+        placement.playrate = GetMediaItemTakeInfo_Value(take, "D_PLAYRATE");
+        placements.push_back(std::move(placement));
+    }
+    return placements;
+}
+
+bool SliceCorpus::LoadTables(const std::vector<Placement> &placements,
+                             Tables &tables) {
+    bool changed = false;
+    Tables loaded;
+    for (const Placement &placement : placements) {
+        const std::string &path = placement.tablePath;
+        if (loaded.count(path))
+            continue;
+
+        // A missing file keeps the same, failed, write time until it
+        // appears.
+        std::error_code error;
+        const auto written = std::filesystem::last_write_time(path, error);
+        auto found = tables.find(path);
+        if (found != tables.end() && found->second.written == written) {
+            loaded.emplace(path, std::move(found->second));
+            continue;
+        }
+
+        LoadedTable table;
+        table.written = written;
+        if (error || !DescriptorTable::Read(path, table.table)) {
+            table.table = DescriptorTable{};
+        }
+        loaded.emplace(path, std::move(table));
+        changed = true;
+    }
+    changed = changed || loaded.size() != tables.size();
+    tables = std::move(loaded);
+    return changed;
+}
+
+SliceCorpus
+SliceCorpus::FromPlacements(const std::vector<Placement> &placements,
+                            const Tables &tables) {
+    SliceCorpus corpus;
+    for (const Placement &placement : placements) {
+        auto found = tables.find(placement.tablePath);
+        if (found == tables.end())
+            continue;
+
+        const DescriptorTable &table = found->second.table;
+        // Every slice in the corpus is described by the same columns.
+        if (!table.NumRows() || table.sampleRate <= 0 ||
+            (!corpus.descriptors.columnNames.empty() &&
+             table.columnNames != corpus.descriptors.columnNames))
+            continue;
+
+        const double sampleRate = table.sampleRate;
+        const double playrate = placement.playrate;
+        const fluid::index takeStart =
+            std::llround(placement.startOffset * sampleRate);
+        const fluid::index takeEnd =
+            takeStart +
+            std::llround(placement.length * playrate * sampleRate);
+
+        for (size_t row = 0; row < table.NumRows(); ++row) {
+            if (table.starts[row] < takeStart || table.starts[row] >= takeEnd)
+                continue;
+
+            const fluid::index end = std::min(table.ends[row], takeEnd);
+            Slice slice;
+            slice.item = placement.item;
+            slice.position =
+                placement.position +
+                (table.starts[row] - takeStart) / sampleRate / playrate;
+            slice.length = (end - table.starts[row]) / sampleRate / playrate;
+            corpus.slices.push_back(slice);
+            corpus.descriptors.AppendRow(table, row);
+        }
+    }
+    corpus.descriptors.sampleRate =
+        tables.empty() ? 0 : tables.begin()->second.table.sampleRate;
+    return corpus;
+}
+
+int SliceCorpus::FindSliceAt(double time) const {
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (time >= slices[i].position &&
+            time < slices[i].position + slices[i].length)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void SliceCorpus::Select(const std::vector<size_t> &rows) const {
+    std::map<MediaTrack *, std::vector<std::pair<double, double>>> ranges;
+    for (const Slice &slice : slices) {
+        ranges[GetMediaItem_Track(slice.item)];
+    }
+    for (size_t row : rows) {
+        const Slice &slice = slices[row];
+        ranges[GetMediaItem_Track(slice.item)].emplace_back(
+            slice.position, slice.position + slice.length);
+    }
+
+    for (auto &[track, trackRanges] : ranges) {
+        if (!track)
+            continue;
+        std::sort(trackRanges.begin(), trackRanges.end());
+        std::ostringstream razorEdits;
+        razorEdits.precision(17);
+        for (const auto &[start, end] : trackRanges) {
+            razorEdits << start << ' ' << end << " \"\" ";
+        }
+        std::string edits = razorEdits.str();
+        GetSetMediaTrackInfo_String(track, "P_RAZOREDITS", edits.data(),
+                                    true);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "DescriptorTable.h"
+
+#include "wdltypes.h"
+#include "reaper_plugin_functions.h"
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// The described slices within a set of items, read from the descriptor
+// tables beside their source files. Only items that play a whole file have
+// a table. Rows of the descriptors follow the slices.
+struct SliceCorpus {
+    struct Slice {
+        MediaItem *item = nullptr;
+        // Project time covered by the slice, cut off at the item's end.
+        double position = 0.0;
+        double length = 0.0;
+    };
+
+    // What the corpus needs of an item, read on the main thread so that the
+    // corpus itself can be built anywhere.
+    struct Placement {
+        MediaItem *item = nullptr;
+        std::string tablePath;
+        double position = 0.0;
+        double length = 0.0;
+        double startOffset = 0.0;
+        double playrate = 1.0;
+
+        bool operator==(const Placement &other) const;
+        bool operator!=(const Placement &other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Tables by path, with the write time of the file they were read from.
+    struct LoadedTable {
+        std::filesystem::file_time_type written;
+        DescriptorTable table;
+    };
+    using Tables = std::map<std::string, LoadedTable>;
+
+    std::vector<Slice> slices;
+    DescriptorTable descriptors;
+
+    // Changes whenever an item is moved or trimmed or a table rewritten, so
+    // that a corpus can be kept for as long as it stays the same.
+    static std::string SignatureFor(const std::vector<MediaItem *> &items);
+    static SliceCorpus ForItems(const std::vector<MediaItem *> &items);
+
+    // Items without a table are left out.
+    static std::vector<Placement>
+    PlacementsFor(const std::vector<MediaItem *> &items);
+    // Reads the tables the placements need into tables, keeping those whose
+    // files have not been written since, and forgets the rest. Returns
+    // whether any changed. Makes no REAPER calls.
+    static bool LoadTables(const std::vector<Placement> &placements,
+                           Tables &tables);
+    // Makes no REAPER calls.
+    static SliceCorpus FromPlacements(const std::vector<Placement> &placements,
+                                      const Tables &tables);
+
+    // Index of the slice playing at a project time, or -1.
+    int FindSliceAt(double time) const;
+    // Replaces the razor edits on the corpus' tracks with the given slices.
+    void Select(const std::vector<size_t> &rows) const;
+};
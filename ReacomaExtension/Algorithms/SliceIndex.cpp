@@ -0,0 +1,149 @@
+#include "SliceIndex.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace {
+// Least significant byte first, whatever the host's byte order.
+template <typename T> void WriteValue(std::ofstream &out, T value) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8);
+    using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof(value));
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = static_cast<char>((bits >> (8 * i)) & 0xFF);
+    }
+    out.write(bytes, sizeof(bytes));
+}
+
+// JSON has no NaN or infinity, so those are written as null.
+void WriteJsonNumber(std::ofstream &out, float value) {
+    if (std::isfinite(value)) {
+        out << value;
+    } else {
+        out << "null";
+    }
+}
+
+// Closes and removes a temporary file that could not be written in full.
+bool DiscardFile(std::ofstream &out, const std::filesystem::path &temporary) {
+    out.close();
+    std::error_code error;
+    std::filesystem::remove(temporary, error);
+    return false;
+}
+
+bool ReplaceFile(const std::filesystem::path &temporary,
+                 const std::filesystem::path &path) {
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+std::filesystem::path SliceIndex::PathFor(const std::string &sourcePath,
+                                          const std::string &slicerName) {
+    std::string slug;
+    for (char c : slicerName) {
+        slug += c == ' ' ? '-'
+                         : static_cast<char>(
+                               std::tolower(static_cast<unsigned char>(c)));
+    }
+    return std::filesystem::path(sourcePath + "." + slug + ".rslc");
+}
+
+bool SliceIndex::Write(const std::filesystem::path &path,
+                       bool withJson) const {
+    const bool hasStrengths =
+        !strengths.empty() && strengths.size() == frames.size();
+    const bool hasCurve = !curve.values.empty() && curve.hop > 0;
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        out.write("RSLC", 4);
+        WriteValue<uint32_t>(out, kVersion);
+        WriteValue<uint32_t>(out, static_cast<uint32_t>(sampleRate));
+        WriteValue<uint32_t>(out, (hasStrengths ? kHasStrengths : 0) |
+                                      (hasCurve ? kHasCurve : 0));
+        WriteValue<int64_t>(out, startFrame);
+        WriteValue<int64_t>(out, endFrame);
+        WriteValue<uint64_t>(out, frames.size());
+        for (fluid::index frame : frames) {
+            WriteValue<int64_t>(out, frame);
+        }
+        if (hasStrengths) {
+            for (float strength : strengths) {
+                WriteValue<float>(out, strength);
+            }
+        }
+        if (hasCurve) {
+            if (hasStrengths && strengths.size() % 2) {
+                WriteValue<float>(out, 0.0f);
+            }
+            WriteValue<int64_t>(out, curve.startFrame);
+            WriteValue<int64_t>(out, curve.hop);
+            WriteValue<uint64_t>(out, curve.values.size());
+            for (float value : curve.values) {
+                WriteValue<float>(out, value);
+            }
+        }
+        if (!out)
+            return DiscardFile(out, temporary);
+    }
+    if (!ReplaceFile(temporary, path))
+        return false;
+
+    if (!withJson)
+        return true;
+
+    std::filesystem::path jsonPath = path;
+    jsonPath += ".json";
+    temporary = jsonPath;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out)
+            return false;
+
+        out << "{\"version\": " << kVersion << ", \"sampleRate\": "
+            << sampleRate << ", \"startFrame\": " << startFrame
+            << ", \"endFrame\": " << endFrame << ", \"slices\": [";
+        for (size_t i = 0; i < frames.size(); ++i) {
+            out << (i ? ", " : "") << "{\"frame\": " << frames[i]
+                << ", \"seconds\": "
+                << static_cast<double>(frames[i]) / sampleRate;
+            if (hasStrengths) {
+                out << ", \"strength\": ";
+                WriteJsonNumber(out, strengths[i]);
+            }
+            out << "}";
+        }
+        out << "]";
+        if (hasCurve) {
+            out << ", \"curve\": {\"startFrame\": " << curve.startFrame
+                << ", \"hop\": " << curve.hop << ", \"values\": [";
+            for (size_t i = 0; i < curve.values.size(); ++i) {
+                out << (i ? ", " : "");
+                WriteJsonNumber(out, curve.values[i]);
+            }
+            out << "]}";
+        }
+        out << "}\n";
+        if (!out)
+            return DiscardFile(out, temporary);
+    }
+    return ReplaceFile(temporary, jsonPath);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Slice points of one slicer over a source file, written next to the file
+// so that other tools can use them without going through REAPER.
+//
+// The binary index is little-endian and laid out to be memory-mapped:
+//
+//   offset  type      field
+//   0       char[4]   "RSLC"
+//   4       uint32    version (1)
+//   8       uint32    sample rate
+//   12      uint32    flags; bit 0 set when strengths follow the frames
+//   16      int64     first source frame covered by the analysis
+//   24      int64     source frame just past the analysed range
+//   32      uint64    number of slices, n
+//   40      int64[n]  slice positions in source frames, ascending
+//   ...     float[n]  detection strength of each slice, if flagged
+//
+// When flag bit 1 is set, a detection curve follows, starting on the next
+// multiple of 8 bytes:
+//
+//   int64     source frame of the first point
+//   int64     source frames between points
+//   uint64    number of points, m
+//   float[m]  largest detection value within each point's span
+//
+// The optional JSON view carries the same data for tools that prefer text.
+struct DetectionCurve {
+    fluid::index startFrame = 0;
+    fluid::index hop = 0;
+    std::vector<float> values;
+};
+
+struct SliceIndex {
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kHasStrengths = 1;
+    static constexpr uint32_t kHasCurve = 2;
+
+    int sampleRate = 0;
+    fluid::index startFrame = 0;
+    fluid::index endFrame = 0;
+    std::vector<fluid::index> frames;
+    // Either empty or one per frame.
+    std::vector<float> strengths;
+    // Covers every frame the slicer has a curve for, cached or fresh.
+    DetectionCurve curve;
+
+    // "<source file>.<slicer>.rslc", with the slicer name lowercased and
+    // spaces replaced by dashes.
+    static std::filesystem::path PathFor(const std::string &sourcePath,
+                                         const std::string &slicerName);
+
+    // Replaces the file in one step, so that readers never map a partial
+    // index. The JSON view goes beside it with ".json" appended.
+    bool Write(const std::filesystem::path &path, bool withJson) const;
+};
@@ -0,0 +1,126 @@
+#include "SliceMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr fluid::index kMapDims = 2;
+}
+
+SliceMap::SliceMap() = default;
+
+SliceMap::~SliceMap() = default;
+
+void SliceMap::Update(const SliceCorpus &corpus) {
+    const DescriptorTable &table = corpus.descriptors;
+    const std::vector<size_t> columns = table.MeanColumns();
+    const size_t numRows = table.NumRows();
+
+    std::vector<std::string> columnNames;
+    for (size_t column : columns) {
+        columnNames.push_back(table.columnNames[column]);
+    }
+    std::vector<Values> rows(numRows, Values(columns.size()));
+    for (size_t d = 0; d < columns.size(); ++d) {
+        const std::vector<float> &values = table.columns[columns[d]];
+        for (size_t row = 0; row < numRows; ++row) {
+            rows[row][d] = std::isfinite(values[row]) ? values[row] : 0.f;
+        }
+    }
+
+    // Components fitted to a corpus that is now mostly gone no longer
+    // spread the slices out, so they are fitted again.
+    size_t numNew = 0;
+    for (const Values &row : rows) {
+        numNew += mProjections.count(row) ? 0 : 1;
+    }
+    if (!mPCA || columnNames != mColumnNames || numNew * 2 > numRows) {
+        mColumnNames = columnNames;
+        Fit(rows);
+    }
+
+    std::map<Values, Projection> projections;
+    for (const Values &row : rows) {
+        if (projections.count(row))
+            continue;
+        auto found = mProjections.find(row);
+        projections.emplace(row, found != mProjections.end()
+                                     ? found->second
+                                     : Project(row));
+    }
+    mProjections = std::move(projections);
+
+    double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0;
+    for (size_t row = 0; row < numRows; ++row) {
+        const Projection &projection = mProjections[rows[row]];
+        minX = row ? std::min(minX, projection.x) : projection.x;
+        maxX = row ? std::max(maxX, projection.x) : projection.x;
+        minY = row ? std::min(minY, projection.y) : projection.y;
+        maxY = row ? std::max(maxY, projection.y) : projection.y;
+    }
+    mPoints.assign(numRows, Point{});
+    for (size_t row = 0; row < numRows; ++row) {
+        const Projection &projection = mProjections[rows[row]];
+        if (maxX > minX)
+            mPoints[row].x =
+                static_cast<float>((projection.x - minX) / (maxX - minX));
+        if (maxY > minY)
+            mPoints[row].y =
+                static_cast<float>((projection.y - minY) / (maxY - minY));
+    }
+}
+
+void SliceMap::Fit(const std::vector<Values> &rows) {
+    mPCA.reset();
+    mProjections.clear();
+
+    const fluid::index numRows = static_cast<fluid::index>(rows.size());
+    const fluid::index numDims =
+        rows.empty() ? 0 : static_cast<fluid::index>(rows.front().size());
+    mMeans.assign(numDims, 0.0);
+    mScales.assign(numDims, 1.0);
+    if (numRows < 2 || !numDims)
+        return;
+
+    for (fluid::index d = 0; d < numDims; ++d) {
+        double mean = 0.0;
+        for (const Values &row : rows) {
+            mean += row[d];
+        }
+        mean /= numRows;
+        double variance = 0.0;
+        for (const Values &row : rows) {
+            variance += (row[d] - mean) * (row[d] - mean);
+        }
+        const double deviation = std::sqrt(variance / numRows);
+        mMeans[d] = mean;
+        mScales[d] = deviation > 0.0 ? 1.0 / deviation : 1.0;
+    }
+
+    fluid::RealMatrix points(numRows, numDims);
+    for (fluid::index row = 0; row < numRows; ++row) {
+        for (fluid::index d = 0; d < numDims; ++d) {
+            points(row, d) = (rows[row][d] - mMeans[d]) * mScales[d];
+        }
+    }
+    mPCA = std::make_unique<fluid::algorithm::PCA>();
+    mPCA->init(points);
+}
+
+SliceMap::Projection SliceMap::Project(const Values &values) const {
+    Projection projection;
+    const fluid::index numDims = static_cast<fluid::index>(values.size());
+    if (!mPCA || numDims != static_cast<fluid::index>(mMeans.size()))
+        return projection;
+
+    const fluid::index numComponents = std::min(kMapDims, numDims);
+    fluid::RealVector input(numDims);
+    fluid::RealVector output(numComponents);
+    for (fluid::index d = 0; d < numDims; ++d) {
+        input(d) = (values[d] - mMeans[d]) * mScales[d];
+    }
+    mPCA->processFrame(input, output, numComponents);
+    projection.x = output(0);
+    projection.y = numComponents > 1 ? output(1) : 0.0;
+    return projection;
+}
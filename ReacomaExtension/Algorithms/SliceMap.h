@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/PCA.hpp"
+#include "SliceCorpus.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A two-dimensional layout of the slices in a corpus: the first two
+// principal components of their standardised descriptor means. Projections
+// are kept per slice, so a corpus that gained or lost a few slices only has
+// its new slices projected onto the components already fitted.
+class SliceMap {
+  public:
+    // Scaled to [0, 1] over the whole map.
+    struct Point {
+        float x = 0.5f;
+        float y = 0.5f;
+    };
+
+    SliceMap();
+    ~SliceMap();
+
+    // Points follow the rows of the corpus.
+    void Update(const SliceCorpus &corpus);
+    const std::vector<Point> &GetPoints() const { return mPoints; }
+
+  private:
+    // A slice is known by its descriptor means, which stay the same however
+    // its item is moved and change whenever its table is rewritten.
+    using Values = std::vector<float>;
+    struct Projection {
+        double x = 0.0;
+        double y = 0.0;
+    };
+
+    void Fit(const std::vector<Values> &rows);
+    Projection Project(const Values &values) const;
+
+    std::unique_ptr<fluid::algorithm::PCA> mPCA;
+    std::vector<std::string> mColumnNames;
+    std::vector<double> mMeans;
+    std::vector<double> mScales;
+    std::map<Values, Projection> mProjections;
+    std::vector<Point> mPoints;
+};
@@ -0,0 +1,57 @@
+#include "SliceMapping.h"
+
+#include <algorithm>
+#include <cmath>
+
+SliceMapping::Positions
+SliceMapping::Map(const std::vector<fluid::index> &slices) const {
+    Positions positions;
+    if (sampleRate <= 0 || playrate <= 0.0)
+        return positions;
+
+    const double framesPerItemSecond = sampleRate * playrate;
+    const fluid::index endFrame =
+        takeStartFrame +
+        static_cast<fluid::index>(std::ceil(itemLength * framesPerItemSecond));
+
+    auto first =
+        std::upper_bound(slices.begin(), slices.end(), takeStartFrame);
+    auto last = std::lower_bound(first, slices.end(), endFrame);
+    std::vector<fluid::index> visible(first, last);
+    EnforceMinGap(visible, std::llround(minGap * framesPerItemSecond));
+
+    const size_t count = visible.size();
+    positions.sourceTimes.resize(count);
+    positions.itemTimes.resize(count);
+    const double secondsPerFrame = 1.0 / sampleRate;
+    const double itemSecondsPerFrame = 1.0 / framesPerItemSecond;
+    for (size_t i = 0; i < count; ++i) {
+        positions.sourceTimes[i] = visible[i] * secondsPerFrame;
+        positions.itemTimes[i] =
+            (visible[i] - takeStartFrame) * itemSecondsPerFrame;
+    }
+    return positions;
+}
+
+void SliceMapping::EnforceMinGap(std::vector<fluid::index> &slices,
+                                 fluid::index minGap,
+                                 std::vector<float> *strengths) {
+    if (minGap <= 1 || slices.empty())
+        return;
+
+    const bool withStrengths = strengths && strengths->size() == slices.size();
+    size_t kept = 1;
+    for (size_t i = 1; i < slices.size(); ++i) {
+        if (slices[i] - slices[kept - 1] >= minGap) {
+            slices[kept] = slices[i];
+            if (withStrengths) {
+                (*strengths)[kept] = (*strengths)[i];
+            }
+            ++kept;
+        }
+    }
+    slices.resize(kept);
+    if (withStrengths) {
+        strengths->resize(kept);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+
+#include <vector>
+
+// Turns slices, as sorted absolute source frames, into positions on one
+// item. Everything here works on whole arrays and makes no REAPER calls, so
+// it runs before any marker is touched.
+struct SliceMapping {
+    // Source frame the item starts at, its length in seconds and the take's
+    // playrate.
+    fluid::index takeStartFrame = 0;
+    double itemLength = 0.0;
+    double playrate = 1.0;
+    int sampleRate = 0;
+    // Slices closer than this to the slice kept before them, in seconds of
+    // item time, are dropped.
+    double minGap = 0.0;
+
+    struct Positions {
+        // Take markers are placed in source time.
+        std::vector<double> sourceTimes;
+        // Seconds from the start of the item, as the project sees them.
+        std::vector<double> itemTimes;
+    };
+
+    // Keeps the slices strictly inside the item.
+    Positions Map(const std::vector<fluid::index> &slices) const;
+
+    // Reads the slices out of an analysis output, which the clients pad with
+    // zeros and -1. Strengths are read alongside when given.
+    template <typename View>
+    static void CollectPositive(const View &values,
+                                std::vector<fluid::index> &slices,
+                                const View *strengths = nullptr,
+                                std::vector<float> *strengthsOut = nullptr) {
+        const fluid::index count = values.size();
+        slices.reserve(slices.size() + count);
+        for (fluid::index i = 0; i < count; ++i) {
+            if (values(i) > 0) {
+                slices.push_back(static_cast<fluid::index>(values(i)));
+                if (strengths && strengthsOut) {
+                    strengthsOut->push_back((*strengths)(i));
+                }
+            }
+        }
+    }
+
+    // Drops every slice closer than minGap frames to the one kept before it,
+    // along with its strength when strengths are given.
+    static void EnforceMinGap(std::vector<fluid::index> &slices,
+                              fluid::index minGap,
+                              std::vector<float> *strengths = nullptr);
+};
@@ -0,0 +1,243 @@
+#include "Spectrogram.h"
+#include "../../dependencies/flucoma-core/include/flucoma/algorithms/public/STFT.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+
+using namespace fluid;
+
+bool SpectrogramKey::operator==(const SpectrogramKey &other) const {
+    return source == other.source && startFrame == other.startFrame &&
+           frameCount == other.frameCount && windowSize == other.windowSize &&
+           hopSize == other.hopSize && fftSize == other.fftSize &&
+           summed == other.summed;
+}
+
+void STFTFraming::ReadFrame(FluidTensorView<const float, 1> samples,
+                            index frame, RealVectorView window) const {
+    const index start = FrameStart(frame);
+    const index numSamples = samples.size();
+    for (index i = 0; i < windowSize; ++i) {
+        const index sample = start + i;
+        window(i) = sample >= 0 && sample < numSamples ? samples(sample) : 0.0;
+    }
+}
+
+// Frame by frame, so that only one frame's complex spectrum is ever held,
+// checking the token once per block of frames.
+Spectrogram::Spectrogram(const client::BufferAdaptor *source,
+                         const SpectrogramKey &key,
+                         const CancellationToken &token) {
+    constexpr index framesPerBlock = 64;
+
+    client::BufferAdaptor::ReadAccess reader(source);
+    if (!reader.exists() || !reader.valid())
+        return;
+
+    const STFTFraming framing{key.windowSize, key.hopSize, key.fftSize};
+    const index numChannels = reader.numChans();
+    mNumFrames = framing.NumFrames(reader.numFrames());
+    mNumBins = framing.NumBins();
+    for (index c = 0; c < (key.summed ? 1 : numChannels); ++c) {
+        mChannels.emplace_back(mNumFrames, mNumBins);
+    }
+
+    algorithm::STFT stft(key.windowSize, key.fftSize, key.hopSize);
+    RealVector window(key.windowSize);
+    RealVector channelWindow(key.windowSize);
+    ComplexVector spectrum(mNumBins);
+    auto transform = [&](index channel, index frame) {
+        stft.processFrame(window, spectrum);
+        for (index bin = 0; bin < mNumBins; ++bin) {
+            mChannels[channel](frame, bin) =
+                static_cast<float>(std::abs(spectrum(bin)));
+        }
+    };
+
+    for (index frame = 0; frame < mNumFrames; ++frame) {
+        if (frame % framesPerBlock == 0 && token.IsCancelled()) {
+            mChannels.clear();
+            mNumFrames = 0;
+            mCancelled = true;
+            return;
+        }
+        if (key.summed) {
+            framing.ReadFrame(reader.samps(0), frame, window);
+            for (index c = 1; c < numChannels; ++c) {
+                framing.ReadFrame(reader.samps(c), frame, channelWindow);
+                for (index i = 0; i < key.windowSize; ++i) {
+                    window(i) += channelWindow(i);
+                }
+            }
+            transform(0, frame);
+            continue;
+        }
+        for (index c = 0; c < numChannels; ++c) {
+            framing.ReadFrame(reader.samps(c), frame, window);
+            transform(c, frame);
+        }
+    }
+}
+
+index Spectrogram::EffectiveFFTSize(index windowSize, index fftSize) {
+    index size = 1;
+    while (size < std::max(windowSize, fftSize)) {
+        size <<= 1;
+    }
+    return size;
+}
+
+size_t Spectrogram::SizeInBytes(const SpectrogramKey &key,
+                                index numChannels) {
+    const STFTFraming framing{key.windowSize, key.hopSize, key.fftSize};
+    return static_cast<size_t>((key.summed ? 1 : numChannels) *
+                               framing.NumFrames(key.frameCount) *
+                               framing.NumBins()) *
+           sizeof(float);
+}
+
+size_t Spectrogram::SizeInBytes() const {
+    return mChannels.size() * static_cast<size_t>(mNumFrames * mNumBins) *
+           sizeof(float);
+}
+
+OverlapAdd::OverlapAdd(const STFTFraming &framing, index numSamples)
+    : mFraming(framing), mNumSamples(numSamples),
+      mWindowGain(framing.windowSize) {
+    algorithm::STFT stft(framing.windowSize, framing.fftSize,
+                         framing.hopSize);
+    algorithm::ISTFT istft(framing.windowSize, framing.fftSize,
+                           framing.hopSize);
+    RealVector ones(framing.windowSize);
+    RealVector gain(framing.windowSize);
+    ComplexVector spectrum(framing.NumBins());
+    for (index i = 0; i < framing.windowSize; ++i) {
+        ones(i) = 1.0;
+    }
+    stft.processFrame(ones, spectrum);
+    istft.processFrame(spectrum, gain);
+    for (index i = 0; i < framing.windowSize; ++i) {
+        mWindowGain[i] = gain(i);
+    }
+}
+
+void OverlapAdd::Add(index frame, FluidTensorView<const double, 1> audio,
+                     FluidTensorView<float, 1> output) const {
+    const index start = mFraming.FrameStart(frame);
+    const index first = std::max<index>(0, -start);
+    const index end = std::min(mFraming.windowSize, mNumSamples - start);
+    for (index i = first; i < end; ++i) {
+        output(start + i) += static_cast<float>(audio(i));
+    }
+}
+
+void OverlapAdd::Finish(FluidTensorView<float, 1> output) const {
+    const index hop = mFraming.hopSize;
+    const index lastFrame = mFraming.NumFrames(mNumSamples) - 1;
+    for (index sample = 0; sample < mNumSamples; ++sample) {
+        // Frames whose window starts at or before the sample and ends after.
+        const index before = sample + mFraming.Padding() - mFraming.windowSize;
+        const index firstFrame = before < 0 ? 0 : before / hop + 1;
+        const index endFrame =
+            std::min(lastFrame, (sample + mFraming.Padding()) / hop) + 1;
+        double gain = 0.0;
+        for (index frame = firstFrame; frame < endFrame; ++frame) {
+            gain += mWindowGain[sample - mFraming.FrameStart(frame)];
+        }
+        if (gain > 1e-9) {
+            output(sample) = static_cast<float>(output(sample) / gain);
+        }
+    }
+}
+
+SpectrogramCache::SpectrogramCache(size_t maxBytes) : mMaxBytes(maxBytes) {}
+
+std::shared_ptr<const Spectrogram>
+SpectrogramCache::GetOrCompute(const SpectrogramKey &key,
+                               const client::BufferAdaptor *source,
+                               const CancellationToken &token) {
+    index numChannels = 0;
+    {
+        client::BufferAdaptor::ReadAccess reader(source);
+        if (reader.exists() && reader.valid())
+            numChannels = reader.numChans();
+    }
+    if (Spectrogram::SizeInBytes(key, numChannels) > mMaxBytes) {
+        auto spectrogram =
+            std::make_shared<const Spectrogram>(source, key, token);
+        return spectrogram->Cancelled() ? nullptr : spectrogram;
+    }
+
+    // A computation cancelled by someone else leaves null behind it; as
+    // long as this caller is not cancelled too, it tries again.
+    while (!token.IsCancelled()) {
+        auto spectrogram = Find(key, source, token);
+        if (spectrogram)
+            return spectrogram;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const Spectrogram>
+SpectrogramCache::Find(const SpectrogramKey &key,
+                       const client::BufferAdaptor *source,
+                       const CancellationToken &token) {
+    std::promise<std::shared_ptr<const Spectrogram>> promise;
+    SharedSpectrogram spectrogram;
+    bool computeHere = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = std::find_if(
+            mEntries.begin(), mEntries.end(),
+            [&key](const auto &entry) { return entry.first == key; });
+        if (it != mEntries.end()) {
+            mEntries.splice(mEntries.begin(), mEntries, it);
+            spectrogram = it->second;
+        } else {
+            spectrogram = promise.get_future().share();
+            mEntries.emplace_front(key, spectrogram);
+            computeHere = true;
+        }
+    }
+
+    if (computeHere) {
+        std::shared_ptr<const Spectrogram> computed =
+            std::make_shared<const Spectrogram>(source, key, token);
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (computed->Cancelled()) {
+            mEntries.remove_if([&key](const auto &entry) {
+                return entry.first == key;
+            });
+            computed = nullptr;
+        }
+        promise.set_value(computed);
+        EvictLocked();
+    }
+
+    return spectrogram.get();
+}
+
+void SpectrogramCache::Clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+}
+
+// Every entry fits the cache on its own, so the most recently used one is
+// always kept.
+void SpectrogramCache::EvictLocked() {
+    size_t totalBytes = 0;
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        const bool ready = it->second.wait_for(std::chrono::seconds(0)) ==
+                           std::future_status::ready;
+        if (ready) {
+            const size_t bytes = it->second.get()->SizeInBytes();
+            if (totalBytes + bytes > mMaxBytes) {
+                it = mEntries.erase(it);
+                continue;
+            }
+            totalBytes += bytes;
+        }
+        ++it;
+    }
+}
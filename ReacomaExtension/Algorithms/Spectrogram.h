@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../../dependencies/flucoma-core/include/flucoma/clients/common/BufferAdaptor.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidIndex.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/data/FluidTensor.hpp"
+#include "../../dependencies/flucoma-core/include/flucoma/data/TensorTypes.hpp"
+#include "CancellationToken.h"
+
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SpectrogramKey {
+    std::string source;
+    fluid::index startFrame = 0;
+    fluid::index frameCount = 0;
+    fluid::index windowSize = 0;
+    fluid::index hopSize = 0;
+    fluid::index fftSize = 0;
+    // The channels are summed before the transform, as the FluCoMa slicers
+    // do with multichannel sources.
+    bool summed = false;
+
+    bool operator==(const SpectrogramKey &other) const;
+};
+
+// Where the frames of a spectrogram fall: where a FluCoMa client streaming
+// the audio cuts them. The first window ends one hop into the audio, so
+// windowSize - hopSize samples of silence come before it, and frames carry
+// on until the last sample has passed through a whole window. Samples
+// outside the audio read as silence.
+struct STFTFraming {
+    fluid::index windowSize = 0;
+    fluid::index hopSize = 0;
+    fluid::index fftSize = 0;
+
+    fluid::index Padding() const { return windowSize - hopSize; }
+    fluid::index NumFrames(fluid::index numSamples) const {
+        return (numSamples + Padding() - 1) / hopSize + 1;
+    }
+    fluid::index NumBins() const { return fftSize / 2 + 1; }
+    fluid::index FrameStart(fluid::index frame) const {
+        return frame * hopSize - Padding();
+    }
+    fluid::index FrameCentre(fluid::index frame) const {
+        return FrameStart(frame) + windowSize / 2;
+    }
+    void ReadFrame(fluid::FluidTensorView<const float, 1> samples,
+                   fluid::index frame, fluid::RealVectorView window) const;
+};
+
+// Magnitude STFT of every channel of an ingested range, as floats. Each
+// channel is stored frame-major (one contiguous row of bins per hop) so that
+// consumers walking forward in time read memory sequentially. Phase is not
+// kept: consumers that resynthesise transform the audio themselves, frame by
+// frame, with the same framing.
+class Spectrogram {
+  public:
+    using Matrix = fluid::FluidTensor<float, 2>;
+
+    // Stops early if the token is cancelled, leaving a spectrogram that is
+    // Cancelled() and holds no frames.
+    Spectrogram(const fluid::client::BufferAdaptor *source,
+                const SpectrogramKey &key, const CancellationToken &token);
+
+    // FluCoMa rounds FFT sizes up to a power of two that fits the window.
+    static fluid::index EffectiveFFTSize(fluid::index windowSize,
+                                         fluid::index fftSize);
+    static size_t SizeInBytes(const SpectrogramKey &key,
+                              fluid::index numChannels);
+
+    fluid::index NumChannels() const {
+        return static_cast<fluid::index>(mChannels.size());
+    }
+    fluid::index NumFrames() const { return mNumFrames; }
+    fluid::index NumBins() const { return mNumBins; }
+    const Matrix &Channel(fluid::index channel) const {
+        return mChannels[channel];
+    }
+    size_t SizeInBytes() const;
+    bool Cancelled() const { return mCancelled; }
+
+  private:
+    std::vector<Matrix> mChannels;
+    fluid::index mNumFrames = 0;
+    fluid::index mNumBins = 0;
+    bool mCancelled = false;
+};
+
+// Overlap-adds frames resynthesised with ISTFT::processFrame back into a
+// channel cut with the same framing. The analysis and synthesis windows stay
+// on each frame, so Finish() divides every sample by what they add up to
+// over the frames that cover it.
+class OverlapAdd {
+  public:
+    OverlapAdd(const STFTFraming &framing, fluid::index numSamples);
+
+    void Add(fluid::index frame, fluid::FluidTensorView<const double, 1> audio,
+             fluid::FluidTensorView<float, 1> output) const;
+    void Finish(fluid::FluidTensorView<float, 1> output) const;
+
+  private:
+    STFTFraming mFraming;
+    fluid::index mNumSamples;
+    std::vector<double> mWindowGain;
+};
+
+// Shares spectrograms between algorithms run over the same range with the
+// same FFT settings. Safe to use from worker threads: concurrent requests for
+// the same key wait for a single computation. A spectrogram larger than the
+// whole cache is computed for its caller but never kept, and neither is one
+// whose computation was cancelled: anyone waiting on it computes it again.
+class SpectrogramCache {
+  public:
+    explicit SpectrogramCache(size_t maxBytes = size_t(512) << 20);
+
+    // Null if the token was cancelled first.
+    std::shared_ptr<const Spectrogram>
+    GetOrCompute(const SpectrogramKey &key,
+                 const fluid::client::BufferAdaptor *source,
+                 const CancellationToken &token);
+    void Clear();
+
+  private:
+    using SharedSpectrogram =
+        std::shared_future<std::shared_ptr<const Spectrogram>>;
+
+    // One attempt at the cached spectrogram, computing it if nobody else
+    // is; null if that computation was cancelled.
+    std::shared_ptr<const Spectrogram>
+    Find(const SpectrogramKey &key, const fluid::client::BufferAdaptor *source,
+         const CancellationToken &token);
+    void EvictLocked();
+
+    std::mutex mMutex;
+    std::list<std::pair<SpectrogramKey, SharedSpectrogram>> mEntries;
+    size_t mMaxBytes;
+};
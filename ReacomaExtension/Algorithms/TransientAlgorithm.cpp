@@ -5,7 +5,7 @@
 TransientAlgorithm::TransientAlgorithm(ReacomaExtension *apiProvider)
     : AudioOutputAlgorithm<NRTThreadedTransientsClient>(apiProvider) {}
 
-TransientAlgorithm::~TransientAlgorithm() = default;
+TransientAlgorithm::~TransientAlgorithm() { Shutdown(); }
 
 void TransientAlgorithm::RegisterParameters() {
     mBaseParamIdx = mApiProvider->NParams();
@@ -33,15 +33,14 @@ void TransientAlgorithm::RegisterParameters() {
 bool TransientAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
                                    int numChannels, int frameCount,
                                    int sampleRate) {
-    auto order = mApiProvider->GetParam(mBaseParamIdx + kOrder)->Value();
-    auto blockSize =
-        mApiProvider->GetParam(mBaseParamIdx + kBlockSize)->Value();
-    auto padding = mApiProvider->GetParam(mBaseParamIdx + kPadding)->Value();
-    auto skew = mApiProvider->GetParam(mBaseParamIdx + kSkew)->Value();
-    auto fwd = mApiProvider->GetParam(mBaseParamIdx + kThreshFwd)->Value();
-    auto bwd = mApiProvider->GetParam(mBaseParamIdx + kThreshBack)->Value();
-    auto winSize = mApiProvider->GetParam(mBaseParamIdx + kWinSize)->Value();
-    auto clumpLength = mApiProvider->GetParam(mBaseParamIdx + kClump)->Value();
+    auto order = GetParamValue(kOrder);
+    auto blockSize = GetParamValue(kBlockSize);
+    auto padding = GetParamValue(kPadding);
+    auto skew = GetParamValue(kSkew);
+    auto fwd = GetParamValue(kThreshFwd);
+    auto bwd = GetParamValue(kThreshBack);
+    auto winSize = GetParamValue(kWinSize);
+    auto clumpLength = GetParamValue(kClump);
 
     auto transMemoryBuffer = std::make_shared<MemoryBufferAdaptor>(
         numChannels, frameCount, sampleRate);
@@ -85,6 +84,23 @@ bool TransientAlgorithm::HandleResults(MediaItem *item, MediaItem_Take *take,
     return true;
 }
 
+void TransientAlgorithm::ReleaseResults() {
+    mParams.template set<5>(BufferT::type(), nullptr);
+    mParams.template set<6>(BufferT::type(), nullptr);
+}
+
+BufferT::type TransientAlgorithm::FindOutput(const std::string &name) {
+    if (name == "transients")
+        return mParams.template get<5>();
+    if (name == "residual")
+        return mParams.template get<6>();
+    return nullptr;
+}
+
+std::vector<std::string> TransientAlgorithm::GetAudioOutputNames() const {
+    return {"transients", "residual"};
+}
+
 const char *TransientAlgorithm::GetName() const {
     return "Transient Separation";
 }
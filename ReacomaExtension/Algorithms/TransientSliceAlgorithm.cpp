@@ -3,9 +3,9 @@
 #include "ReacomaExtension.h"
 
 TransientSliceAlgorithm::TransientSliceAlgorithm(ReacomaExtension *apiProvider)
-    : FlucomaAlgorithm<NRTThreadedTransientSliceClient>(apiProvider) {}
+    : SlicerAlgorithm<NRTThreadedTransientSliceClient>(apiProvider) {}
 
-TransientSliceAlgorithm::~TransientSliceAlgorithm() = default;
+TransientSliceAlgorithm::~TransientSliceAlgorithm() { Shutdown(); }
 
 void TransientSliceAlgorithm::RegisterParameters() {
     mBaseParamIdx = mApiProvider->NParams();
@@ -40,17 +40,15 @@ bool TransientSliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
         std::make_shared<MemoryBufferAdaptor>(1, estimatedSlices, sampleRate);
     auto slicesOutputBuffer = fluid::client::BufferT::type(outBuffer);
 
-    auto order = mApiProvider->GetParam(mBaseParamIdx + kOrder)->Value();
-    auto blockSize =
-        mApiProvider->GetParam(mBaseParamIdx + kBlockSize)->Value();
-    auto padding = mApiProvider->GetParam(mBaseParamIdx + kPadding)->Value();
-    auto skew = mApiProvider->GetParam(mBaseParamIdx + kSkew)->Value();
-    auto fwd = mApiProvider->GetParam(mBaseParamIdx + kThreshFwd)->Value();
-    auto bwd = mApiProvider->GetParam(mBaseParamIdx + kThreshBack)->Value();
-    auto winSize = mApiProvider->GetParam(mBaseParamIdx + kWinSize)->Value();
-    auto clumpLength = mApiProvider->GetParam(mBaseParamIdx + kClump)->Value();
-    auto minSliceLength =
-        mApiProvider->GetParam(mBaseParamIdx + kMinSliceLength)->Value();
+    auto order = GetParamValue(kOrder);
+    auto blockSize = GetParamValue(kBlockSize);
+    auto padding = GetParamValue(kPadding);
+    auto skew = GetParamValue(kSkew);
+    auto fwd = GetParamValue(kThreshFwd);
+    auto bwd = GetParamValue(kThreshBack);
+    auto winSize = GetParamValue(kWinSize);
+    auto clumpLength = GetParamValue(kClump);
+    auto minSliceLength = GetParamValue(kMinSliceLength);
 
     mParams.template set<0>(std::move(sourceBuffer), nullptr);
     mParams.template set<1>(LongT::type(0), nullptr);
@@ -75,32 +73,12 @@ bool TransientSliceAlgorithm::DoProcess(InputBufferT::type &sourceBuffer,
     return result.ok();
 }
 
-bool TransientSliceAlgorithm::HandleResults(MediaItem *item,
-                                            MediaItem_Take *take,
-                                            int numChannels, int sampleRate) {
-    auto processedSlicesBuffer = mParams.template get<5>();
-    BufferAdaptor::ReadAccess reader(processedSlicesBuffer.get());
-
-    if (!reader.exists() || !reader.valid())
-        return false;
-
-    int markerCount = GetNumTakeMarkers(take);
-    for (int i = markerCount - 1; i >= 0; i--) {
-        DeleteTakeMarker(take, i);
-    }
-
-    double itemLength = GetMediaItemInfo_Value(item, "D_LENGTH");
-    auto view = reader.samps(0);
-    for (fluid::index i = 0; i < view.size(); i++) {
-        if (view(i) > 0) {
-            double markerTimeInSeconds =
-                static_cast<double>(view(i)) / sampleRate;
-            if (markerTimeInSeconds < itemLength) {
-                SetTakeMarker(take, -1, "", &markerTimeInSeconds, nullptr);
-            }
-        }
-    }
-    return true;
+fluid::index TransientSliceAlgorithm::GetContextFrames() const {
+    auto param = [this](int idx) {
+        return static_cast<fluid::index>(GetParamValue(idx));
+    };
+    return param(kOrder) + param(kBlockSize) + 2 * param(kPadding) +
+           param(kWinSize) + param(kClump) + param(kMinSliceLength);
 }
 
 const char *TransientSliceAlgorithm::GetName() const {
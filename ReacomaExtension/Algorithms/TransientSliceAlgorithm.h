@@ -3,7 +3,7 @@
 #include "FlucomaAlgorithmBase.h"
 
 class TransientSliceAlgorithm
-    : public FlucomaAlgorithm<fluid::client::NRTThreadedTransientSliceClient> {
+    : public SlicerAlgorithm<fluid::client::NRTThreadedTransientSliceClient> {
   public:
     enum Params {
         kOrder = 0,
@@ -28,6 +28,5 @@ class TransientSliceAlgorithm
   protected:
     bool DoProcess(InputBufferT::type &sourceBuffer, int numChannels,
                    int frameCount, int sampleRate) override;
-    bool HandleResults(MediaItem *item, MediaItem_Take *take, int numChannels,
-                       int sampleRate) override;
+    fluid::index GetContextFrames() const override;
 };
@@ -27,6 +27,11 @@ class ReacomaProgressBar : public IControl {
 
         std::stringstream ss;
         ss << std::fixed << std::setprecision(1) << (mProgress * 100.0) << "%";
+        if (mRemainingSeconds >= 0.0) {
+            const int seconds = static_cast<int>(mRemainingSeconds + 0.5);
+            ss << " - " << seconds / 60 << ":" << std::setw(2)
+               << std::setfill('0') << seconds % 60 << " left";
+        }
         std::string progressStr = ss.str();
 
         g.DrawText(mTextStyle, progressStr.c_str(), mRECT);
@@ -41,6 +46,12 @@ class ReacomaProgressBar : public IControl {
         SetDirty(false);
     }
 
+    // A negative value hides the estimate.
+    void SetRemainingSeconds(double seconds) {
+        mRemainingSeconds = seconds;
+        SetDirty(false);
+    }
+
     void SetColors(const IColor &track, const IColor &fill, const IColor &frame,
                    const IColor &text) {
         mTrackColor = track;
@@ -52,6 +63,7 @@ class ReacomaProgressBar : public IControl {
 
   private:
     double mProgress;
+    double mRemainingSeconds = -1.0;
     WDL_String mLabel;
 
     IText mTextStyle =
@@ -0,0 +1,86 @@
+#include "ReacomaSliceMap.h"
+
+namespace {
+constexpr float kPointSize = 2.f;
+constexpr float kHighlightRadius = 4.f;
+// How far from a point a click may land and still pick it.
+constexpr float kPickRadius = 6.f;
+} // namespace
+
+ReacomaSliceMap::ReacomaSliceMap(const IRECT &bounds,
+                                 PickFunction pickFunction)
+    : IControl(bounds), mPickFunction(std::move(pickFunction)) {}
+
+void ReacomaSliceMap::Draw(IGraphics &g) {
+    if (!g.CheckLayer(mLayer)) {
+        g.StartLayer(this, mRECT);
+        g.FillRect(mBackgroundColor, mRECT);
+        g.PathClear();
+        const float half = kPointSize / 2.f;
+        for (const IVec2 &point : mPoints) {
+            const IVec2 screen = ToScreen(point);
+            g.PathRect(IRECT(screen.x - half, screen.y - half,
+                             screen.x + half, screen.y + half));
+        }
+        g.PathFill(mPointColor);
+        g.DrawRect(mFrameColor, mRECT);
+        mLayer = g.EndLayer();
+    }
+    g.DrawLayer(mLayer, &mBlend);
+
+    if (mPoints.empty()) {
+        g.DrawText(mTextStyle, "No described slices", mRECT);
+    } else if (mHighlight >= 0 &&
+               mHighlight < static_cast<int>(mPoints.size())) {
+        const IVec2 screen = ToScreen(mPoints[mHighlight]);
+        g.FillCircle(mHighlightColor, screen.x, screen.y, kHighlightRadius);
+    }
+
+    if (IsDisabled()) {
+        g.FillRect(COLOR_GRAY.WithOpacity(0.7f), mRECT, &BLEND_75);
+    }
+}
+
+void ReacomaSliceMap::OnMouseDown(float x, float y, const IMouseMod &mod) {
+    int nearest = -1;
+    float nearestDistance = kPickRadius * kPickRadius;
+    for (size_t i = 0; i < mPoints.size(); ++i) {
+        const IVec2 screen = ToScreen(mPoints[i]);
+        const float dx = screen.x - x;
+        const float dy = screen.y - y;
+        if (dx * dx + dy * dy <= nearestDistance) {
+            nearestDistance = dx * dx + dy * dy;
+            nearest = static_cast<int>(i);
+        }
+    }
+    if (nearest < 0)
+        return;
+
+    SetHighlight(nearest);
+    if (mPickFunction)
+        mPickFunction(nearest);
+}
+
+void ReacomaSliceMap::OnResize() { InvalidateLayer(); }
+
+void ReacomaSliceMap::SetPoints(std::vector<IVec2> points) {
+    mPoints = std::move(points);
+    mHighlight = -1;
+    InvalidateLayer();
+}
+
+void ReacomaSliceMap::SetHighlight(int point) {
+    mHighlight = point;
+    SetDirty(false);
+}
+
+IVec2 ReacomaSliceMap::ToScreen(const IVec2 &point) const {
+    const IRECT plot = mRECT.GetPadded(-kHighlightRadius);
+    return IVec2(plot.L + point.x * plot.W(), plot.B - point.y * plot.H());
+}
+
+void ReacomaSliceMap::InvalidateLayer() {
+    if (mLayer)
+        mLayer->Invalidate();
+    SetDirty(false);
+}
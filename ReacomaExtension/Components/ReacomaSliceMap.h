@@ -0,0 +1,44 @@
+#pragma once
+
+#include "IControl.h"
+#include "IGraphics.h"
+#include "IGraphicsStructs.h"
+
+#include <functional>
+#include <vector>
+
+using namespace iplug::igraphics;
+
+// A scatter plot of points in [0, 1], clicked to pick one. All points go
+// into one path drawn to a layer that is kept until the points change, so a
+// frame of a large map costs a single blit.
+class ReacomaSliceMap : public IControl {
+  public:
+    // Called with the index of the point clicked.
+    using PickFunction = std::function<void(int)>;
+
+    ReacomaSliceMap(const IRECT &bounds, PickFunction pickFunction);
+
+    void Draw(IGraphics &g) override;
+    void OnMouseDown(float x, float y, const IMouseMod &mod) override;
+    void OnResize() override;
+
+    void SetPoints(std::vector<IVec2> points);
+    // A negative index clears the highlight.
+    void SetHighlight(int point);
+
+  private:
+    IVec2 ToScreen(const IVec2 &point) const;
+    void InvalidateLayer();
+
+    std::vector<IVec2> mPoints;
+    PickFunction mPickFunction;
+    ILayerPtr mLayer;
+    int mHighlight = -1;
+
+    IColor mBackgroundColor = COLOR_WHITE;
+    IColor mPointColor = COLOR_BLACK.WithOpacity(0.5f);
+    IColor mHighlightColor = COLOR_RED;
+    IColor mFrameColor = COLOR_BLACK;
+    IText mTextStyle = IText(14.f, COLOR_GRAY, "ibmplex");
+};
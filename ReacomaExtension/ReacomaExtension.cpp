@@ -3,10 +3,10 @@
 #include "ReacomaExtension.h"
 #include "ReaperExt_include_in_plug_src.h"
 
-#include <algorithm>
-#include <deque>
 
+#include "Algorithms/Pipeline.h"
 #include "Algorithms/ProcessingJob.h"
+#include "Algorithms/ScriptApi.h"
 #include "Components/ReacomaButton.h"
 #include "Components/ReacomaParamTextControl.h"
 #include "Components/ReacomaProgressBar.h"
@@ -14,6 +14,51 @@
 
 #include "IControls.h"
 
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// Resolution of the detection curves written to slice sidecars, in points
+// per second. Each point holds the highest value of its span, so peaks
+// survive the decimation.
+constexpr double kSliceCurveRate = 100.0;
+
+// How often the slice map looks for rewritten tables while the project
+// stays unchanged.
+constexpr std::chrono::milliseconds kMapTableCheckInterval{250};
+
+// Names are kept in static storage because REAPER holds on to them for as
+// long as the actions stay registered.
+struct AlgorithmAction {
+    const char *name;
+    ReacomaExtension::EAlgorithmChoice choice;
+    ReacomaExtension::Mode mode;
+};
+
+const AlgorithmAction kAlgorithmActions[] = {
+    {"Reacoma: Novelty Slice selected items", ReacomaExtension::kNoveltySlice,
+     ReacomaExtension::Mode::Segment},
+    {"Reacoma: Onset Slice selected items", ReacomaExtension::kOnsetSlice,
+     ReacomaExtension::Mode::Segment},
+    {"Reacoma: Transient Slice selected items",
+     ReacomaExtension::kTransientSlice, ReacomaExtension::Mode::Segment},
+    {"Reacoma: Amp Slice selected items", ReacomaExtension::kAmpSlice,
+     ReacomaExtension::Mode::Segment},
+    {"Reacoma: Amp Gate selected items", ReacomaExtension::kAmpGate,
+     ReacomaExtension::Mode::Segment},
+    {"Reacoma: HPSS selected items", ReacomaExtension::kHPSS,
+     ReacomaExtension::Mode::ProcessAudio},
+    {"Reacoma: NMF selected items", ReacomaExtension::kNMF,
+     ReacomaExtension::Mode::ProcessAudio},
+    {"Reacoma: Transients selected items", ReacomaExtension::kTransients,
+     ReacomaExtension::Mode::ProcessAudio},
+    {"Reacoma: Sines selected items", ReacomaExtension::kSines,
+     ReacomaExtension::Mode::ProcessAudio},
+    {"Reacoma: Describe slices of selected items",
+     ReacomaExtension::kDescribe, ReacomaExtension::Mode::Segment},
+};
+} // namespace
+
 template <ReacomaExtension::Mode M> struct ProcessAction {
     void operator()(IControl *pCaller) {
         static_cast<ReacomaExtension *>(pCaller->GetDelegate())
@@ -40,6 +85,7 @@ ReacomaExtension::ReacomaExtension(reaper_plugin_info_t *pRec)
     IMPAPI(SplitMediaItem);
     IMPAPI(DeleteTrackMediaItem);
     IMPAPI(SetTakeMarker);
+    IMPAPI(GetTakeMarker);
     IMPAPI(AddProjectMarker2);
     IMPAPI(GetMediaItem_Track);
     IMPAPI(Undo_BeginBlock2);
@@ -59,6 +105,19 @@ ReacomaExtension::ReacomaExtension(reaper_plugin_info_t *pRec)
     IMPAPI(GetProjectPathEx);
     IMPAPI(GetSetProjectInfo_String);
     IMPAPI(SetMediaItemInfo_Value);
+    IMPAPI(SetMediaItemTakeInfo_Value);
+    IMPAPI(plugin_register);
+    IMPAPI(ValidatePtr2);
+    IMPAPI(PreventUIRefresh);
+    IMPAPI(GetCursorPosition);
+    IMPAPI(GetSetMediaTrackInfo_String);
+    IMPAPI(SelectAllMediaItems);
+    IMPAPI(SetMediaItemSelected);
+    IMPAPI(SetEditCurPos);
+    IMPAPI(GetProjectStateChangeCount);
+    IMPAPI(Audio_RegHardwareHook);
+
+    mProcessingService = std::make_unique<ProcessingService>();
 
     mMakeGraphicsFunc = [&]() {
         return MakeGraphics(*this, PLUG_WIDTH, PLUG_HEIGHT, PLUG_FPS);
@@ -72,6 +131,43 @@ ReacomaExtension::ReacomaExtension(reaper_plugin_info_t *pRec)
         },
         true, &mGUIToggle);
 
+    for (const AlgorithmAction &action : kAlgorithmActions) {
+        RegisterAction(action.name, [this, &action]() {
+            ProcessAlgorithm(action.choice, action.mode);
+        });
+    }
+    for (const PipelineDefinition &pipeline : GetBuiltinPipelines()) {
+        RegisterAction(pipeline.name,
+                       [this, &pipeline]() { ProcessPipeline(pipeline); });
+    }
+    RegisterAction("Reacoma: Compare slicers", [this]() { CompareSlicers(); });
+    RegisterAction("Reacoma: Select slices similar to the one at the cursor",
+                   [this]() { SelectSimilarSlices(); });
+    RegisterAction("Reacoma: Map slices of selected items",
+                   [this]() { MapSlices(); });
+    RegisterAction("Reacoma: Colour selected items by slice cluster",
+                   [this]() { ClusterSlices(); });
+    RegisterAction(
+        "Reacoma: Toggle live NMF filtering of playback",
+        [this]() { ToggleLiveNMF(); }, false, &mLiveNMFToggle);
+    RegisterAction(
+        "Reacoma: Toggle writing slices as take markers",
+        [&]() { mWriteTakeMarkers = !mWriteTakeMarkers; }, false,
+        &mWriteTakeMarkers);
+    RegisterAction(
+        "Reacoma: Toggle writing slices to sidecar files",
+        [&]() { mWriteSliceSidecars = !mWriteSliceSidecars; }, false,
+        &mWriteSliceSidecars);
+    RegisterAction(
+        "Reacoma: Toggle JSON view of slice sidecar files",
+        [&]() { mWriteSliceSidecarJson = !mWriteSliceSidecarJson; }, false,
+        &mWriteSliceSidecarJson);
+    RegisterAction(
+        "Reacoma: Toggle detection curves in slice sidecar files",
+        [&]() { mWriteSliceCurves = !mWriteSliceCurves; }, false,
+        &mWriteSliceCurves);
+    RegisterScriptApi(this);
+
     AddParam();
     GetParam(kParamAlgorithmChoice)
         ->InitEnum("Algorithm", kNoveltySlice, kNumAlgorithmChoices);
@@ -79,10 +175,14 @@ ReacomaExtension::ReacomaExtension(reaper_plugin_info_t *pRec)
         ->SetDisplayText(kNoveltySlice, "Novelty Slice");
     GetParam(kParamAlgorithmChoice)->SetDisplayText(kOnsetSlice, "Onset Slice");
     GetParam(kParamAlgorithmChoice)
-        ->SetDisplayText(kTransientSlice, "Transients");
+        ->SetDisplayText(kTransientSlice, "Transient Slice");
     GetParam(kParamAlgorithmChoice)->SetDisplayText(kHPSS, "HPSS");
     GetParam(kParamAlgorithmChoice)->SetDisplayText(kNMF, "NMF");
     GetParam(kParamAlgorithmChoice)->SetDisplayText(kTransients, "Transients");
+    GetParam(kParamAlgorithmChoice)->SetDisplayText(kAmpSlice, "Amp Slice");
+    GetParam(kParamAlgorithmChoice)->SetDisplayText(kAmpGate, "Amp Gate");
+    GetParam(kParamAlgorithmChoice)->SetDisplayText(kSines, "Sines");
+    GetParam(kParamAlgorithmChoice)->SetDisplayText(kDescribe, "Describe");
 
     mNoveltyAlgorithm = std::make_unique<NoveltySliceAlgorithm>(this);
     mNoveltyAlgorithm->RegisterParameters();
@@ -102,12 +202,32 @@ ReacomaExtension::ReacomaExtension(reaper_plugin_info_t *pRec)
     mTransientSliceAlgorithm = std::make_unique<TransientSliceAlgorithm>(this);
     mTransientSliceAlgorithm->RegisterParameters();
 
+    mAmpSliceAlgorithm = std::make_unique<AmpSliceAlgorithm>(this);
+    mAmpSliceAlgorithm->RegisterParameters();
+
+    mAmpGateAlgorithm = std::make_unique<AmpGateAlgorithm>(this);
+    mAmpGateAlgorithm->RegisterParameters();
+
+    mSinesAlgorithm = std::make_unique<SinesAlgorithm>(this);
+    mSinesAlgorithm->RegisterParameters();
+
+    mDescriptorAlgorithm = std::make_unique<DescriptorAlgorithm>(this);
+    mDescriptorAlgorithm->RegisterParameters();
+
     SetAlgorithmChoice(kNoveltySlice, false);
 
     mLayoutFunc = [&](IGraphics *pGraphics) { SetupUI(pGraphics); };
 }
 
-void ReacomaExtension::OnUIClose() { mGUIToggle = 0; }
+void ReacomaExtension::OnUIClose() {
+    mGUIToggle = 0;
+    // The controls go with the window; processing carries on without them.
+    mProgressBar = nullptr;
+    mCancelButton = nullptr;
+    mSliceMapControl = nullptr;
+    mLiveNMFButton = nullptr;
+    mUIShowsBusy = false;
+}
 
 void ReacomaExtension::SetupUI(IGraphics *pGraphics) {
     const IRECT bounds = pGraphics->GetBounds();
@@ -123,6 +243,9 @@ void ReacomaExtension::SetupUI(IGraphics *pGraphics) {
     pGraphics->RemoveAllControls();
     mProgressBar = nullptr;
     mCancelButton = nullptr;
+    mSliceMapControl = nullptr;
+    mLiveNMFButton = nullptr;
+    mUIShowsBusy = false;
 
     pGraphics->EnableMouseOver(true);
     pGraphics->LoadFont("ibmplex", (void *)IBMPLEXMONO, IBMPLEXMONO_length);
@@ -179,6 +302,7 @@ void ReacomaExtension::SetupUI(IGraphics *pGraphics) {
         return;
     }
 
+    const IRECT parameterArea = currentLayoutBounds;
     int numAlgoParams = mCurrentActiveAlgorithmPtr->GetNumAlgorithmParams();
     for (int i = 0; i < numAlgoParams; ++i) {
         if (currentLayoutBounds.H() < controlVisualHeight)
@@ -215,6 +339,7 @@ void ReacomaExtension::SetupUI(IGraphics *pGraphics) {
 
         currentLayoutBounds.T = controlCellRect.B + verticalSpacing;
     }
+    SyncParamControls();
 
     struct ButtonInfo {
         IActionFunction function;
@@ -229,10 +354,36 @@ void ReacomaExtension::SetupUI(IGraphics *pGraphics) {
     if (mCurrentActiveAlgorithmPtr->SupportsRegions()) {
         buttonsToCreate.push_back({ProcessAction<Mode::Segment>{}, "Regions"});
     }
+    if (mCurrentActiveAlgorithmPtr->SupportsSegmentation()) {
+        buttonsToCreate.push_back(
+            {[this](IControl *pCaller) { CompareSlicers(); }, "Compare"});
+    }
     if (mCurrentActiveAlgorithmPtr->CreatesTakes()) {
         buttonsToCreate.push_back(
             {ProcessAction<Mode::ProcessAudio>{}, "Process"});
     }
+    if (mCurrentAlgorithmChoice == kAmpGate) {
+        buttonsToCreate.push_back({ProcessAction<Mode::Segment>{}, "Gate"});
+    }
+    if (mCurrentAlgorithmChoice == kDescribe) {
+        buttonsToCreate.push_back({ProcessAction<Mode::Segment>{}, "Describe"});
+        buttonsToCreate.push_back(
+            {[this](IControl *pCaller) { ToggleSliceMap(); }, "Map"});
+        buttonsToCreate.push_back(
+            {[this](IControl *pCaller) { ClusterSlices(); }, "Cluster"});
+
+        // Laid over the parameters while shown.
+        mSliceMapControl = new ReacomaSliceMap(
+            parameterArea, [this](int point) { PickMappedSlice(point); });
+        pGraphics->AttachControl(mSliceMapControl);
+        mSliceMapControl->Hide(!mShowSliceMap);
+        UpdateSliceMapControl();
+    }
+
+    if (mCurrentAlgorithmChoice == kNMF) {
+        buttonsToCreate.push_back(
+            {[this](IControl *pCaller) { ToggleLiveNMF(); }, "Live"});
+    }
 
     const long numActionButtons = buttonsToCreate.size();
     if (numActionButtons > 0) {
@@ -242,10 +393,15 @@ void ReacomaExtension::SetupUI(IGraphics *pGraphics) {
                 actionButtonRowBounds
                     .GetGridCell(0, i, 1, static_cast<int>(numActionButtons))
                     .GetHPadded(buttonPadding);
-            pGraphics->AttachControl(
-                new ReacomaButton(b, buttonInfo.label, buttonInfo.function));
+            auto *button =
+                new ReacomaButton(b, buttonInfo.label, buttonInfo.function);
+            pGraphics->AttachControl(button);
+            if (mCurrentAlgorithmChoice == kNMF && i == numActionButtons - 1)
+                mLiveNMFButton = button;
         }
     }
+    mLiveNMFLabel.clear();
+    SyncLiveNMF();
 
     const float cancelButtonWidth = 80.f;
     const float padding = 5.f;
@@ -266,184 +422,391 @@ void ReacomaExtension::SetupUI(IGraphics *pGraphics) {
 }
 
 void ReacomaExtension::Process(Mode mode, bool force) {
-    mCurrentProcessingMode = mode;
-    auto cores = std::thread::hardware_concurrency();
-    mConcurrencyLimit = std::min(4U, cores);
+    if (mCurrentActiveAlgorithmPtr == nullptr)
+        return;
 
-    mPendingItemsQueue.clear();
+    ProcessAlgorithm(mCurrentAlgorithmChoice, mode);
+}
+
+// Runs with the parameters currently set for the algorithm, whichever one
+// the UI shows, and without needing the UI to be open.
+void ReacomaExtension::ProcessAlgorithm(EAlgorithmChoice choice, Mode mode) {
+    SubmitBatch("Reacoma: Process Batch",
+                [this, choice](const std::vector<MediaItem *> &items) {
+                    return ProcessingJob::Create(choice, items, this);
+                });
+}
+
+void ReacomaExtension::ProcessPipeline(const PipelineDefinition &pipeline) {
+    SubmitBatch(pipeline.name,
+                [this, &pipeline](const std::vector<MediaItem *> &items) {
+                    return ProcessingJob::CreatePipeline(pipeline, items, this);
+                });
+}
 
+void ReacomaExtension::CompareSlicers() {
+    SubmitBatch("Reacoma: Compare slicers",
+                [this](const std::vector<MediaItem *> &items) {
+                    return ProcessingJob::CreateComparison(items, this);
+                });
+}
+
+// Searches the described slices of the selected items and razor-selects the
+// closest ones, leaving the item selection alone so that the cursor can be
+// moved on and the search repeated.
+void ReacomaExtension::SelectSimilarSlices() {
+    std::vector<MediaItem *> selectedItems;
     for (int i = 0; i < CountSelectedMediaItems(0); ++i) {
-        mPendingItemsQueue.push_back(GetSelectedMediaItem(0, i));
+        selectedItems.push_back(GetSelectedMediaItem(0, i));
     }
 
-    mTotalBatchItems = mPendingItemsQueue.size();
+    const std::string signature = SliceCorpus::SignatureFor(selectedItems);
+    if (signature != mSimilaritySignature) {
+        mSimilarityCorpus = SliceCorpus::ForItems(selectedItems);
+        mSimilarityIndex.Build(mSimilarityCorpus.descriptors);
+        mSimilaritySignature = signature;
+    }
 
-    if (mPendingItemsQueue.empty() || mCurrentActiveAlgorithmPtr == nullptr) {
+    const int slice = mSimilarityCorpus.FindSliceAt(GetCursorPosition());
+    if (slice < 0 || mSimilarityIndex.IsEmpty())
         return;
-    }
 
-    mIsProcessingBatch = true;
-    mIsCancellationRequested = false;
-    mLastReportedProgress = 0.0;
-    mActiveJobs.clear();
-    mFinalizationQueue.clear();
+    const auto count =
+        static_cast<fluid::index>(mDescriptorAlgorithm->GetParamValue(
+            DescriptorAlgorithm::kNumNeighbours));
+    Undo_BeginBlock2(nullptr);
+    mSimilarityCorpus.Select(mSimilarityIndex.Nearest(slice, count));
+    Undo_EndBlock2(nullptr, "Reacoma: Select similar slices", -1);
+    UpdateArrange();
+}
 
-    if (mProgressBar) {
-        mProgressBar->SetProgress(0.0);
-        mProgressBar->SetDisabled(false);
-    }
-    if (mCancelButton) {
-        mCancelButton->SetDisabled(false);
+// Maps the described slices of the selected items and shows the map in the
+// window.
+void ReacomaExtension::MapSlices() {
+    mMapItems.clear();
+    for (int i = 0; i < CountSelectedMediaItems(0); ++i) {
+        mMapItems.push_back(GetSelectedMediaItem(0, i));
     }
+    // Forces the next refresh to look at the new items.
+    mMapStateCount = -1;
+    ShowSliceMap(true);
+}
 
-    if (GetUI()) {
-        IGraphics *pGraphics = GetUI();
-        for (int i = 0; i < pGraphics->NControls(); ++i) {
-            IControl *pControl = pGraphics->GetControl(i);
-            if (pControl && pControl != mProgressBar &&
-                pControl != mCancelButton) {
-                pControl->SetDisabled(true);
-            }
-        }
+void ReacomaExtension::ToggleSliceMap() {
+    if (mShowSliceMap) {
+        ShowSliceMap(false);
+    } else {
+        MapSlices();
     }
+}
 
-    mBatchUndoProject = GetItemProjectContext(mPendingItemsQueue.front());
-    Undo_BeginBlock2(mBatchUndoProject);
+void ReacomaExtension::ShowSliceMap(bool show) {
+    mShowSliceMap = show;
+    if (mSliceMapControl)
+        mSliceMapControl->Hide(!show);
 }
 
-void ReacomaExtension::OnParamChangeUI(int paramIdx, EParamSource source) {
-    if (paramIdx == kParamAlgorithmChoice) {
-        int selectedAlgoChoiceInt = GetParam(paramIdx)->Int();
-        EAlgorithmChoice selectedAlgo =
-            static_cast<EAlgorithmChoice>(selectedAlgoChoiceInt);
+// Maps the slices again only when the items have been moved, trimmed,
+// deleted or described again. The items are only looked at when the project
+// has changed, and their tables, which can be rewritten from outside REAPER,
+// a few times a second. Reading the tables and projecting the slices happen
+// on a worker; a table is read again only once its file has been rewritten.
+void ReacomaExtension::RefreshSliceMap() {
+    if (mMapTask.valid())
+        return;
 
-        if (selectedAlgo != mCurrentAlgorithmChoice) {
-            SetAlgorithmChoice(selectedAlgo, true);
-        }
+    const int stateCount = GetProjectStateChangeCount(nullptr);
+    const auto now = std::chrono::steady_clock::now();
+    const bool projectChanged = stateCount != mMapStateCount;
+    if (!projectChanged && now - mMapCheckTime < kMapTableCheckInterval)
+        return;
+    mMapStateCount = stateCount;
+    mMapCheckTime = now;
+
+    bool placementsChanged = false;
+    if (projectChanged) {
+        mMapItems.erase(
+            std::remove_if(mMapItems.begin(), mMapItems.end(),
+                           [](MediaItem *item) {
+                               return !ValidatePtr2(nullptr, item,
+                                                    "MediaItem*");
+                           }),
+            mMapItems.end());
+        std::vector<SliceCorpus::Placement> placements =
+            SliceCorpus::PlacementsFor(mMapItems);
+        placementsChanged = placements != mMapPlacements;
+        mMapPlacements = std::move(placements);
     }
+
+    // The worker has the tables and the map to itself until it is done.
+    mMapTask = std::async(
+        std::launch::async,
+        [this, placements = mMapPlacements,
+         placementsChanged]() -> std::optional<SliceCorpus> {
+            const bool tablesChanged =
+                SliceCorpus::LoadTables(placements, mMapTables);
+            if (!tablesChanged && !placementsChanged)
+                return std::nullopt;
+
+            SliceCorpus corpus =
+                SliceCorpus::FromPlacements(placements, mMapTables);
+            mSliceMap.Update(corpus);
+            return corpus;
+        });
 }
 
-void ReacomaExtension::OnIdle() {
-    if (!mIsProcessingBatch) {
+void ReacomaExtension::ApplySliceMap() {
+    std::optional<SliceCorpus> corpus = mMapTask.get();
+    if (!corpus)
         return;
-    }
 
-    if (mIsCancellationRequested) {
-        for (auto &job : mActiveJobs) {
-            job->Cancel();
-            SetMediaItemInfo_Value(job->mItem, "C_LOCK", false);
-        }
+    mMapCorpus = std::move(*corpus);
+    mMapPoints = mSliceMap.GetPoints();
+    UpdateSliceMapControl();
+}
 
-        mPendingItemsQueue.clear();
-        mActiveJobs.clear();
-        mFinalizationQueue.clear();
+void ReacomaExtension::UpdateSliceMapControl() {
+    if (!mSliceMapControl)
+        return;
 
-        mIsProcessingBatch = false;
-        mIsCancellationRequested = false;
+    std::vector<IVec2> points;
+    points.reserve(mMapPoints.size());
+    for (const SliceMap::Point &point : mMapPoints) {
+        points.emplace_back(point.x, point.y);
+    }
+    mSliceMapControl->SetPoints(std::move(points));
+}
+
+// Selects the item of a slice picked on the map and puts the edit cursor at
+// its start, where the similarity search picks it up.
+void ReacomaExtension::PickMappedSlice(int point) {
+    if (point < 0 || point >= static_cast<int>(mMapCorpus.slices.size()))
+        return;
+
+    const SliceCorpus::Slice &slice = mMapCorpus.slices[point];
+    if (!ValidatePtr2(nullptr, slice.item, "MediaItem*"))
+        return;
 
-        Undo_EndBlock2(mBatchUndoProject, "Reacoma: Batch Process Cancelled",
-                       -1);
-        mBatchUndoProject = nullptr;
+    SelectAllMediaItems(nullptr, false);
+    SetMediaItemSelected(slice.item, true);
+    SetEditCurPos(slice.position, true, false);
+    UpdateArrange();
+}
 
-        ResetUIState();
-        UpdateArrange();
-        UpdateTimeline();
+// Starts clustering the described slices of the selected items. Their
+// colours are written in one pass from OnIdle once the task is done.
+void ReacomaExtension::ClusterSlices() {
+    if (mClusterTask.valid())
         return;
+
+    std::vector<MediaItem *> selectedItems;
+    for (int i = 0; i < CountSelectedMediaItems(0); ++i) {
+        selectedItems.push_back(GetSelectedMediaItem(0, i));
     }
+    mClusterCorpus = SliceCorpus::ForItems(selectedItems);
+    if (mClusterCorpus.slices.empty())
+        return;
 
-    for (auto it = mActiveJobs.begin(); it != mActiveJobs.end();) {
-        if ((*it)->IsFinished()) {
-            mFinalizationQueue.push_back(std::move(*it));
-            it = mActiveJobs.erase(it);
-        } else {
-            ++it;
-        }
+    const int numClusters = static_cast<int>(
+        mDescriptorAlgorithm->GetParamValue(DescriptorAlgorithm::kNumClusters));
+    mClusterTask = std::async(std::launch::async, [this, numClusters]() {
+        return SliceClusters::Assign(mClusterCorpus.descriptors, numClusters);
+    });
+}
+
+void ReacomaExtension::ApplySliceClusters() {
+    const std::vector<int> clusters = mClusterTask.get();
+    Undo_BeginBlock2(nullptr);
+    PreventUIRefresh(1);
+    SliceClusters::Apply(mClusterCorpus, clusters);
+    PreventUIRefresh(-1);
+    Undo_EndBlock2(nullptr, "Reacoma: Colour items by slice cluster", -1);
+    UpdateArrange();
+    mClusterCorpus = SliceCorpus{};
+}
+
+// Filters the hardware output with the bases stored by the last NMF run in
+// Store mode, keeping the chosen component.
+void ReacomaExtension::ToggleLiveNMF() {
+    if (mPlaybackNMF.IsRunning()) {
+        mPlaybackNMF.Stop();
+    } else if (!mNMFBases.IsEmpty()) {
+        SyncLiveNMF();
+        mPlaybackNMF.Start(mNMFBases);
+        mLiveNMFGeneration = mNMFBases.generation;
     }
+    mLiveNMFToggle = mPlaybackNMF.IsRunning();
+    SyncLiveNMF();
+}
 
-    while (mActiveJobs.size() < mConcurrencyLimit &&
-           !mPendingItemsQueue.empty()) {
-        MediaItem *itemToProcess = mPendingItemsQueue.front();
-        mPendingItemsQueue.pop_front();
+// Passes the live parameters to the audio thread and shows its load.
+void ReacomaExtension::SyncLiveNMF() {
+    mPlaybackNMF.Tick();
+    mPlaybackNMF.SetComponent(
+        static_cast<int>(
+            mNMFAlgorithm->GetParamValue(NMFAlgorithm::kLiveComponent)) -
+        1);
+    mPlaybackNMF.SetIterations(static_cast<int>(
+        mNMFAlgorithm->GetParamValue(NMFAlgorithm::kLiveIterations)));
+
+    mLiveNMFHasBases = !mNMFBases.IsEmpty();
+    if (!mLiveNMFButton)
+        return;
 
-        auto job =
-            ProcessingJob::Create(mCurrentAlgorithmChoice, itemToProcess, this);
-        if (job) {
-            job->Start();
-            mActiveJobs.push_back(std::move(job));
-        }
+    char label[64] = "Live";
+    if (mPlaybackNMF.IsRunning() && !mPlaybackNMF.RateMatches()) {
+        snprintf(label, sizeof(label), "Live (sample rate differs)");
+    } else if (mPlaybackNMF.IsRunning()) {
+        snprintf(label, sizeof(label), "Live %.1f%%",
+                 mPlaybackNMF.GetLoad() * 100.0);
+    } else if (!mLiveNMFHasBases) {
+        snprintf(label, sizeof(label), "Live (store bases first)");
+    }
+    if (mLiveNMFLabel != label) {
+        mLiveNMFLabel = label;
+        mLiveNMFButton->SetLabel(label);
+    }
+}
+
+void ReacomaExtension::SubmitBatch(const std::string &undoName,
+                                   ProcessingService::JobFactory jobFactory) {
+    std::vector<MediaItem *> selectedItems;
+    for (int i = 0; i < CountSelectedMediaItems(0); ++i) {
+        selectedItems.push_back(GetSelectedMediaItem(0, i));
     }
 
-    if (!mFinalizationQueue.empty()) {
-        auto &finishedJob = mFinalizationQueue.front();
-        finishedJob->Finalize();
-        mFinalizationQueue.pop_front();
+    if (mProcessingService->Submit(undoName, selectedItems,
+                                   std::move(jobFactory))) {
+        SyncUIState();
     }
+}
 
-    if (mProgressBar && mTotalBatchItems > 0) {
-        double totalProgressUnits = 0.0;
+void ReacomaExtension::OnParamChangeUI(int paramIdx, EParamSource source) {
+    if (paramIdx == kParamAlgorithmChoice) {
+        int selectedAlgoChoiceInt = GetParam(paramIdx)->Int();
+        EAlgorithmChoice selectedAlgo =
+            static_cast<EAlgorithmChoice>(selectedAlgoChoiceInt);
 
-        for (const auto &job : mActiveJobs) {
-            totalProgressUnits += job->GetProgress();
+        if (selectedAlgo != mCurrentAlgorithmChoice) {
+            SetAlgorithmChoice(selectedAlgo, true);
         }
+    } else {
+        SyncParamControls();
+    }
+}
 
-        size_t completedJobs =
-            mTotalBatchItems - mPendingItemsQueue.size() - mActiveJobs.size();
-        totalProgressUnits += static_cast<double>(completedJobs);
+void ReacomaExtension::OnIdle() {
+    mProcessingService->Tick();
+    SyncUIState();
+    if (mSliceMapControl && mShowSliceMap)
+        RefreshSliceMap();
+    if (mMapTask.valid() &&
+        mMapTask.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready)
+        ApplySliceMap();
+    // A Store run while playing swaps the new bases in.
+    if (mPlaybackNMF.IsRunning() &&
+        mNMFBases.generation != mLiveNMFGeneration) {
+        mPlaybackNMF.Start(mNMFBases);
+        mLiveNMFGeneration = mNMFBases.generation;
+    }
+    // Stopped, the label only changes when a Store run leaves bases.
+    if (mPlaybackNMF.IsRunning() ||
+        mLiveNMFHasBases == mNMFBases.IsEmpty())
+        SyncLiveNMF();
+    if (mClusterTask.valid() &&
+        mClusterTask.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready)
+        ApplySliceClusters();
+}
 
-        double overallProgress = totalProgressUnits / mTotalBatchItems;
-        if (overallProgress > mLastReportedProgress) {
-            mLastReportedProgress = overallProgress;
+void ReacomaExtension::SyncUIState() {
+    if (!GetUI())
+        return;
+
+    const bool busy = mProcessingService->IsBusy();
+    if (busy != mUIShowsBusy) {
+        mUIShowsBusy = busy;
+        if (busy) {
+            ShowBusyUIState();
+        } else {
+            ResetUIState();
         }
-        mProgressBar->SetProgress(mLastReportedProgress);
     }
 
-    if (mPendingItemsQueue.empty() && mActiveJobs.empty() &&
-        mFinalizationQueue.empty()) {
-        mIsProcessingBatch = false;
-        Undo_EndBlock2(mBatchUndoProject, "Reacoma: Process Batch", -1);
-        mBatchUndoProject = nullptr;
-
-        ResetUIState();
-        UpdateArrange();
-        UpdateTimeline();
+    if (busy && mProgressBar) {
+        mProgressBar->SetProgress(mProcessingService->GetProgress());
+        mProgressBar->SetRemainingSeconds(
+            mProcessingService->GetRemainingSeconds());
     }
 }
 
 void ReacomaExtension::SetAlgorithmChoice(EAlgorithmChoice choice,
                                           bool triggerUIRelayout) {
     mCurrentAlgorithmChoice = choice;
+    mCurrentActiveAlgorithmPtr = GetAlgorithm(choice);
+}
+
+SliceOutput ReacomaExtension::GetSliceOutput() const {
+    SliceOutput output;
+    output.takeMarkers = mWriteTakeMarkers != 0;
+    output.sidecar = mWriteSliceSidecars != 0;
+    output.sidecarJson = mWriteSliceSidecarJson != 0;
+    output.curveRate = mWriteSliceCurves ? kSliceCurveRate : 0.0;
+    return output;
+}
+
+IAlgorithm *ReacomaExtension::GetAlgorithm(EAlgorithmChoice choice) const {
     switch (choice) {
     case kNoveltySlice:
-        mCurrentActiveAlgorithmPtr = mNoveltyAlgorithm.get();
-        break;
+        return mNoveltyAlgorithm.get();
     case kHPSS:
-        mCurrentActiveAlgorithmPtr = mHPSSAlgorithm.get();
-        break;
+        return mHPSSAlgorithm.get();
     case kNMF:
-        mCurrentActiveAlgorithmPtr = mNMFAlgorithm.get();
-        break;
+        return mNMFAlgorithm.get();
     case kOnsetSlice:
-        mCurrentActiveAlgorithmPtr = mOnsetSliceAlgorithm.get();
-        break;
+        return mOnsetSliceAlgorithm.get();
     case kTransientSlice:
-        mCurrentActiveAlgorithmPtr = mTransientSliceAlgorithm.get();
-        break;
+        return mTransientSliceAlgorithm.get();
+    case kAmpSlice:
+        return mAmpSliceAlgorithm.get();
+    case kAmpGate:
+        return mAmpGateAlgorithm.get();
     case kTransients:
-        mCurrentActiveAlgorithmPtr = mTransientsAlgorithm.get();
-        break;
+        return mTransientsAlgorithm.get();
+    case kSines:
+        return mSinesAlgorithm.get();
+    case kDescribe:
+        return mDescriptorAlgorithm.get();
     default:
-        mCurrentActiveAlgorithmPtr = nullptr;
-        break;
+        return nullptr;
     }
 }
 
 void ReacomaExtension::CancelRunningJobs() {
-    if (mIsProcessingBatch) {
-        mIsCancellationRequested = true;
-        if (mCancelButton) {
-            mCancelButton->SetDisabled(true);
+    mProcessingService->CancelAll();
+    SyncUIState();
+}
+
+void ReacomaExtension::ShowBusyUIState() {
+    if (GetUI()) {
+        IGraphics *pGraphics = GetUI();
+        for (int i = 0; i < pGraphics->NControls(); ++i) {
+            IControl *pControl = pGraphics->GetControl(i);
+            if (pControl && pControl != mProgressBar &&
+                pControl != mCancelButton) {
+                pControl->SetDisabled(true);
+            }
         }
     }
+
+    if (mProgressBar) {
+        mProgressBar->SetProgress(0.0);
+        mProgressBar->SetDisabled(false);
+    }
+    if (mCancelButton) {
+        mCancelButton->SetDisabled(false);
+    }
 }
 
 void ReacomaExtension::ResetUIState() {
@@ -460,9 +823,31 @@ void ReacomaExtension::ResetUIState() {
     if (mProgressBar) {
         mProgressBar->SetDisabled(true);
         mProgressBar->SetProgress(0.0);
+        mProgressBar->SetRemainingSeconds(-1.0);
     }
 
     if (mCancelButton) {
         mCancelButton->SetDisabled(true);
     }
+    SyncParamControls();
+}
+
+// Disables the controls of parameters that have no effect with the others
+// as they are set.
+void ReacomaExtension::SyncParamControls() {
+    IGraphics *pGraphics = GetUI();
+    if (!pGraphics || !mCurrentActiveAlgorithmPtr ||
+        mProcessingService->IsBusy())
+        return;
+
+    IAlgorithm *algorithm = mCurrentActiveAlgorithmPtr;
+    const int firstParam = algorithm->GetGlobalParamIdx(0);
+    const int numParams = algorithm->GetNumAlgorithmParams();
+    for (int i = 0; i < pGraphics->NControls(); ++i) {
+        IControl *pControl = pGraphics->GetControl(i);
+        const int param = pControl ? pControl->GetParamIdx() - firstParam : -1;
+        if (param >= 0 && param < numParams) {
+            pControl->SetDisabled(!algorithm->IsParamActive(param));
+        }
+    }
 }
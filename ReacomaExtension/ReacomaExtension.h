@@ -3,10 +3,12 @@
 #include "ReaperExt_include_in_plug_hdr.h"
 #include "reaper_plugin.h"
 
-#include <deque>
-#include <list>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
-#include <thread>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "ibmplexmono.hpp"
@@ -20,17 +22,31 @@
 #include "Components/ReacomaParamTextControl.h"
 #include "Components/ReacomaProgressBar.h"
 #include "Components/ReacomaSegmented.h"
+#include "Components/ReacomaSliceMap.h"
 #include "Components/ReacomaSlider.h"
 
+#include "Algorithms/AmpGateAlgorithm.h"
+#include "Algorithms/AmpSliceAlgorithm.h"
+#include "Algorithms/DescriptorAlgorithm.h"
 #include "Algorithms/HPSSAlgorithm.h"
 #include "Algorithms/NMFAlgorithm.h"
 #include "Algorithms/TransientAlgorithm.h"
 #include "Algorithms/TransientSliceAlgorithm.h"
 #include "Algorithms/NoveltySliceAlgorithm.h"
 #include "Algorithms/OnsetSliceAlgorithm.h"
+#include "Algorithms/PlaybackNMF.h"
+#include "Algorithms/ProcessingService.h"
+#include "Algorithms/SimilarityIndex.h"
+#include "Algorithms/SliceClusters.h"
+#include "Algorithms/SliceCorpus.h"
+#include "Algorithms/SinesAlgorithm.h"
+#include "Algorithms/SliceCache.h"
+#include "Algorithms/SliceMap.h"
+#include "Algorithms/Spectrogram.h"
 
 class IAlgorithm;
 class ProcessingJob;
+struct PipelineDefinition;
 class ReacomaProgressBar;
 
 using namespace iplug;
@@ -49,14 +65,28 @@ class ReacomaExtension : public ReaperExtBase {
         kHPSS,
         kNMF,
         kTransients,
+        // Appended so that saved choices keep their meaning.
+        kAmpSlice,
+        kAmpGate,
+        kSines,
+        kDescribe,
         kNumAlgorithmChoices
     };
 
     ReacomaExtension(reaper_plugin_info_t *pRec);
     void OnUIClose() override;
     void Process(Mode mode, bool force);
+    void ProcessAlgorithm(EAlgorithmChoice choice, Mode mode);
+    void ProcessPipeline(const PipelineDefinition &pipeline);
+    void CompareSlicers();
+    void SelectSimilarSlices();
+    void MapSlices();
+    void ClusterSlices();
+    void ToggleLiveNMF();
     void CancelRunningJobs();
+    void ShowBusyUIState();
     void ResetUIState();
+    void SyncParamControls();
 
     NoveltySliceAlgorithm *GetNoveltySliceAlgorithm() const {
         return mNoveltyAlgorithm.get();
@@ -72,6 +102,25 @@ class ReacomaExtension : public ReaperExtBase {
     OnsetSliceAlgorithm *GetOnsetSliceAlgorithm() const {
         return mOnsetSliceAlgorithm.get();
     }
+    AmpSliceAlgorithm *GetAmpSliceAlgorithm() const {
+        return mAmpSliceAlgorithm.get();
+    }
+    AmpGateAlgorithm *GetAmpGateAlgorithm() const {
+        return mAmpGateAlgorithm.get();
+    }
+    SinesAlgorithm *GetSinesAlgorithm() const {
+        return mSinesAlgorithm.get();
+    }
+    DescriptorAlgorithm *GetDescriptorAlgorithm() const {
+        return mDescriptorAlgorithm.get();
+    }
+    // The algorithm instances that own the parameters shown in the UI.
+    IAlgorithm *GetAlgorithm(EAlgorithmChoice choice) const;
+    SliceCache &GetSliceCache() { return mSliceCache; }
+    SliceOutput GetSliceOutput() const;
+    SpectrogramCache &GetSpectrogramCache() { return mSpectrogramCache; }
+    NMFBases &GetNMFBases() { return mNMFBases; }
+    ProcessingService &GetProcessingService() { return *mProcessingService; }
 
   private:
     std::unique_ptr<NoveltySliceAlgorithm> mNoveltyAlgorithm;
@@ -80,31 +129,77 @@ class ReacomaExtension : public ReaperExtBase {
     std::unique_ptr<TransientAlgorithm> mTransientsAlgorithm;
     std::unique_ptr<OnsetSliceAlgorithm> mOnsetSliceAlgorithm;
     std::unique_ptr<TransientSliceAlgorithm> mTransientSliceAlgorithm;
+    std::unique_ptr<AmpSliceAlgorithm> mAmpSliceAlgorithm;
+    std::unique_ptr<AmpGateAlgorithm> mAmpGateAlgorithm;
+    std::unique_ptr<SinesAlgorithm> mSinesAlgorithm;
+    std::unique_ptr<DescriptorAlgorithm> mDescriptorAlgorithm;
+    SliceCache mSliceCache;
+    SpectrogramCache mSpectrogramCache;
+    // Learned by NMF jobs storing their bases, read by jobs holding them
+    // fixed. Both happen on the main thread.
+    NMFBases mNMFBases;
+    PlaybackNMF mPlaybackNMF;
+    // Built from the descriptor tables of the selected items and kept until
+    // the items or their tables change.
+    SliceCorpus mSimilarityCorpus;
+    SimilarityIndex mSimilarityIndex;
+    std::string mSimilaritySignature;
+    // The map keeps to the items it was made from rather than following the
+    // selection, which picking a slice on it changes.
+    std::vector<MediaItem *> mMapItems;
+    SliceCorpus mMapCorpus;
+    std::vector<SliceMap::Point> mMapPoints;
+    std::vector<SliceCorpus::Placement> mMapPlacements;
+    int mMapStateCount = -1;
+    std::chrono::steady_clock::time_point mMapCheckTime;
+    // Used by the map's worker alone while it runs.
+    SliceCorpus::Tables mMapTables;
+    SliceMap mSliceMap;
+    std::future<std::optional<SliceCorpus>> mMapTask;
+    // Clustering runs as a task over a corpus that is left alone until its
+    // items have been coloured.
+    SliceCorpus mClusterCorpus;
+    std::future<std::vector<int>> mClusterTask;
+    // Declared last among the shared state so that its jobs are torn down
+    // before the caches they use.
+    std::unique_ptr<ProcessingService> mProcessingService;
 
     void OnParamChangeUI(int paramIdx, EParamSource source) override;
     void OnIdle() override;
     void SetAlgorithmChoice(EAlgorithmChoice choice, bool triggerUIRelayout);
     void SetupUI(IGraphics *pGraphics);
-    void StartNextItemInQueue();
+    void SyncUIState();
+    void ToggleSliceMap();
+    void ShowSliceMap(bool show);
+    void RefreshSliceMap();
+    void ApplySliceMap();
+    void UpdateSliceMapControl();
+    void PickMappedSlice(int point);
+    void ApplySliceClusters();
+    void SyncLiveNMF();
+
+    void SubmitBatch(const std::string &undoName,
+                     ProcessingService::JobFactory jobFactory);
 
     int mGUIToggle = 0;
+    int mWriteTakeMarkers = 1;
+    int mWriteSliceSidecars = 0;
+    int mWriteSliceSidecarJson = 0;
+    int mWriteSliceCurves = 0;
+    int mLiveNMFToggle = 0;
 
     IAlgorithm *mCurrentActiveAlgorithmPtr = nullptr;
     EAlgorithmChoice mCurrentAlgorithmChoice = kNoveltySlice;
-    Mode mCurrentProcessingMode;
-
-    unsigned int mConcurrencyLimit = 1;
-    std::deque<MediaItem *> mPendingItemsQueue;
-    std::list<std::unique_ptr<ProcessingJob>> mActiveJobs;
-    std::deque<std::unique_ptr<ProcessingJob>> mFinalizationQueue;
-    std::deque<MediaItem *> mProcessingQueue;
 
     ReacomaProgressBar *mProgressBar = nullptr;
     ReacomaButton *mCancelButton = nullptr;
-    size_t mTotalBatchItems = 0;
-    double mLastReportedProgress = 0.0;
-
-    ReaProject *mBatchUndoProject = nullptr;
-    bool mIsProcessingBatch = false;
-    bool mIsCancellationRequested = false;
+    ReacomaSliceMap *mSliceMapControl = nullptr;
+    ReacomaButton *mLiveNMFButton = nullptr;
+    std::string mLiveNMFLabel;
+    bool mLiveNMFHasBases = false;
+    // Generation of the bases live NMF was last started with.
+    int mLiveNMFGeneration = 0;
+    bool mShowSliceMap = false;
+    // Whether the controls currently show a running batch.
+    bool mUIShowsBusy = false;
 };
@@ -2,19 +2,21 @@
 
 namespace fluid {
 
-VectorBufferAdaptor::VectorBufferAdaptor(std::vector<float> &data,
+VectorBufferAdaptor::VectorBufferAdaptor(std::vector<float> data,
                                          index numChannels, index numFrames,
                                          double sampleRate)
-    : mData(data.data(), 0, numFrames, numChannels), mNumFrames(numFrames),
-      mNumChannels(numChannels), mSampleRate(sampleRate), mAcquired(false) {
+    : mStorage(std::move(data)),
+      mData(mStorage.data(), 0, numFrames, numChannels), mNumFrames(numFrames),
+      mNumChannels(numChannels), mSampleRate(sampleRate), mReaders(0) {
     // Initialize FluidTensorView in the initializer list instead of in the body
 }
 
 bool VectorBufferAdaptor::acquire() const {
-    return !mAcquired && (mAcquired = true);
+    ++mReaders;
+    return true;
 }
 
-void VectorBufferAdaptor::release() const { mAcquired = false; }
+void VectorBufferAdaptor::release() const { --mReaders; }
 
 bool VectorBufferAdaptor::valid() const { return numFrames() > 0; }
 
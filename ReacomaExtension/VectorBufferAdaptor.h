@@ -1,13 +1,16 @@
 #pragma once
 #include "../dependencies/flucoma-core/include/flucoma/clients/common/BufferAdaptor.hpp"
 #include "../dependencies/flucoma-core/include/flucoma/data/FluidTensor.hpp"
+#include <atomic>
 #include <vector>
 
 namespace fluid {
 
+// Read-only view over ingested samples. Any number of readers may hold it at
+// once, so one ingest can feed several algorithms running concurrently.
 class VectorBufferAdaptor : public client::BufferAdaptor {
   public:
-    VectorBufferAdaptor(std::vector<float> &data, index numChannels,
+    VectorBufferAdaptor(std::vector<float> data, index numChannels,
                         index numFrames, double sampleRate);
 
     bool acquire() const override;
@@ -37,11 +40,12 @@ class VectorBufferAdaptor : public client::BufferAdaptor {
     double sampleRate() const override;
 
   private:
+    std::vector<float> mStorage;
     FluidTensorView<float, 2> mData;
     index mNumFrames;
     index mNumChannels;
     double mSampleRate;
-    mutable bool mAcquired;
+    mutable std::atomic<int> mReaders;
 };
 
 } // namespace fluid